@@ -0,0 +1,440 @@
+#include "als.h"
+#include "logger.h"
+#include "simd_kernels.h"
+#include "tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace {
+    // Os 7 primeiros bytes identificam o formato; o último é a versão
+    const char kMagic[8] = {'C', 'I', 'N', 'E', 'A', 'L', 'S', '1'};
+    const size_t kMagicPrefix = 7;
+
+    // Limite de sanidade para o rank lido do arquivo (treino usa 32 por padrão)
+    const uint32_t kMaxRank = 1024;
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t rank;
+        uint32_t users;
+        uint32_t items;
+        uint32_t implicit;
+        float lambda;
+        float alpha;
+        float global_mean;
+        uint32_t reserved;
+    };
+
+    // Resolve A·x = b (A simétrica positiva definida, n×n) por Cholesky, in-place
+    bool choleskySolve(std::vector<float>& a, std::vector<float>& b, int n) {
+        for (int j = 0; j < n; j++) {
+            double diagonal = a[j * n + j];
+            for (int k = 0; k < j; k++) diagonal -= static_cast<double>(a[j * n + k]) * a[j * n + k];
+            if (diagonal <= 0.0) return false;
+            float l = static_cast<float>(std::sqrt(diagonal));
+            a[j * n + j] = l;
+            for (int i = j + 1; i < n; i++) {
+                double sum = a[i * n + j];
+                for (int k = 0; k < j; k++) sum -= static_cast<double>(a[i * n + k]) * a[j * n + k];
+                a[i * n + j] = static_cast<float>(sum / l);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            double sum = b[i];
+            for (int k = 0; k < i; k++) sum -= static_cast<double>(a[i * n + k]) * b[k];
+            b[i] = static_cast<float>(sum / a[i * n + i]);
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            double sum = b[i];
+            for (int k = i + 1; k < n; k++) sum -= static_cast<double>(a[k * n + i]) * b[k];
+            b[i] = static_cast<float>(sum / a[i * n + i]);
+        }
+        return true;
+    }
+
+    struct SolveBuffers {
+        std::vector<float> a;
+        std::vector<float> b;
+    };
+
+    // Uma linha do passo ALS: fatores ótimos para uma entidade dadas as
+    // avaliações (índices na outra matriz + valores) e os fatores fixos da outra.
+    // Se o sistema não for positivo definido, zera a linha e devolve false.
+    bool solveRow(const float* fixed, int rank, const int* indices, const float* values, size_t count,
+                  const std::vector<float>* gram, bool implicit, float lambda, float alpha, float mean,
+                  SolveBuffers& buffers, float* out) {
+        std::vector<float>& a = buffers.a;
+        std::vector<float>& b = buffers.b;
+
+        if (implicit && gram) {
+            a = *gram;
+        } else {
+            std::fill(a.begin(), a.end(), 0.0f);
+        }
+        std::fill(b.begin(), b.end(), 0.0f);
+
+        for (size_t k = 0; k < count; k++) {
+            const float* y = fixed + static_cast<size_t>(indices[k]) * rank;
+            float weight, target;
+            if (implicit) {
+                float confidence = 1.0f + alpha * values[k];
+                weight = confidence - 1.0f;
+                target = confidence;
+            } else {
+                weight = 1.0f;
+                target = values[k] - mean;
+            }
+            for (int r = 0; r < rank; r++) {
+                float wy = weight * y[r];
+                for (int c = 0; c <= r; c++) {
+                    a[r * rank + c] += wy * y[c];
+                }
+                b[r] += target * y[r];
+            }
+        }
+
+        // Regularização ponderada pelo número de avaliações no caso explícito
+        float regularization = implicit ? lambda : lambda * std::max<size_t>(count, 1);
+        for (int r = 0; r < rank; r++) {
+            a[r * rank + r] += regularization;
+            for (int c = r + 1; c < rank; c++) {
+                a[r * rank + c] = a[c * rank + r];
+            }
+        }
+
+        if (count == 0 && !implicit) {
+            std::fill(out, out + rank, 0.0f);
+            return true;
+        }
+        if (!choleskySolve(a, b, rank)) {
+            std::fill(out, out + rank, 0.0f);
+            return false;
+        }
+        std::copy(b.begin(), b.end(), out);
+        return true;
+    }
+
+    template <typename Fn>
+    void parallelFor(int count, int threads, Fn fn) {
+        std::atomic<int> next(0);
+        auto worker = [&]() {
+            SolveBuffers buffers;
+            for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                fn(i, buffers);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : workers) {
+            thread.join();
+        }
+    }
+
+    int indexOf(const std::vector<int>& sorted_ids, int id) {
+        auto it = std::lower_bound(sorted_ids.begin(), sorted_ids.end(), id);
+        return it != sorted_ids.end() && *it == id ? static_cast<int>(it - sorted_ids.begin()) : -1;
+    }
+}
+
+// ===== TREINAMENTO =====
+std::shared_ptr<ALSModel> ALSModel::train(const RatingsMatrix& matrix, const ALSOptions& options) {
+    TRACE_SPAN("als.train");
+    auto started = std::chrono::steady_clock::now();
+
+    std::shared_ptr<ALSModel> model(new ALSModel());
+    const int rank = std::max(1, options.rank);
+    const int users = static_cast<int>(matrix.userCount());
+    const int items = static_cast<int>(matrix.itemCount());
+
+    model->factors = rank;
+    model->implicit = options.implicit;
+    model->lambda = options.lambda;
+    model->alpha = options.alpha;
+    model->global_mean = options.implicit ? 0.0f : matrix.globalMean();
+
+    model->user_ids.resize(users);
+    for (int u = 0; u < users; u++) model->user_ids[u] = matrix.userId(u);
+    model->item_ids.resize(items);
+    for (int i = 0; i < items; i++) model->item_ids[i] = matrix.itemId(i);
+
+    std::mt19937 rng(options.seed);
+    std::normal_distribution<float> init(0.0f, 0.1f / std::sqrt(static_cast<float>(rank)));
+    model->user_factors.resize(static_cast<size_t>(users) * rank);
+    model->item_factors.resize(static_cast<size_t>(items) * rank);
+    for (auto& value : model->user_factors) value = init(rng);
+    for (auto& value : model->item_factors) value = init(rng);
+
+    int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, threads);
+
+    // Gram da matriz fixa (Yᵀ·Y ou Xᵀ·X): só o caso implícito precisa dele
+    auto gramOf = [rank](const std::vector<float>& factors, size_t rows) {
+        std::vector<float> gram(static_cast<size_t>(rank) * rank, 0.0f);
+        for (size_t row = 0; row < rows; row++) {
+            const float* v = &factors[row * rank];
+            for (int r = 0; r < rank; r++) {
+                for (int c = 0; c <= r; c++) gram[r * rank + c] += v[r] * v[c];
+            }
+        }
+        for (int r = 0; r < rank; r++) {
+            for (int c = r + 1; c < rank; c++) gram[r * rank + c] = gram[c * rank + r];
+        }
+        return gram;
+    };
+
+    auto prepare = [rank](SolveBuffers& buffers) {
+        if (buffers.a.size() != static_cast<size_t>(rank) * rank) {
+            buffers.a.resize(static_cast<size_t>(rank) * rank);
+            buffers.b.resize(rank);
+        }
+    };
+
+    for (int iteration = 0; iteration < options.iterations; iteration++) {
+        std::atomic<int> failed_users(0);
+        std::atomic<int> failed_items(0);
+        std::vector<float> gram;
+        if (options.implicit) gram = gramOf(model->item_factors, items);
+        parallelFor(users, threads, [&](int u, SolveBuffers& buffers) {
+            prepare(buffers);
+            uint32_t begin = matrix.rowBegin(u);
+            bool solved = solveRow(model->item_factors.data(), rank, &matrix.rowItems()[begin], &matrix.rowValues()[begin],
+                     matrix.rowEnd(u) - begin, options.implicit ? &gram : nullptr, options.implicit,
+                     options.lambda, options.alpha, model->global_mean, buffers,
+                     &model->user_factors[static_cast<size_t>(u) * rank]);
+            if (!solved) failed_users.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        if (options.implicit) gram = gramOf(model->user_factors, users);
+        parallelFor(items, threads, [&](int i, SolveBuffers& buffers) {
+            prepare(buffers);
+            uint32_t begin = matrix.colBegin(i);
+            bool solved = solveRow(model->user_factors.data(), rank, &matrix.colUsers()[begin], &matrix.colValues()[begin],
+                     matrix.colEnd(i) - begin, options.implicit ? &gram : nullptr, options.implicit,
+                     options.lambda, options.alpha, model->global_mean, buffers,
+                     &model->item_factors[static_cast<size_t>(i) * rank]);
+            if (!solved) failed_items.fetch_add(1, std::memory_order_relaxed);
+        });
+
+        if (failed_users.load() > 0 || failed_items.load() > 0) {
+            LOG_WARN("⚠️ ALS iteração %d: Cholesky falhou para %d usuários e %d filmes (fatores zerados)",
+                     iteration + 1, failed_users.load(), failed_items.load());
+        }
+    }
+
+    model->computeItemGram();
+    model->buildItemAnn();
+    model->training_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    LOG_INFO("🧮 ALS treinado: %d usuários, %d filmes, rank %d, %d iterações, %s, em %.2f s (%d threads)",
+             users, items, rank, options.iterations, options.implicit ? "implícito" : "explícito",
+             model->training_seconds, threads);
+    return model;
+}
+
+void ALSModel::computeItemGram() {
+    item_gram.assign(static_cast<size_t>(factors) * factors, 0.0f);
+    for (size_t row = 0; row < item_ids.size(); row++) {
+        const float* v = &item_factors[row * factors];
+        for (int r = 0; r < factors; r++) {
+            for (int c = 0; c < factors; c++) item_gram[r * factors + c] += v[r] * v[c];
+        }
+    }
+}
+
+void ALSModel::buildItemAnn() {
+    if (item_ids.size() < kAnnMinItems) return;
+
+    HnswOptions options;
+    options.metric = VectorMetric::InnerProduct;
+    item_ann = std::make_shared<HnswIndex>(factors, options);
+    item_ann->build(item_ids, item_factors);
+}
+
+int ALSModel::itemIndex(int movie_id) const {
+    return indexOf(item_ids, movie_id);
+}
+
+int ALSModel::userIndex(int user_id) const {
+    return indexOf(user_ids, user_id);
+}
+
+// ===== PONTUAÇÃO =====
+std::vector<ScoredMovie> ALSModel::recommend(const std::vector<Rating>& user_ratings, size_t limit) const {
+    TRACE_SPAN("als.recommend");
+    std::vector<int> indices;
+    std::vector<float> values;
+    for (const auto& rating : user_ratings) {
+        int item = itemIndex(rating.movie_id);
+        if (item < 0) continue;
+        indices.push_back(item);
+        values.push_back(static_cast<float>(rating.rating));
+    }
+    if (indices.empty()) return {};
+
+    SolveBuffers buffers;
+    buffers.a.resize(static_cast<size_t>(factors) * factors);
+    buffers.b.resize(factors);
+    std::vector<float> user_vector(factors, 0.0f);
+    solveRow(item_factors.data(), factors, indices.data(), values.data(), indices.size(),
+             &item_gram, implicit, lambda, alpha, global_mean, buffers, user_vector.data());
+
+    if (item_ann) {
+        // Busca aproximada: pede vizinhos extras para compensar os já vistos
+        std::vector<int> seen;
+        for (int item : indices) seen.push_back(item_ids[item]);
+        std::sort(seen.begin(), seen.end());
+
+        std::vector<ScoredMovie> result;
+        for (const auto& candidate : item_ann->search(user_vector.data(), limit + seen.size())) {
+            if (std::binary_search(seen.begin(), seen.end(), candidate.movie_id)) continue;
+            result.push_back({candidate.movie_id, candidate.score + global_mean});
+            if (result.size() == limit) break;
+        }
+        return result;
+    }
+
+    return topK(user_vector.data(), indices, limit);
+}
+
+std::vector<ScoredMovie> ALSModel::topK(const float* user_vector, const std::vector<int>& exclude_items, size_t limit) const {
+    ScoringScratch scratch;
+    return topK(user_vector, exclude_items, limit, scratch);
+}
+
+std::vector<ScoredMovie> ALSModel::topK(const float* user_vector, const std::vector<int>& exclude_items,
+                                        size_t limit, ScoringScratch& scratch) const {
+    const size_t items = item_ids.size();
+    if (scratch.scores.size() != items) {
+        scratch.scores.resize(items);
+        scratch.excluded.resize(items);
+    }
+
+    for (int item : exclude_items) {
+        if (item >= 0 && static_cast<size_t>(item) < items) scratch.excluded.set(item);
+    }
+
+    scoringKernels().dotBatch(user_vector, item_factors.data(), items, factors, scratch.scores.data());
+
+    std::vector<ScoredMovie> result;
+    for (const ScoredIndex& best : topKScores(scratch.scores.data(), items, limit, &scratch.excluded)) {
+        result.push_back({item_ids[best.index], best.score + global_mean});
+    }
+
+    // Limpa só os bits usados, para o próximo usuário da mesma thread
+    for (int item : exclude_items) {
+        if (item >= 0 && static_cast<size_t>(item) < items) scratch.excluded.clear(item);
+    }
+    return result;
+}
+
+// ===== PERSISTÊNCIA =====
+bool ALSModel::save(const std::string& path) const {
+    std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("❌ Não foi possível gravar o modelo ALS em %s", path.c_str());
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.rank = factors;
+    header.users = static_cast<uint32_t>(user_ids.size());
+    header.items = static_cast<uint32_t>(item_ids.size());
+    header.implicit = implicit ? 1 : 0;
+    header.lambda = lambda;
+    header.alpha = alpha;
+    header.global_mean = global_mean;
+
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(user_ids.data(), sizeof(int), user_ids.size(), file) == user_ids.size() &&
+              std::fwrite(item_ids.data(), sizeof(int), item_ids.size(), file) == item_ids.size() &&
+              std::fwrite(user_factors.data(), sizeof(float), user_factors.size(), file) == user_factors.size() &&
+              std::fwrite(item_factors.data(), sizeof(float), item_factors.size(), file) == item_factors.size();
+    ok = std::fclose(file) == 0 && ok;
+
+    // Troca atômica: quem carregar o arquivo nunca vê um modelo pela metade
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        LOG_ERROR("❌ Falha ao gravar o modelo ALS em %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<ALSModel> ALSModel::load(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return nullptr;
+
+    long file_size = -1;
+    if (std::fseek(file, 0, SEEK_END) == 0) file_size = std::ftell(file);
+    std::rewind(file);
+
+    FileHeader header;
+    if (file_size < static_cast<long>(sizeof(header)) || std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, kMagic, kMagicPrefix) != 0) {
+        std::fclose(file);
+        LOG_WARN("⚠️ Arquivo de modelo ALS inválido: %s", path.c_str());
+        return nullptr;
+    }
+    if (header.magic[kMagicPrefix] != kMagic[kMagicPrefix]) {
+        std::fclose(file);
+        LOG_WARN("⚠️ Modelo ALS em %s tem versão '%c' (esperada '%c'); ignorando",
+                 path.c_str(), header.magic[kMagicPrefix], kMagic[kMagicPrefix]);
+        return nullptr;
+    }
+
+    // O tamanho do arquivo tem que bater exatamente com o cabeçalho antes de
+    // alocar qualquer coisa: um cabeçalho corrompido não vira um resize gigante
+    uint64_t rows = static_cast<uint64_t>(header.users) + header.items;
+    uint64_t expected = sizeof(header) + rows * sizeof(int) + rows * header.rank * sizeof(float);
+    if (header.rank == 0 || header.rank > kMaxRank || expected != static_cast<uint64_t>(file_size)) {
+        std::fclose(file);
+        LOG_WARN("⚠️ Arquivo de modelo ALS truncado ou corrompido: %s (rank %u, %u usuários, %u filmes, %ld bytes)",
+                 path.c_str(), header.rank, header.users, header.items, file_size);
+        return nullptr;
+    }
+
+    std::shared_ptr<ALSModel> model(new ALSModel());
+    model->factors = static_cast<int>(header.rank);
+    model->implicit = header.implicit != 0;
+    model->lambda = header.lambda;
+    model->alpha = header.alpha;
+    model->global_mean = header.global_mean;
+    model->user_ids.resize(header.users);
+    model->item_ids.resize(header.items);
+    model->user_factors.resize(static_cast<size_t>(header.users) * header.rank);
+    model->item_factors.resize(static_cast<size_t>(header.items) * header.rank);
+    bool ok = std::fread(model->user_ids.data(), sizeof(int), header.users, file) == header.users &&
+              std::fread(model->item_ids.data(), sizeof(int), header.items, file) == header.items &&
+              std::fread(model->user_factors.data(), sizeof(float), model->user_factors.size(), file) == model->user_factors.size() &&
+              std::fread(model->item_factors.data(), sizeof(float), model->item_factors.size(), file) == model->item_factors.size();
+    std::fclose(file);
+
+    // itemIndex()/userIndex() fazem busca binária: os IDs têm que estar ordenados
+    auto strictlySorted = [](const std::vector<int>& ids) {
+        return std::adjacent_find(ids.begin(), ids.end(), std::greater_equal<int>()) == ids.end();
+    };
+    ok = ok && strictlySorted(model->user_ids) && strictlySorted(model->item_ids);
+
+    if (!ok) {
+        LOG_WARN("⚠️ Arquivo de modelo ALS inválido: %s", path.c_str());
+        return nullptr;
+    }
+
+    model->computeItemGram();
+    model->buildItemAnn();
+    LOG_INFO("📂 Modelo ALS carregado de %s (%zu usuários, %zu filmes, rank %d)",
+             path.c_str(), model->user_ids.size(), model->item_ids.size(), model->factors);
+    return model;
+}
@@ -0,0 +1,79 @@
+#ifndef ALS_H
+#define ALS_H
+
+#include "hnsw_index.h"
+#include "ratings_matrix.h"
+#include "simd_kernels.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ALSOptions {
+    int rank = 32;             // dimensão dos fatores latentes
+    float lambda = 0.1f;       // regularização
+    int iterations = 10;
+    int threads = 0;           // 0 = std::thread::hardware_concurrency()
+    bool implicit = true;      // feedback implícito (Hu, Koren & Volinsky): nota vira confiança
+    float alpha = 10.0f;       // confiança = 1 + alpha * nota (apenas implícito)
+    unsigned seed = 42;
+};
+
+// Fatoração de matrizes por mínimos quadrados alternados. Fatores de usuários
+// e filmes ficam em arrays contíguos de float (linha i = fatores do índice i).
+class ALSModel {
+public:
+    // Catálogos a partir deste tamanho usam HNSW (produto escalar) no lugar
+    // da varredura completa em recommend()
+    static constexpr size_t kAnnMinItems = 50000;
+
+    static std::shared_ptr<ALSModel> train(const RatingsMatrix& matrix, const ALSOptions& options = ALSOptions());
+
+    // Formato binário: cabeçalho, IDs e as duas matrizes de fatores em float32
+    bool save(const std::string& path) const;
+    static std::shared_ptr<ALSModel> load(const std::string& path);
+
+    // Recalcula o vetor do usuário a partir das avaliações atuais (fold-in),
+    // pontua todos os filmes com produto escalar e devolve o top-K não visto.
+    std::vector<ScoredMovie> recommend(const std::vector<Rating>& user_ratings, size_t limit) const;
+
+    // Top-K por produto escalar para um vetor de usuário já calculado
+    std::vector<ScoredMovie> topK(const float* user_vector, const std::vector<int>& exclude_items, size_t limit) const;
+
+    // Buffers de pontuação reaproveitáveis entre chamadas da mesma thread
+    // (modo batch): evitam alocar um vetor de scores por usuário
+    struct ScoringScratch {
+        std::vector<float> scores;
+        ExcludeBitset excluded;
+    };
+    std::vector<ScoredMovie> topK(const float* user_vector, const std::vector<int>& exclude_items,
+                                  size_t limit, ScoringScratch& scratch) const;
+
+    int rank() const { return factors; }
+    size_t userCount() const { return user_ids.size(); }
+    size_t itemCount() const { return item_ids.size(); }
+    int itemIndex(int movie_id) const;
+    int userIndex(int user_id) const;
+    const float* userVector(int user) const { return &user_factors[static_cast<size_t>(user) * factors]; }
+    double trainingSeconds() const { return training_seconds; }
+
+private:
+    int factors = 0;
+    bool implicit = false;
+    float lambda = 0.1f;
+    float alpha = 10.0f;
+    float global_mean = 0.0f;
+
+    std::vector<int> user_ids;
+    std::vector<int> item_ids;
+    std::vector<float> user_factors;
+    std::vector<float> item_factors;
+    std::vector<float> item_gram;   // Yᵀ·Y, usado no fold-in implícito
+
+    std::shared_ptr<HnswIndex> item_ann;
+    double training_seconds = 0.0;
+
+    void computeItemGram();
+    void buildItemAnn();
+};
+
+#endif
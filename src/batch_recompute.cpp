@@ -0,0 +1,201 @@
+#include "batch_recompute.h"
+#include "logger.h"
+#include "thread_pool.h"
+#include "tracing.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace {
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Buffers de cada worker, reaproveitados entre todos os usuários/filmes
+    // que ele processa; as linhas de saída também ficam por worker, então
+    // nenhuma thread disputa lock durante o cálculo
+    struct WorkerScratch {
+        ALSModel::ScoringScratch scoring;
+        std::vector<int> exclude;
+        std::vector<Rating> ratings;
+        std::vector<RankedRow> user_rows;
+        std::vector<RankedRow> similar_rows;
+    };
+
+    void appendRows(std::vector<RankedRow>& rows, int owner_id, const std::vector<ScoredMovie>& movies,
+                    const char* source) {
+        int position = 0;
+        for (const auto& movie : movies) {
+            rows.push_back({owner_id, position++, movie.movie_id, movie.score, source});
+        }
+    }
+
+    // Grava em transações de até `per_transaction` linhas, sem separar as
+    // linhas de um mesmo dono (cada lote apaga a lista anterior de seus donos)
+    size_t writeRows(const std::vector<RankedRow>& rows, size_t per_transaction, const DatabaseLockFn& lock_db,
+                     const std::function<bool(const RankedRow*, size_t)>& store) {
+        size_t written = 0;
+        size_t begin = 0;
+        while (begin < rows.size()) {
+            size_t end = std::min(rows.size(), begin + std::max<size_t>(1, per_transaction));
+            while (end < rows.size() && rows[end].owner_id == rows[end - 1].owner_id) {
+                end++;
+            }
+
+            auto lock = lock_db();
+            if (store(rows.data() + begin, end - begin)) {
+                written += end - begin;
+            }
+            begin = end;
+        }
+        return written;
+    }
+}
+
+BatchReport runBatchRecompute(Database& db, const DatabaseLockFn& lock_db, const BatchModels& models,
+                              const BatchOptions& options, RecoStore* store) {
+    TRACE_SPAN("batch.recompute");
+    BatchReport report;
+    auto total_start = std::chrono::steady_clock::now();
+
+    // ===== CARGA =====
+    auto stage_start = std::chrono::steady_clock::now();
+    std::vector<Rating> ratings;
+    std::vector<Movie> movies;
+    {
+        auto lock = lock_db();
+        ratings = db.getAllRatings();
+        movies = db.getAllMovies();
+    }
+    RatingsMatrix matrix = RatingsMatrix::build(ratings);
+    report.stages.push_back({"load", secondsSince(stage_start), ratings.size()});
+    std::vector<Rating>().swap(ratings);
+
+    WorkStealingPool pool(options.threads);
+    std::vector<WorkerScratch> scratch(pool.size());
+    report.threads = pool.size();
+    report.users = matrix.userCount();
+    report.movies = movies.size();
+
+    // ===== USUÁRIOS =====
+    stage_start = std::chrono::steady_clock::now();
+    pool.parallelFor(matrix.userCount(), options.grain, [&](size_t begin, size_t end, int worker) {
+        WorkerScratch& local = scratch[worker];
+        for (size_t user = begin; user < end; user++) {
+            int user_id = matrix.userId(static_cast<int>(user));
+            uint32_t row_begin = matrix.rowBegin(static_cast<int>(user));
+            uint32_t row_end = matrix.rowEnd(static_cast<int>(user));
+
+            int als_user = models.als ? models.als->userIndex(user_id) : -1;
+            if (als_user >= 0) {
+                local.exclude.clear();
+                for (uint32_t p = row_begin; p < row_end; p++) {
+                    local.exclude.push_back(models.als->itemIndex(matrix.itemId(matrix.rowItems()[p])));
+                }
+                appendRows(local.user_rows, user_id,
+                           models.als->topK(models.als->userVector(als_user), local.exclude,
+                                            options.top_n, local.scoring),
+                           "als");
+                continue;
+            }
+
+            // Usuário que entrou depois do último treino do ALS
+            local.ratings.clear();
+            for (uint32_t p = row_begin; p < row_end; p++) {
+                Rating rating;
+                rating.id = 0;
+                rating.user_id = user_id;
+                rating.movie_id = matrix.itemId(matrix.rowItems()[p]);
+                rating.rating = matrix.rowValues()[p];
+                local.ratings.push_back(rating);
+            }
+            if (models.item_cf) {
+                std::vector<ScoredMovie> result = models.item_cf->recommend(local.ratings, options.top_n);
+                if (!result.empty()) {
+                    appendRows(local.user_rows, user_id, result, "cf");
+                    continue;
+                }
+            }
+            if (models.content) {
+                appendRows(local.user_rows, user_id, models.content->recommend(local.ratings, options.top_n),
+                           "content");
+            }
+        }
+    });
+    report.stages.push_back({"users", secondsSince(stage_start), matrix.userCount()});
+
+    // ===== FILMES PARECIDOS =====
+    stage_start = std::chrono::steady_clock::now();
+    pool.parallelFor(movies.size(), options.grain, [&](size_t begin, size_t end, int worker) {
+        WorkerScratch& local = scratch[worker];
+        for (size_t i = begin; i < end; i++) {
+            int movie_id = movies[i].id;
+            if (models.content && models.content->contains(movie_id)) {
+                appendRows(local.similar_rows, movie_id, models.content->similar(movie_id, options.similar_n), nullptr);
+            } else if (models.item_cf) {
+                appendRows(local.similar_rows, movie_id, models.item_cf->similarMovies(movie_id, options.similar_n), nullptr);
+            }
+        }
+    });
+    report.stages.push_back({"similar", secondsSince(stage_start), movies.size()});
+    report.steals = pool.steals();
+
+    // ===== GRAVAÇÃO =====
+    int64_t computed_at = static_cast<int64_t>(std::time(nullptr));
+    bool complete = true;
+
+    stage_start = std::chrono::steady_clock::now();
+    size_t user_rows = 0;
+    size_t written = 0;
+    for (const auto& local : scratch) {
+        user_rows += local.user_rows.size();
+        written += writeRows(local.user_rows, options.rows_per_transaction, lock_db,
+            [&](const RankedRow* rows, size_t count) {
+                return db.storeUserRecommendations(rows, count, computed_at);
+            });
+    }
+    complete = complete && written == user_rows;
+    report.rows_written += written;
+    report.stages.push_back({"write_users", secondsSince(stage_start), written});
+
+    stage_start = std::chrono::steady_clock::now();
+    size_t similar_rows = 0;
+    written = 0;
+    for (const auto& local : scratch) {
+        similar_rows += local.similar_rows.size();
+        written += writeRows(local.similar_rows, options.rows_per_transaction, lock_db,
+            [&](const RankedRow* rows, size_t count) {
+                return db.storeSimilarMovies(rows, count, computed_at);
+            });
+    }
+    complete = complete && written == similar_rows;
+    report.rows_written += written;
+    report.stages.push_back({"write_similar", secondsSince(stage_start), written});
+
+    if (store) {
+        for (const auto& local : scratch) {
+            const auto& rows = local.user_rows;
+            for (size_t begin = 0; begin < rows.size();) {
+                auto entry = std::make_shared<StoredRecommendations>();
+                entry->source = rows[begin].source;
+                entry->computed_at = computed_at;
+                size_t end = begin;
+                while (end < rows.size() && rows[end].owner_id == rows[begin].owner_id) {
+                    entry->movies.push_back({rows[end].movie_id, rows[end].score});
+                    end++;
+                }
+                store->put(rows[begin].owner_id, std::move(entry));
+                begin = end;
+            }
+        }
+    }
+
+    report.total_seconds = secondsSince(total_start);
+    report.finished_at = computed_at;
+    report.success = complete;
+
+    LOG_INFO("📦 Recálculo em lote: %zu usuários e %zu filmes em %.2f s (%.0f itens/s, %d threads, %llu roubos)",
+             report.users, report.movies, report.total_seconds, report.itemsPerSecond(), report.threads,
+             static_cast<unsigned long long>(report.steals));
+    return report;
+}
@@ -0,0 +1,61 @@
+#ifndef BATCH_RECOMPUTE_H
+#define BATCH_RECOMPUTE_H
+
+#include "als.h"
+#include "content_index.h"
+#include "database.h"
+#include "item_cf.h"
+#include "lock_profiler.h"
+#include "reco_store.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BatchOptions {
+    size_t top_n = 10;                     // recomendações por usuário
+    size_t similar_n = 10;                 // filmes parecidos por filme
+    int threads = 0;                       // 0 = std::thread::hardware_concurrency()
+    size_t grain = 32;                     // usuários/filmes por bloco do pool
+    size_t rows_per_transaction = 50000;   // linhas por COMMIT na gravação
+};
+
+// Modelos já treinados usados no lote; qualquer um pode faltar
+struct BatchModels {
+    std::shared_ptr<const ALSModel> als;
+    std::shared_ptr<const ItemCFModel> item_cf;
+    std::shared_ptr<const ContentIndex> content;
+};
+
+struct BatchStage {
+    std::string name;
+    double seconds = 0.0;
+    size_t items = 0;
+    double itemsPerSecond() const { return seconds > 0 ? items / seconds : 0.0; }
+};
+
+struct BatchReport {
+    int threads = 0;
+    size_t users = 0;
+    size_t movies = 0;
+    size_t rows_written = 0;
+    uint64_t steals = 0;             // blocos roubados entre workers
+    double total_seconds = 0.0;
+    int64_t finished_at = 0;         // unix epoch, segundos
+    bool success = false;
+    std::vector<BatchStage> stages;  // load, users, similar, write_users, write_similar
+
+    // Usuários + filmes processados por segundo de relógio
+    double itemsPerSecond() const { return total_seconds > 0 ? (users + movies) / total_seconds : 0.0; }
+};
+
+// Recalcula o top-N de todos os usuários com avaliações e os filmes parecidos
+// de todo o catálogo. Os usuários são distribuídos num WorkStealingPool, cada
+// worker com seus próprios buffers de pontuação e de saída; a gravação usa
+// transações grandes (rows_per_transaction) e solta o lock entre elas.
+// Se `store` for informado, os resultados também passam a ser servidos por ele.
+BatchReport runBatchRecompute(Database& db, const DatabaseLockFn& lock_db, const BatchModels& models,
+                              const BatchOptions& options = BatchOptions(), RecoStore* store = nullptr);
+
+#endif
@@ -0,0 +1,269 @@
+#include "catalog_ingest.h"
+#include "logger.h"
+#include "tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+    std::string trim(const std::string& text) {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) return "";
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+
+    // Chave de deduplicação: títulos e ids sem diferença de caixa
+    std::string normalize(const std::string& entry) {
+        std::string key = trim(entry);
+        std::transform(key.begin(), key.end(), key.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return key;
+    }
+
+    bool isImdbId(const std::string& key) {
+        return key.size() > 2 && key.compare(0, 2, "tt") == 0 &&
+               std::all_of(key.begin() + 2, key.end(), [](unsigned char c) { return std::isdigit(c); });
+    }
+
+    // Distribui as requisições em intervalos fixos entre todas as threads
+    class RateLimiter {
+    public:
+        explicit RateLimiter(double per_second)
+            : interval(per_second > 0
+                  ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(1.0 / per_second))
+                  : std::chrono::steady_clock::duration::zero()),
+              next_slot(std::chrono::steady_clock::now()) {}
+
+        void acquire() {
+            if (interval == std::chrono::steady_clock::duration::zero()) return;
+            std::chrono::steady_clock::time_point slot;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot = std::max(next_slot, std::chrono::steady_clock::now());
+                next_slot = slot + interval;
+            }
+            std::this_thread::sleep_until(slot);
+        }
+
+    private:
+        std::chrono::steady_clock::duration interval;
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point next_slot;
+    };
+
+    struct FetchResult {
+        std::string entry;
+        bool found = false;
+        Movie movie;
+        std::string error;
+    };
+
+    // Linhas "status<TAB>chave"; só a chave importa para retomar
+    std::unordered_set<std::string> loadCheckpoint(const std::string& path) {
+        std::unordered_set<std::string> completed;
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t tab = line.find('\t');
+            if (tab != std::string::npos) completed.insert(line.substr(tab + 1));
+        }
+        return completed;
+    }
+}
+
+std::vector<std::string> readCatalogEntries(const std::string& path) {
+    std::vector<std::string> entries;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string entry = trim(line);
+        if (entry.empty() || entry[0] == '#') continue;
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+CatalogIngestReport runCatalogIngest(Database& db, const DatabaseLockFn& lock_db, MovieAPI& api,
+                                     const std::vector<std::string>& entries, const CatalogIngestOptions& options,
+                                     const IngestProgressFn& on_progress) {
+    TRACE_SPAN("catalog.ingest");
+    CatalogIngestReport report;
+    CatalogIngestProgress& progress = report.progress;
+    progress.total = entries.size();
+    auto started = std::chrono::steady_clock::now();
+
+    std::unordered_set<std::string> completed;
+    if (options.resume && !options.checkpoint_path.empty()) {
+        completed = loadCheckpoint(options.checkpoint_path);
+    }
+    std::ofstream checkpoint;
+    if (!options.checkpoint_path.empty()) {
+        checkpoint.open(options.checkpoint_path, options.resume ? std::ios::app : std::ios::trunc);
+    }
+    auto markDone = [&](const char* status, const std::string& key) {
+        if (checkpoint.is_open()) checkpoint << status << '\t' << key << '\n';
+    };
+
+    // Catálogo atual: imdb_ids para deduplicar o resultado e títulos para
+    // nem gastar uma consulta com o que já está cadastrado
+    std::unordered_set<std::string> known_ids;
+    std::unordered_set<std::string> known_titles;
+    {
+        auto lock = lock_db();
+        for (const auto& movie : db.getAllMovies()) {
+            if (!movie.imdb_id.empty()) known_ids.insert(normalize(movie.imdb_id));
+            known_titles.insert(normalize(movie.title));
+        }
+    }
+
+    std::vector<std::string> pending;
+    std::unordered_set<std::string> seen;
+    for (const auto& entry : entries) {
+        std::string key = normalize(entry);
+        if (!seen.insert(key).second) {
+            progress.duplicates++;
+        } else if (completed.count(key)) {
+            progress.resumed++;
+        } else if (isImdbId(key) ? known_ids.count(key) > 0 : known_titles.count(key) > 0) {
+            progress.duplicates++;
+            markDone("duplicate", key);
+        } else {
+            pending.push_back(trim(entry));
+        }
+    }
+    checkpoint.flush();
+
+    // ===== CONSULTAS AO OMDB =====
+    RateLimiter limiter(options.requests_per_second);
+    std::atomic<size_t> next_entry(0);
+    std::mutex results_mutex;
+    std::condition_variable results_ready;
+    std::deque<FetchResult> results;
+    int running_workers = std::max(1, options.concurrency);
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < std::max(1, options.concurrency); w++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next_entry++; i < pending.size(); i = next_entry++) {
+                FetchResult result;
+                result.entry = pending[i];
+                for (int attempt = 0;; attempt++) {
+                    limiter.acquire();
+                    result.found = api.fetchMovie(result.entry, result.movie, result.error);
+                    if (result.found || result.error == "not_found" || attempt >= options.max_retries) break;
+                    std::this_thread::sleep_for(std::chrono::seconds(1 << attempt));
+                }
+
+                std::lock_guard<std::mutex> lock(results_mutex);
+                results.push_back(std::move(result));
+                results_ready.notify_one();
+            }
+            std::lock_guard<std::mutex> lock(results_mutex);
+            running_workers--;
+            results_ready.notify_one();
+        });
+    }
+
+    // ===== GRAVAÇÃO EM LOTES =====
+    std::vector<FetchResult> batch;
+    auto commitBatch = [&]() {
+        if (batch.empty()) return;
+        std::vector<std::pair<const char*, std::string>> done;
+        std::vector<std::string> added_ids;
+        size_t inserted = 0;
+        size_t duplicates = 0;
+        bool committed = false;
+        {
+            auto lock = lock_db();
+            if (db.execute("BEGIN")) {
+                for (const auto& result : batch) {
+                    std::string id = normalize(result.movie.imdb_id);
+                    if (known_ids.count(id)) {
+                        duplicates++;
+                        done.push_back({"duplicate", normalize(result.entry)});
+                        continue;
+                    }
+                    bool created = false;
+                    if (db.createMovie(result.movie, &created) > 0) {
+                        created ? inserted++ : duplicates++;
+                        known_ids.insert(id);
+                        added_ids.push_back(id);
+                        done.push_back({created ? "inserted" : "duplicate", normalize(result.entry)});
+                    } else {
+                        report.failures.push_back({result.entry, "erro ao gravar no banco"});
+                        progress.failed++;
+                    }
+                }
+                committed = db.execute("COMMIT");
+                if (!committed) db.execute("ROLLBACK");
+            }
+        }
+
+        if (committed) {
+            progress.inserted += inserted;
+            progress.duplicates += duplicates;
+            for (const auto& entry : done) markDone(entry.first, entry.second);
+            checkpoint.flush();
+        } else {
+            for (const auto& id : added_ids) known_ids.erase(id);
+            for (const auto& entry : done) {
+                report.failures.push_back({entry.second, "falha na transação"});
+            }
+            progress.failed += done.size();
+            LOG_ERROR("❌ Importação do catálogo: lote de %zu filmes não gravado", batch.size());
+        }
+        batch.clear();
+    };
+
+    auto last_report = std::chrono::steady_clock::now();
+    while (true) {
+        std::deque<FetchResult> ready;
+        bool finished = false;
+        {
+            std::unique_lock<std::mutex> lock(results_mutex);
+            results_ready.wait_for(lock, std::chrono::seconds(1),
+                                   [&]() { return !results.empty() || running_workers == 0; });
+            ready.swap(results);
+            finished = running_workers == 0 && ready.empty();
+        }
+        if (finished) break;
+
+        for (auto& result : ready) {
+            progress.fetched++;
+            if (result.found) {
+                batch.push_back(std::move(result));
+                if (batch.size() >= std::max<size_t>(1, options.batch_size)) commitBatch();
+            } else if (result.error == "not_found") {
+                progress.not_found++;
+                markDone("not_found", normalize(result.entry));
+            } else {
+                progress.failed++;
+                report.failures.push_back({result.entry, result.error});
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (on_progress && now - last_report >= std::chrono::seconds(2)) {
+            progress.seconds = std::chrono::duration<double>(now - started).count();
+            on_progress(progress);
+            last_report = now;
+        }
+    }
+    commitBatch();
+    for (auto& worker : workers) worker.join();
+
+    progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (on_progress) on_progress(progress);
+    LOG_INFO("🎬 Importação do catálogo: %zu gravados, %zu duplicados, %zu inexistentes, %zu falhas em %.1f s",
+             progress.inserted, progress.duplicates, progress.not_found, progress.failed, progress.seconds);
+    return report;
+}
@@ -0,0 +1,56 @@
+#ifndef CATALOG_INGEST_H
+#define CATALOG_INGEST_H
+
+#include "database.h"
+#include "lock_profiler.h"
+#include "movie_api.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct CatalogIngestOptions {
+    int concurrency = 4;               // requisições simultâneas ao OMDB
+    double requests_per_second = 5.0;  // limite global; 0 = sem limite
+    int max_retries = 2;               // novas tentativas para erros de rede/limite
+    size_t batch_size = 50;            // filmes por transação
+    std::string checkpoint_path;       // entradas concluídas, para retomar
+    bool resume = true;                // false = ignora e recria o checkpoint
+};
+
+struct CatalogIngestProgress {
+    size_t total = 0;        // entradas no arquivo
+    size_t resumed = 0;      // já concluídas numa execução anterior
+    size_t fetched = 0;      // consultas ao OMDB terminadas
+    size_t inserted = 0;
+    size_t duplicates = 0;   // repetidas no arquivo ou já no catálogo
+    size_t not_found = 0;
+    size_t failed = 0;
+    double seconds = 0.0;
+
+    double fetchesPerSecond() const { return seconds > 0 ? fetched / seconds : 0.0; }
+};
+
+struct CatalogIngestReport {
+    CatalogIngestProgress progress;
+    std::vector<std::pair<std::string, std::string>> failures;  // (entrada, erro)
+};
+
+using IngestProgressFn = std::function<void(const CatalogIngestProgress&)>;
+
+// Uma entrada por linha (título ou IMDb id); ignora linhas vazias e "#"
+std::vector<std::string> readCatalogEntries(const std::string& path);
+
+// Importa uma lista de títulos/IMDb ids para o catálogo: `concurrency`
+// threads consultam o OMDB (fetchMovie) sob um limite global de requisições
+// por segundo e a thread chamadora grava os resultados com createMovie em
+// transações de batch_size, pulando imdb_ids que já existem. Cada entrada
+// concluída (gravada, duplicada ou inexistente no OMDB) vai para o arquivo de
+// checkpoint depois do COMMIT; numa nova execução essas entradas são puladas
+// e só as pendentes ou que falharam são consultadas de novo.
+CatalogIngestReport runCatalogIngest(Database& db, const DatabaseLockFn& lock_db, MovieAPI& api,
+                                     const std::vector<std::string>& entries, const CatalogIngestOptions& options,
+                                     const IngestProgressFn& on_progress = nullptr);
+
+#endif
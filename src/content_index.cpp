@@ -0,0 +1,266 @@
+#include "content_index.h"
+#include "logger.h"
+#include "simd_kernels.h"
+#include "tracing.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+    // Finalizador do splitmix64: espalha bem bits próximos
+    uint64_t mixHash(uint64_t value) {
+        value += 0x9e3779b97f4a7c15ULL;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    const std::unordered_set<std::string>& stopWords() {
+        static const std::unordered_set<std::string> words = {
+            "a", "an", "and", "are", "as", "at", "be", "been", "but", "by", "for", "from", "has", "have",
+            "he", "her", "his", "in", "into", "is", "it", "its", "of", "on", "or", "she", "that", "the",
+            "their", "them", "they", "this", "to", "was", "when", "who", "whose", "will", "with", "after",
+            "before", "while", "where", "which", "about", "over", "must", "one", "two", "n/a",
+            "o", "os", "um", "uma", "de", "do", "da", "dos", "das", "e", "em", "no", "na", "por", "para", "com"
+        };
+        return words;
+    }
+
+    std::string toLower(const std::string& text) {
+        std::string result(text);
+        for (auto& ch : result) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        return result;
+    }
+
+    std::string trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) return "";
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    // "Drama, Sci-Fi" → {"drama", "sci-fi"}
+    std::vector<std::string> splitList(const std::string& text) {
+        std::vector<std::string> items;
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t comma = text.find(',', start);
+            if (comma == std::string::npos) comma = text.size();
+            std::string item = toLower(trim(text.substr(start, comma - start)));
+            if (!item.empty() && item != "n/a") items.push_back(item);
+            start = comma + 1;
+        }
+        return items;
+    }
+
+    // Palavras da sinopse: letras/dígitos (bytes UTF-8 acentuados incluídos)
+    std::vector<std::string> words(const std::string& text) {
+        std::vector<std::string> result;
+        std::string current;
+        for (char ch : text) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (std::isalnum(c) || c >= 0x80 || c == '\'') {
+                current += static_cast<char>(std::tolower(c));
+            } else if (!current.empty()) {
+                result.push_back(current);
+                current.clear();
+            }
+        }
+        if (!current.empty()) result.push_back(current);
+
+        const auto& stop = stopWords();
+        std::vector<std::string> filtered;
+        for (auto& word : result) {
+            while (!word.empty() && word.back() == '\'') word.pop_back();
+            if (word.size() >= 2 && !stop.count(word)) filtered.push_back(word);
+        }
+        return filtered;
+    }
+}
+
+// ===== CONSTRUÇÃO =====
+std::unordered_map<std::string, float> ContentIndex::termFrequencies(const Movie& movie, const ContentIndexOptions& options) {
+    std::unordered_map<std::string, float> tf;
+    for (const auto& genre : splitList(movie.genre)) tf["g:" + genre] += options.genre_weight;
+    for (const auto& actor : splitList(movie.actors)) tf["a:" + actor] += options.actor_weight;
+    for (const auto& word : words(movie.description)) tf[word] += options.description_weight;
+    return tf;
+}
+
+std::shared_ptr<ContentIndex> ContentIndex::build(const std::vector<Movie>& movies, const ContentIndexOptions& options) {
+    TRACE_SPAN("content.build");
+    auto started = std::chrono::steady_clock::now();
+
+    std::shared_ptr<ContentIndex> index(new ContentIndex());
+    index->options = options;
+    std::vector<uint32_t> document_frequency;
+    std::vector<std::vector<std::pair<uint32_t, float>>> frequencies(movies.size());
+
+    for (size_t m = 0; m < movies.size(); m++) {
+        const Movie& movie = movies[m];
+        index->movie_index[movie.id] = static_cast<uint32_t>(index->movie_ids.size());
+        index->movie_ids.push_back(movie.id);
+
+        for (const auto& entry : termFrequencies(movie, options)) {
+            auto inserted = index->dictionary.emplace(entry.first, static_cast<uint32_t>(index->dictionary.size()));
+            if (inserted.second) {
+                document_frequency.push_back(0);
+                index->term_names.push_back(entry.first);
+            }
+            document_frequency[inserted.first->second]++;
+            frequencies[m].push_back({inserted.first->second, entry.second});
+        }
+    }
+
+    const double documents = static_cast<double>(movies.size());
+    index->idf.resize(document_frequency.size());
+    for (size_t t = 0; t < document_frequency.size(); t++) {
+        index->idf[t] = static_cast<float>(std::log(documents / document_frequency[t]));
+    }
+
+    index->vector_offsets.assign(movies.size() + 1, 0);
+    index->postings.resize(index->dictionary.size());
+
+    std::vector<Term> terms;
+    for (size_t m = 0; m < movies.size(); m++) {
+        terms.clear();
+        for (const auto& entry : frequencies[m]) {
+            // Termos que aparecem em um único filme não ajudam a achar vizinhos
+            if (document_frequency[entry.first] < 2) continue;
+            float weight = static_cast<float>((1.0 + std::log(entry.second)) * index->idf[entry.first]);
+            if (weight > 0.0f) terms.push_back({entry.first, weight});
+        }
+
+        if (terms.size() > options.max_terms_per_movie) {
+            std::nth_element(terms.begin(), terms.begin() + options.max_terms_per_movie, terms.end(),
+                             [](const Term& a, const Term& b) { return a.weight > b.weight; });
+            terms.resize(options.max_terms_per_movie);
+        }
+
+        double norm = 0.0;
+        for (const auto& term : terms) norm += static_cast<double>(term.weight) * term.weight;
+        norm = std::sqrt(norm);
+        for (auto& term : terms) {
+            term.weight = static_cast<float>(term.weight / norm);
+            index->postings[term.term].push_back({static_cast<uint32_t>(m), term.weight});
+        }
+
+        index->vectors.insert(index->vectors.end(), terms.begin(), terms.end());
+        index->vector_offsets[m + 1] = static_cast<uint32_t>(index->vectors.size());
+    }
+
+    // Soma de um hash por (filme, termo, peso): não depende da ordem e cobre
+    // tudo que entra em embed(); o std::hash de um texto fixo pega troca de
+    // biblioteca, que espalharia os termos em outras posições
+    std::hash<std::string> hasher;
+    uint64_t fingerprint = mixHash(options.embedding_dims) ^ mixHash(hasher("cineia.content"));
+    for (size_t m = 0; m < movies.size(); m++) {
+        fingerprint += mixHash(static_cast<uint64_t>(index->movie_ids[m]));
+        for (uint32_t p = index->vector_offsets[m]; p < index->vector_offsets[m + 1]; p++) {
+            uint32_t weight_bits;
+            std::memcpy(&weight_bits, &index->vectors[p].weight, sizeof(weight_bits));
+            fingerprint += mixHash(hasher(index->term_names[index->vectors[p].term]) ^
+                                   (static_cast<uint64_t>(index->movie_ids[m]) << 32 | weight_bits));
+        }
+    }
+    index->catalog_fingerprint = fingerprint;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    LOG_INFO("📚 Índice de conteúdo: %zu filmes, %zu termos em %.3f s",
+             index->movie_ids.size(), index->dictionary.size(), seconds);
+    return index;
+}
+
+std::vector<float> ContentIndex::embed(const Movie& movie) const {
+    const size_t dims = std::max<size_t>(1, options.embedding_dims);
+    std::vector<float> vector(dims, 0.0f);
+    std::hash<std::string> hasher;
+
+    auto add = [&](const std::string& term, float weight) {
+        size_t hash = hasher(term);
+        float sign = ((hash / dims) & 1) ? -1.0f : 1.0f;
+        vector[hash % dims] += sign * weight;
+    };
+
+    auto indexed = movie_index.find(movie.id);
+    if (indexed != movie_index.end()) {
+        uint32_t m = indexed->second;
+        for (uint32_t p = vector_offsets[m]; p < vector_offsets[m + 1]; p++) {
+            add(term_names[vectors[p].term], vectors[p].weight);
+        }
+        return vector;
+    }
+
+    for (const auto& entry : termFrequencies(movie, options)) {
+        // Termos fora do dicionário não têm como casar com outros filmes
+        auto term = dictionary.find(entry.first);
+        if (term == dictionary.end()) continue;
+        add(entry.first, static_cast<float>((1.0 + std::log(entry.second)) * idf[term->second]));
+    }
+    return vector;
+}
+
+// ===== CONSULTAS =====
+std::vector<ScoredMovie> ContentIndex::scoreQuery(const std::unordered_map<uint32_t, float>& query,
+                                                  const std::vector<uint32_t>& exclude, size_t limit) const {
+    std::vector<float> scores(movie_ids.size(), 0.0f);
+    for (const auto& entry : query) {
+        for (const Posting& posting : postings[entry.first]) {
+            scores[posting.movie] += entry.second * posting.weight;
+        }
+    }
+
+    ExcludeBitset excluded(movie_ids.size());
+    for (uint32_t movie : exclude) excluded.set(movie);
+
+    std::vector<ScoredMovie> result;
+    for (const ScoredIndex& best : topKScores(scores.data(), scores.size(), limit, &excluded)) {
+        if (best.score <= 0.0f) break;
+        result.push_back({movie_ids[best.index], best.score});
+    }
+    return result;
+}
+
+std::vector<ScoredMovie> ContentIndex::similar(int movie_id, size_t limit) const {
+    TRACE_SPAN("content.similar");
+    auto it = movie_index.find(movie_id);
+    if (it == movie_index.end()) return {};
+
+    uint32_t movie = it->second;
+    std::unordered_map<uint32_t, float> query;
+    for (uint32_t p = vector_offsets[movie]; p < vector_offsets[movie + 1]; p++) {
+        query[vectors[p].term] = vectors[p].weight;
+    }
+    return scoreQuery(query, {movie}, limit);
+}
+
+std::vector<ScoredMovie> ContentIndex::recommend(const std::vector<Rating>& user_ratings, size_t limit) const {
+    TRACE_SPAN("content.recommend");
+    if (user_ratings.empty()) return {};
+
+    double mean = 0.0;
+    for (const auto& rating : user_ratings) mean += rating.rating;
+    mean /= user_ratings.size();
+
+    std::unordered_map<uint32_t, float> profile;
+    std::vector<uint32_t> seen;
+    for (const auto& rating : user_ratings) {
+        auto it = movie_index.find(rating.movie_id);
+        if (it == movie_index.end()) continue;
+        uint32_t movie = it->second;
+        seen.push_back(movie);
+
+        // Com uma única avaliação (ou todas iguais) o desvio é zero: usa peso 1
+        float weight = user_ratings.size() > 1 ? static_cast<float>(rating.rating - mean) : 1.0f;
+        if (weight == 0.0f && rating.rating >= mean) weight = 0.5f;
+        for (uint32_t p = vector_offsets[movie]; p < vector_offsets[movie + 1]; p++) {
+            profile[vectors[p].term] += weight * vectors[p].weight;
+        }
+    }
+    if (profile.empty()) return {};
+
+    return scoreQuery(profile, seen, limit);
+}
@@ -0,0 +1,75 @@
+#ifndef CONTENT_INDEX_H
+#define CONTENT_INDEX_H
+
+#include "ratings_matrix.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ContentIndexOptions {
+    float genre_weight = 2.0f;        // gênero pesa mais que uma palavra da sinopse
+    float actor_weight = 1.5f;
+    float description_weight = 1.0f;
+    size_t max_terms_per_movie = 64;  // termos de maior peso mantidos por filme
+    size_t embedding_dims = 256;      // vetor denso por hashing dos termos (para o HNSW)
+};
+
+// Índice de conteúdo: cada filme vira um vetor TF-IDF esparso (L2-normalizado)
+// com termos da sinopse, gêneros ("g:drama") e atores ("a:tom hanks").
+// Similaridade por cosseno usando um índice invertido termo → filmes.
+class ContentIndex {
+public:
+    static std::shared_ptr<ContentIndex> build(const std::vector<Movie>& movies,
+                                               const ContentIndexOptions& options = ContentIndexOptions());
+
+    // Filmes mais parecidos com um filme do catálogo (ele mesmo excluído)
+    std::vector<ScoredMovie> similar(int movie_id, size_t limit) const;
+
+    // Perfil do usuário = soma dos vetores dos filmes avaliados, ponderada
+    // pela diferença para a média do usuário; serve mesmo com 1-2 avaliações
+    std::vector<ScoredMovie> recommend(const std::vector<Rating>& user_ratings, size_t limit) const;
+
+    // Vetor denso do filme: pesos do vetor TF-IDF espalhados em embedding_dims
+    // posições por hashing (com sinal) do texto do termo, estável entre
+    // reinícios. Filmes fora do índice usam os termos conhecidos do dicionário.
+    std::vector<float> embed(const Movie& movie) const;
+    size_t embeddingDims() const { return options.embedding_dims; }
+    // Muda quando muda qualquer vetor de embed() (catálogo, dicionário, IDF,
+    // dimensões ou a função de hash da biblioteca padrão)
+    uint64_t fingerprint() const { return catalog_fingerprint; }
+
+    size_t movieCount() const { return movie_ids.size(); }
+    size_t termCount() const { return postings.size(); }
+    bool contains(int movie_id) const { return movie_index.count(movie_id) > 0; }
+
+private:
+    struct Term {
+        uint32_t term;
+        float weight;
+    };
+    struct Posting {
+        uint32_t movie;
+        float weight;
+    };
+
+    ContentIndexOptions options;
+    uint64_t catalog_fingerprint = 0;
+    std::unordered_map<std::string, uint32_t> dictionary;
+    std::vector<std::string> term_names;   // inverso do dicionário
+    std::vector<float> idf;                // por termo
+
+    std::vector<int> movie_ids;
+    std::unordered_map<int, uint32_t> movie_index;
+
+    // Vetor do filme i em [vector_offsets[i], vector_offsets[i + 1])
+    std::vector<uint32_t> vector_offsets;
+    std::vector<Term> vectors;
+    std::vector<std::vector<Posting>> postings;   // por termo
+
+    static std::unordered_map<std::string, float> termFrequencies(const Movie& movie, const ContentIndexOptions& options);
+    std::vector<ScoredMovie> scoreQuery(const std::unordered_map<uint32_t, float>& query,
+                                        const std::vector<uint32_t>& exclude, size_t limit) const;
+};
+
+#endif
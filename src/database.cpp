@@ -1,9 +1,13 @@
 #include "database.h"
-#include <iostream>
+#include "logger.h"
+#include "migrations.h"
+#include "tracing.h"
+#include <algorithm>
+#include <ctime>
 #include <sstream>
 #include <cstring>
 
-Database::Database(const std::string& path) : db(nullptr), db_path(path) {}
+Database::Database(const std::string& path) : db(nullptr), db_path(path), title_index_loaded(false), title_index_in_transaction(false) {}
 
 Database::~Database() {
     if (db) {
@@ -13,9 +17,11 @@ Database::~Database() {
 
 bool Database::init() {
     if (sqlite3_open(db_path.c_str(), &db) != SQLITE_OK) {
-        std::cerr << "Erro ao abrir banco de dados: " << sqlite3_errmsg(db) << std::endl;
+        LOG_ERROR("Erro ao abrir banco de dados: %s", sqlite3_errmsg(db));
         return false;
     }
+
+    profiler.attach(db);
     
     const char* create_tables = R"(
         CREATE TABLE IF NOT EXISTS users (
@@ -49,24 +55,102 @@ bool Database::init() {
             UNIQUE(user_id, movie_id)
         );
         
-        CREATE INDEX IF NOT EXISTS idx_genre ON movies(genre);
-        CREATE INDEX IF NOT EXISTS idx_user_ratings ON ratings(user_id);
+        CREATE TABLE IF NOT EXISTS user_recommendations (
+            user_id INTEGER NOT NULL,
+            position INTEGER NOT NULL,
+            movie_id INTEGER NOT NULL,
+            score REAL NOT NULL,
+            source TEXT,
+            computed_at INTEGER NOT NULL,
+            PRIMARY KEY(user_id, position)
+        );
+        
+        CREATE TABLE IF NOT EXISTS similar_movies (
+            movie_id INTEGER NOT NULL,
+            position INTEGER NOT NULL,
+            similar_id INTEGER NOT NULL,
+            score REAL NOT NULL,
+            computed_at INTEGER NOT NULL,
+            PRIMARY KEY(movie_id, position)
+        );
+        
+        CREATE TABLE IF NOT EXISTS schema_migrations (
+            version INTEGER PRIMARY KEY,
+            name TEXT NOT NULL,
+            started_at INTEGER,
+            applied_at INTEGER,
+            duration_ms REAL DEFAULT 0
+        );
     )";
     
-    return execute(create_tables);
+    return execute(create_tables) && MigrationRunner(*this, schemaMigrations()).runBlocking();
+}
+
+int64_t Database::queryInt(const std::string& sql, int64_t fallback) {
+    int64_t value = fallback;
+    query(sql, [&](sqlite3_stmt* stmt) {
+        if (sqlite3_column_type(stmt, 0) != SQLITE_NULL) value = sqlite3_column_int64(stmt, 0);
+    });
+    return value;
+}
+
+bool Database::query(const std::string& sql, const std::function<void(sqlite3_stmt*)>& on_row) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR("Erro SQL: %s", sqlite3_errmsg(db));
+        return false;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        on_row(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+void Database::loadTitleIndex() {
+    if (title_index_loaded) return;
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, "SELECT id, title, year FROM movies", -1, &stmt, nullptr) != SQLITE_OK) {
+        return;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* title = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        title_index.add(sqlite3_column_int(stmt, 0), title ? title : "", sqlite3_column_int(stmt, 2));
+    }
+    sqlite3_finalize(stmt);
+    title_index_loaded = true;
+}
+
+// O detector é só memória: alterações feitas dentro de uma transação só
+// valem se ela for confirmada (ver execute())
+void Database::noteTitleIndexChange() {
+    if (!sqlite3_get_autocommit(db)) title_index_in_transaction = true;
 }
 
 bool Database::execute(const std::string& sql) {
+    TRACE_SPAN("db.execute");
     char* err_msg = nullptr;
-    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        std::cerr << "Erro SQL: " << err_msg << std::endl;
+    bool ok = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err_msg) == SQLITE_OK;
+    if (!ok) {
+        LOG_ERROR("Erro SQL: %s", err_msg);
         sqlite3_free(err_msg);
-        return false;
     }
-    return true;
+
+    // Transação encerrada: num ROLLBACK o detector pode ter ids que não
+    // existem mais, então é descartado e recarregado no próximo uso
+    if (title_index_in_transaction && sqlite3_get_autocommit(db)) {
+        title_index_in_transaction = false;
+        if (!ok || sql.compare(0, 8, "ROLLBACK") == 0) {
+            title_index.clear();
+            title_index_loaded = false;
+        }
+    }
+    return ok;
 }
 
 int Database::createUser(const std::string& username, const std::string& password_hash, bool is_admin) {
+    TRACE_SPAN("db.createUser");
     sqlite3_stmt* stmt;
     const char* sql = "INSERT INTO users (username, password_hash, is_admin) VALUES (?, ?, ?)";
     
@@ -89,6 +173,7 @@ int Database::createUser(const std::string& username, const std::string& passwor
 }
 
 User* Database::getUserByUsername(const std::string& username) {
+    TRACE_SPAN("db.getUserByUsername");
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, username, password_hash, is_admin FROM users WHERE username = ?";
     
@@ -112,6 +197,7 @@ User* Database::getUserByUsername(const std::string& username) {
 }
 
 User* Database::getUserById(int id) {
+    TRACE_SPAN("db.getUserById");
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, username, password_hash, is_admin FROM users WHERE id = ?";
     
@@ -134,16 +220,48 @@ User* Database::getUserById(int id) {
     return user;
 }
 
-int Database::createMovie(const Movie& movie) {
+int Database::createMovie(const Movie& movie, bool* created) {
+    TRACE_SPAN("db.createMovie");
+    if (created) *created = false;
+    std::string imdb_id = movie.imdb_id == "N/A" ? "" : movie.imdb_id;
+
+    // Sem imdb_id não há índice que segure a duplicata: checa o título
+    loadTitleIndex();
+    if (imdb_id.empty()) {
+        int existing = title_index.findDuplicate(movie.title, movie.year);
+        if (existing > 0) {
+            LOG_DEBUG("🔁 \"%s\" (%d) já cadastrado como filme %d", movie.title.c_str(), movie.year, existing);
+            return existing;
+        }
+    }
+
     sqlite3_stmt* stmt;
-    const char* sql = "INSERT INTO movies (title, imdb_id, genre, description, actors, poster_url, imdb_rating, rotten_tomatoes_rating, year) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+    // O índice único só vale para imdb_id não vazio: só então procura o
+    // filme existente, para saber se o upsert vai inserir ou atualizar
+    int existing = 0;
+    if (!imdb_id.empty() &&
+        sqlite3_prepare_v2(db, "SELECT id FROM movies WHERE imdb_id = ?", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, imdb_id.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW) existing = sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+
+    const char* sql =
+        "INSERT INTO movies (title, imdb_id, genre, description, actors, poster_url, imdb_rating, rotten_tomatoes_rating, year) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT(imdb_id) WHERE imdb_id <> '' DO UPDATE SET "
+        "title = excluded.title, genre = excluded.genre, description = excluded.description, "
+        "actors = excluded.actors, poster_url = excluded.poster_url, imdb_rating = excluded.imdb_rating, "
+        "rotten_tomatoes_rating = excluded.rotten_tomatoes_rating, year = excluded.year "
+        "RETURNING id";
     
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         return -1;
     }
     
     sqlite3_bind_text(stmt, 1, movie.title.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, movie.imdb_id.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, imdb_id.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 3, movie.genre.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 4, movie.description.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 5, movie.actors.c_str(), -1, SQLITE_TRANSIENT);
@@ -152,17 +270,27 @@ int Database::createMovie(const Movie& movie) {
     sqlite3_bind_double(stmt, 8, movie.rotten_tomatoes_rating);
     sqlite3_bind_int(stmt, 9, movie.year);
     
+    // RETURNING devolve o id tanto na inserção quanto no DO UPDATE
+    int id = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        id = sqlite3_column_int(stmt, 0);
+    }
     if (sqlite3_step(stmt) != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return -1;
+        id = -1;
     }
-    
-    int id = sqlite3_last_insert_rowid(db);
     sqlite3_finalize(stmt);
+    
+    if (id > 0 && id != existing && created) *created = true;
+
+    if (id > 0) {
+        title_index.add(id, movie.title, movie.year);
+        noteTitleIndexChange();
+    }
     return id;
 }
 
 Movie* Database::getMovieById(int id) {
+    TRACE_SPAN("db.getMovieById");
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, title, imdb_id, genre, description, actors, poster_url, imdb_rating, rotten_tomatoes_rating, year FROM movies WHERE id = ?";
     
@@ -192,6 +320,7 @@ Movie* Database::getMovieById(int id) {
 }
 
 std::vector<Movie> Database::getAllMovies() {
+    TRACE_SPAN("db.getAllMovies");
     std::vector<Movie> movies;
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, title, imdb_id, genre, description, actors, poster_url, imdb_rating, rotten_tomatoes_rating, year FROM movies";
@@ -219,7 +348,63 @@ std::vector<Movie> Database::getAllMovies() {
     return movies;
 }
 
+bool Database::getMovieChanges(int64_t since, int limit, std::vector<MovieChange>& changes) {
+    TRACE_SPAN("db.getMovieChanges");
+    sqlite3_stmt* stmt;
+    const char* sql = R"(
+        SELECT c.seq, c.movie_id, c.deleted, m.title, m.imdb_id, m.genre, m.description, m.actors,
+               m.poster_url, m.imdb_rating, m.rotten_tomatoes_rating, m.year
+        FROM movie_changes c
+        LEFT JOIN movies m ON m.id = c.movie_id
+        WHERE c.seq > ?
+        ORDER BY c.seq
+        LIMIT ?
+    )";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+
+    sqlite3_bind_int64(stmt, 1, since);
+    sqlite3_bind_int(stmt, 2, limit);
+
+    auto text = [&](int column) {
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return std::string(value ? value : "");
+    };
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        MovieChange change{};
+        change.seq = sqlite3_column_int64(stmt, 0);
+        change.movie_id = sqlite3_column_int(stmt, 1);
+        // Filme sumido sem passar pelo trigger também vira exclusão
+        change.deleted = sqlite3_column_int(stmt, 2) != 0 || sqlite3_column_type(stmt, 3) == SQLITE_NULL;
+        change.movie.id = change.movie_id;
+        if (!change.deleted) {
+            change.movie.title = text(3);
+            change.movie.imdb_id = text(4);
+            change.movie.genre = text(5);
+            change.movie.description = text(6);
+            change.movie.actors = text(7);
+            change.movie.poster_url = text(8);
+            change.movie.imdb_rating = sqlite3_column_double(stmt, 9);
+            change.movie.rotten_tomatoes_rating = sqlite3_column_double(stmt, 10);
+            change.movie.year = sqlite3_column_int(stmt, 11);
+        }
+        changes.push_back(std::move(change));
+    }
+
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+int64_t Database::latestMovieChangeSeq() {
+    // O AUTOINCREMENT guarda o maior seq em sqlite_sequence; sem a tabela do
+    // feed (migração pendente) não há linha e o resultado é 0, sem erro
+    return queryInt("SELECT seq FROM sqlite_sequence WHERE name = 'movie_changes'", 0);
+}
+
 std::vector<Movie> Database::getMoviesByGenre(const std::string& genre) {
+    TRACE_SPAN("db.getMoviesByGenre");
     std::vector<Movie> movies;
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, title, imdb_id, genre, description, actors, poster_url, imdb_rating, rotten_tomatoes_rating, year FROM movies WHERE genre = ?";
@@ -250,6 +435,7 @@ std::vector<Movie> Database::getMoviesByGenre(const std::string& genre) {
 }
 
 bool Database::updateMovie(const Movie& movie) {
+    TRACE_SPAN("db.updateMovie");
     sqlite3_stmt* stmt;
     const char* sql = "UPDATE movies SET title=?, imdb_id=?, genre=?, description=?, actors=?, poster_url=?, imdb_rating=?, rotten_tomatoes_rating=?, year=? WHERE id=?";
     
@@ -270,10 +456,15 @@ bool Database::updateMovie(const Movie& movie) {
     
     bool success = sqlite3_step(stmt) == SQLITE_DONE;
     sqlite3_finalize(stmt);
+    if (success && title_index_loaded) {
+        title_index.add(movie.id, movie.title, movie.year);
+        noteTitleIndexChange();
+    }
     return success;
 }
 
 bool Database::deleteMovie(int id) {
+    TRACE_SPAN("db.deleteMovie");
     sqlite3_stmt* stmt;
     const char* sql = "DELETE FROM movies WHERE id = ?";
     
@@ -284,12 +475,19 @@ bool Database::deleteMovie(int id) {
     sqlite3_bind_int(stmt, 1, id);
     bool success = sqlite3_step(stmt) == SQLITE_DONE;
     sqlite3_finalize(stmt);
+    if (success) {
+        title_index.remove(id);
+        noteTitleIndexChange();
+    }
     return success;
 }
 
-bool Database::addRating(int user_id, int movie_id, double rating) {
+bool Database::addRating(int user_id, int movie_id, double rating, int64_t timestamp) {
+    TRACE_SPAN("db.addRating");
     sqlite3_stmt* stmt;
-    const char* sql = "INSERT OR REPLACE INTO ratings (user_id, movie_id, rating) VALUES (?, ?, ?)";
+    const char* sql = timestamp > 0
+        ? "INSERT OR REPLACE INTO ratings (user_id, movie_id, rating, timestamp) VALUES (?, ?, ?, datetime(?, 'unixepoch'))"
+        : "INSERT OR REPLACE INTO ratings (user_id, movie_id, rating) VALUES (?, ?, ?)";
     
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         return false;
@@ -298,13 +496,105 @@ bool Database::addRating(int user_id, int movie_id, double rating) {
     sqlite3_bind_int(stmt, 1, user_id);
     sqlite3_bind_int(stmt, 2, movie_id);
     sqlite3_bind_double(stmt, 3, rating);
+    if (timestamp > 0) {
+        sqlite3_bind_int64(stmt, 4, timestamp);
+    }
     
     bool success = sqlite3_step(stmt) == SQLITE_DONE;
     sqlite3_finalize(stmt);
+
+    if (success) {
+        int64_t rated_at = timestamp > 0 ? timestamp : static_cast<int64_t>(std::time(nullptr));
+        for (const auto& observer : rating_observers) {
+            observer(user_id, movie_id, rating, rated_at);
+        }
+    }
     return success;
 }
 
+size_t Database::addRatingsBatch(const RatingInput* rows, size_t count, std::vector<RatingRowError>* errors,
+                                 size_t chunk_size) {
+    TRACE_SPAN("db.addRatingsBatch");
+    // A checagem de existência vai no próprio INSERT: sem linha inserida,
+    // o usuário ou o filme não existe
+    const char* sql =
+        "INSERT OR REPLACE INTO ratings (user_id, movie_id, rating, timestamp) "
+        "SELECT ?1, ?2, ?3, COALESCE(datetime(?4, 'unixepoch'), CURRENT_TIMESTAMP) "
+        "WHERE EXISTS (SELECT 1 FROM users WHERE id = ?1) AND EXISTS (SELECT 1 FROM movies WHERE id = ?2)";
+
+    auto reject = [errors](size_t index, const std::string& error) {
+        if (errors) errors->push_back({index, error});
+    };
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::string error = sqlite3_errmsg(db);
+        for (size_t i = 0; i < count; i++) reject(i, error);
+        return 0;
+    }
+
+    bool own_transaction = sqlite3_get_autocommit(db) != 0;
+    chunk_size = std::max<size_t>(1, chunk_size);
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    size_t inserted = 0;
+    std::vector<size_t> saved;
+
+    for (size_t begin = 0; begin < count; begin += chunk_size) {
+        size_t end = std::min(count, begin + chunk_size);
+        if (own_transaction) execute("BEGIN");
+
+        saved.clear();
+        for (size_t i = begin; i < end; i++) {
+            const RatingInput& row = rows[i];
+            if (row.rating < 0 || row.rating > 10) {
+                reject(i, "avaliação deve ser entre 0 e 10");
+                continue;
+            }
+
+            sqlite3_bind_int(stmt, 1, row.user_id);
+            sqlite3_bind_int(stmt, 2, row.movie_id);
+            sqlite3_bind_double(stmt, 3, row.rating);
+            if (row.timestamp > 0) {
+                sqlite3_bind_int64(stmt, 4, row.timestamp);
+            } else {
+                sqlite3_bind_null(stmt, 4);
+            }
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                reject(i, sqlite3_errmsg(db));
+            } else if (sqlite3_changes(db) == 0) {
+                reject(i, "usuário ou filme não encontrado");
+            } else {
+                saved.push_back(i);
+            }
+            sqlite3_reset(stmt);
+        }
+
+        if (own_transaction && !execute("COMMIT")) {
+            execute("ROLLBACK");
+            for (size_t i : saved) reject(i, "falha no COMMIT do lote");
+            continue;
+        }
+
+        inserted += saved.size();
+        for (size_t i : saved) {
+            const RatingInput& row = rows[i];
+            for (const auto& observer : rating_observers) {
+                observer(row.user_id, row.movie_id, row.rating, row.timestamp > 0 ? row.timestamp : now);
+            }
+        }
+    }
+
+    sqlite3_finalize(stmt);
+    return inserted;
+}
+
+void Database::addRatingObserver(RatingObserver observer) {
+    rating_observers.push_back(std::move(observer));
+}
+
 std::vector<Rating> Database::getUserRatings(int user_id) {
+    TRACE_SPAN("db.getUserRatings");
     std::vector<Rating> ratings;
     sqlite3_stmt* stmt;
     const char* sql = "SELECT id, user_id, movie_id, rating, timestamp FROM ratings WHERE user_id = ?";
@@ -329,7 +619,307 @@ std::vector<Rating> Database::getUserRatings(int user_id) {
     return ratings;
 }
 
+std::vector<Rating> Database::getRecentRatings(int user_id, int limit) {
+    TRACE_SPAN("db.getRecentRatings");
+    std::vector<Rating> ratings;
+    sqlite3_stmt* stmt;
+    const char* sql = R"(
+        SELECT id, user_id, movie_id, rating, timestamp FROM ratings
+        WHERE user_id = ?
+        ORDER BY timestamp DESC
+        LIMIT ?
+    )";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return ratings;
+    }
+
+    sqlite3_bind_int(stmt, 1, user_id);
+    sqlite3_bind_int(stmt, 2, limit);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        Rating rating;
+        rating.id = sqlite3_column_int(stmt, 0);
+        rating.user_id = sqlite3_column_int(stmt, 1);
+        rating.movie_id = sqlite3_column_int(stmt, 2);
+        rating.rating = sqlite3_column_double(stmt, 3);
+        const char* timestamp = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+        rating.timestamp = timestamp ? timestamp : "";
+        ratings.push_back(rating);
+    }
+
+    sqlite3_finalize(stmt);
+    return ratings;
+}
+
+int Database::countUserRatings(int user_id) {
+    TRACE_SPAN("db.countUserRatings");
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT COUNT(*) FROM ratings WHERE user_id = ?";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+
+    sqlite3_bind_int(stmt, 1, user_id);
+
+    int count = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+UserSummary Database::getUserSummary(int user_id, size_t recent_limit, size_t top_limit) {
+    TRACE_SPAN("db.getUserSummary");
+    UserSummary summary;
+    sqlite3_stmt* stmt;
+    // Mais recentes primeiro: as recent_limit primeiras linhas já são as recentes
+    const char* sql = R"(
+        SELECT r.movie_id, r.rating, r.timestamp, m.title, m.year, m.genre, m.poster_url
+        FROM ratings r
+        JOIN movies m ON m.id = r.movie_id
+        WHERE r.user_id = ?
+        ORDER BY r.timestamp DESC
+    )";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return summary;
+    }
+
+    sqlite3_bind_int(stmt, 1, user_id);
+
+    auto text = [&](int column) {
+        const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+        return std::string(value ? value : "");
+    };
+    // Heap de mínimo pela nota: só entra quem supera a menor, então no empate
+    // fica a avaliação mais recente (que veio antes)
+    auto lower_rating = [](const UserRatedMovie& a, const UserRatedMovie& b) { return a.rating > b.rating; };
+    std::map<std::string, std::pair<int, double>> genres;  // gênero → (avaliações, soma)
+    double sum = 0.0;
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        UserRatedMovie entry;
+        entry.movie_id = sqlite3_column_int(stmt, 0);
+        entry.rating = sqlite3_column_double(stmt, 1);
+        entry.timestamp = text(2);
+        entry.title = text(3);
+        entry.year = sqlite3_column_int(stmt, 4);
+        entry.genre = text(5);
+        entry.poster_url = text(6);
+
+        summary.rating_count++;
+        sum += entry.rating;
+        auto& genre = genres[entry.genre];
+        genre.first++;
+        genre.second += entry.rating;
+
+        if (summary.recent.size() < recent_limit) {
+            summary.recent.push_back(entry);
+        }
+        if (top_limit == 0) continue;
+        if (summary.top_rated.size() < top_limit) {
+            summary.top_rated.push_back(std::move(entry));
+            std::push_heap(summary.top_rated.begin(), summary.top_rated.end(), lower_rating);
+        } else if (entry.rating > summary.top_rated.front().rating) {
+            std::pop_heap(summary.top_rated.begin(), summary.top_rated.end(), lower_rating);
+            summary.top_rated.back() = std::move(entry);
+            std::push_heap(summary.top_rated.begin(), summary.top_rated.end(), lower_rating);
+        }
+    }
+
+    sqlite3_finalize(stmt);
+
+    if (summary.rating_count > 0) {
+        summary.average_rating = sum / summary.rating_count;
+    }
+    std::sort(summary.top_rated.begin(), summary.top_rated.end(),
+              [](const UserRatedMovie& a, const UserRatedMovie& b) {
+                  if (a.rating != b.rating) return a.rating > b.rating;
+                  return a.timestamp > b.timestamp;
+              });
+    for (const auto& genre : genres) {
+        summary.genres.push_back({genre.first, genre.second.first, genre.second.second / genre.second.first});
+    }
+    std::stable_sort(summary.genres.begin(), summary.genres.end(),
+                     [](const GenreRatingStats& a, const GenreRatingStats& b) { return a.count > b.count; });
+    return summary;
+}
+
+std::vector<Rating> Database::getAllRatings() {
+    TRACE_SPAN("db.getAllRatings");
+    std::vector<Rating> ratings;
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT id, user_id, movie_id, rating, timestamp FROM ratings";
+    
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return ratings;
+    }
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        Rating rating;
+        rating.id = sqlite3_column_int(stmt, 0);
+        rating.user_id = sqlite3_column_int(stmt, 1);
+        rating.movie_id = sqlite3_column_int(stmt, 2);
+        rating.rating = sqlite3_column_double(stmt, 3);
+        const unsigned char* timestamp = sqlite3_column_text(stmt, 4);
+        rating.timestamp = timestamp ? reinterpret_cast<const char*>(timestamp) : "";
+        ratings.push_back(rating);
+    }
+    
+    sqlite3_finalize(stmt);
+    return ratings;
+}
+
+bool Database::storeUserRecommendations(const RankedRow* rows, size_t count, int64_t computed_at) {
+    TRACE_SPAN("db.storeUserRecommendations");
+    return storeRankedRows(
+        "DELETE FROM user_recommendations WHERE user_id = ?",
+        "INSERT INTO user_recommendations (user_id, position, movie_id, score, source, computed_at) VALUES (?, ?, ?, ?, ?, ?)",
+        rows, count, computed_at);
+}
+
+bool Database::storeSimilarMovies(const RankedRow* rows, size_t count, int64_t computed_at) {
+    TRACE_SPAN("db.storeSimilarMovies");
+    return storeRankedRows(
+        "DELETE FROM similar_movies WHERE movie_id = ?",
+        "INSERT INTO similar_movies (movie_id, position, similar_id, score, computed_at) VALUES (?, ?, ?, ?, ?)",
+        rows, count, computed_at);
+}
+
+std::vector<StoredRankedRow> Database::getStoredUserRecommendations() {
+    TRACE_SPAN("db.getStoredUserRecommendations");
+    std::vector<StoredRankedRow> rows;
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT user_id, movie_id, score, source, computed_at FROM user_recommendations "
+                      "ORDER BY user_id, position";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return rows;
+    }
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        StoredRankedRow row;
+        row.owner_id = sqlite3_column_int(stmt, 0);
+        row.movie_id = sqlite3_column_int(stmt, 1);
+        row.score = sqlite3_column_double(stmt, 2);
+        const unsigned char* source = sqlite3_column_text(stmt, 3);
+        row.source = source ? reinterpret_cast<const char*>(source) : "";
+        row.computed_at = sqlite3_column_int64(stmt, 4);
+        rows.push_back(row);
+    }
+
+    sqlite3_finalize(stmt);
+    return rows;
+}
+
+std::vector<StoredRankedRow> Database::getStoredSimilarMovies(int movie_id, int limit) {
+    TRACE_SPAN("db.getStoredSimilarMovies");
+    std::vector<StoredRankedRow> rows;
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT similar_id, score, computed_at FROM similar_movies "
+                      "WHERE movie_id = ? ORDER BY position LIMIT ?";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return rows;
+    }
+
+    sqlite3_bind_int(stmt, 1, movie_id);
+    sqlite3_bind_int(stmt, 2, limit);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        StoredRankedRow row;
+        row.owner_id = movie_id;
+        row.movie_id = sqlite3_column_int(stmt, 0);
+        row.score = sqlite3_column_double(stmt, 1);
+        row.computed_at = sqlite3_column_int64(stmt, 2);
+        rows.push_back(row);
+    }
+
+    sqlite3_finalize(stmt);
+    return rows;
+}
+
+// Instruções preparadas uma vez e reaproveitadas em todas as linhas; o custo
+// do commit (fsync) é dividido pelo lote inteiro
+bool Database::storeRankedRows(const char* delete_sql, const char* insert_sql, const RankedRow* rows,
+                               size_t count, int64_t computed_at) {
+    if (count == 0) return true;
+
+    sqlite3_stmt* delete_stmt = nullptr;
+    sqlite3_stmt* insert_stmt = nullptr;
+    if (sqlite3_prepare_v2(db, delete_sql, -1, &delete_stmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, insert_sql, -1, &insert_stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(delete_stmt);
+        sqlite3_finalize(insert_stmt);
+        return false;
+    }
+
+    bool with_source = sqlite3_bind_parameter_count(insert_stmt) == 6;
+    bool success = execute("BEGIN");
+    for (size_t i = 0; success && i < count; i++) {
+        const RankedRow& row = rows[i];
+        if (i == 0 || rows[i - 1].owner_id != row.owner_id) {
+            sqlite3_bind_int(delete_stmt, 1, row.owner_id);
+            success = sqlite3_step(delete_stmt) == SQLITE_DONE;
+            sqlite3_reset(delete_stmt);
+        }
+
+        sqlite3_bind_int(insert_stmt, 1, row.owner_id);
+        sqlite3_bind_int(insert_stmt, 2, row.position);
+        sqlite3_bind_int(insert_stmt, 3, row.movie_id);
+        sqlite3_bind_double(insert_stmt, 4, row.score);
+        if (with_source) {
+            if (row.source) {
+                sqlite3_bind_text(insert_stmt, 5, row.source, -1, SQLITE_STATIC);
+            } else {
+                sqlite3_bind_null(insert_stmt, 5);
+            }
+            sqlite3_bind_int64(insert_stmt, 6, computed_at);
+        } else {
+            sqlite3_bind_int64(insert_stmt, 5, computed_at);
+        }
+        success = success && sqlite3_step(insert_stmt) == SQLITE_DONE;
+        sqlite3_reset(insert_stmt);
+    }
+
+    sqlite3_finalize(delete_stmt);
+    sqlite3_finalize(insert_stmt);
+
+    if (success) {
+        return execute("COMMIT");
+    }
+    LOG_ERROR("❌ Erro ao gravar lista pré-calculada: %s", sqlite3_errmsg(db));
+    execute("ROLLBACK");
+    return false;
+}
+
+std::vector<std::pair<int, int64_t>> Database::getRatingTimesSince(int64_t since) {
+    TRACE_SPAN("db.getRatingTimesSince");
+    std::vector<std::pair<int, int64_t>> events;
+    sqlite3_stmt* stmt;
+    const char* sql = "SELECT movie_id, CAST(strftime('%s', timestamp) AS INTEGER) FROM ratings "
+                      "WHERE timestamp >= datetime(?, 'unixepoch')";
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return events;
+    }
+
+    sqlite3_bind_int64(stmt, 1, since);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        events.push_back({sqlite3_column_int(stmt, 0), sqlite3_column_int64(stmt, 1)});
+    }
+
+    sqlite3_finalize(stmt);
+    return events;
+}
+
 double Database::getMovieAverageRating(int movie_id) {
+    TRACE_SPAN("db.getMovieAverageRating");
     sqlite3_stmt* stmt;
     const char* sql = "SELECT AVG(rating) FROM ratings WHERE movie_id = ?";
     
@@ -349,6 +939,7 @@ double Database::getMovieAverageRating(int movie_id) {
 }
 
 std::map<std::string, double> Database::getAverageRatingsByGenre() {
+    TRACE_SPAN("db.getAverageRatingsByGenre");
     std::map<std::string, double> genre_ratings;
     sqlite3_stmt* stmt;
     const char* sql = R"(
@@ -373,6 +964,7 @@ std::map<std::string, double> Database::getAverageRatingsByGenre() {
 }
 
 std::string Database::getMostWatchedGenre(int user_id) {
+    TRACE_SPAN("db.getMostWatchedGenre");
     sqlite3_stmt* stmt;
     const char* sql = R"(
         SELECT m.genre, COUNT(*) as watch_count
@@ -400,6 +992,7 @@ std::string Database::getMostWatchedGenre(int user_id) {
 }
 
 std::vector<Movie> Database::getRecommendations(int user_id, int limit) {
+    TRACE_SPAN("db.getRecommendations");
     std::vector<Movie> recommendations;
     std::string favorite_genre = getMostWatchedGenre(user_id);
     
@@ -2,9 +2,13 @@
 #define DATABASE_H
 
 #include <sqlite3.h>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <map>
+#include "duplicate_detector.h"
+#include "query_profiler.h"
 
 struct User {
     int id;
@@ -34,10 +38,92 @@ struct Rating {
     std::string timestamp;
 };
 
+// Entrada do feed de alterações do catálogo (movie só é preenchido se !deleted)
+struct MovieChange {
+    int64_t seq;
+    int movie_id;
+    bool deleted;
+    Movie movie;
+};
+
+// Avaliação do usuário com os dados do filme para exibição
+struct UserRatedMovie {
+    int movie_id;
+    int year;
+    std::string title;
+    std::string genre;
+    std::string poster_url;
+    double rating;
+    std::string timestamp;
+};
+
+struct GenreRatingStats {
+    std::string genre;
+    int count;
+    double average;
+};
+
+// Resumo do perfil: totais, gêneros (mais avaliados primeiro), as avaliações
+// mais recentes e as de maior nota (empate: a mais recente)
+struct UserSummary {
+    int rating_count = 0;
+    double average_rating = 0.0;
+    std::vector<GenreRatingStats> genres;
+    std::vector<UserRatedMovie> recent;
+    std::vector<UserRatedMovie> top_rated;
+};
+
+// Item de uma lista ranqueada materializada: recomendações de um usuário ou
+// filmes parecidos com um filme (owner_id é o usuário ou o filme de origem)
+struct RankedRow {
+    int owner_id;
+    int position;
+    int movie_id;
+    double score;
+    const char* source;  // modelo que gerou ("als", "cf", ...); nullptr se não se aplica
+};
+
+// Linha lida de user_recommendations ou similar_movies
+struct StoredRankedRow {
+    int owner_id;
+    int movie_id;
+    double score;
+    std::string source;   // vazio em similar_movies
+    int64_t computed_at;  // unix epoch, segundos
+};
+
+// Avaliação a gravar com addRatingsBatch
+struct RatingInput {
+    int user_id;
+    int movie_id;
+    double rating;
+    int64_t timestamp;  // unix epoch; 0 = agora
+};
+
+// Linha rejeitada por addRatingsBatch (index = posição na entrada)
+struct RatingRowError {
+    size_t index;
+    std::string error;
+};
+
+// Chamado após cada avaliação gravada com sucesso (com o db_mutex ainda preso);
+// timestamp em unix epoch
+using RatingObserver = std::function<void(int user_id, int movie_id, double rating, int64_t timestamp)>;
+
 class Database {
 private:
     sqlite3* db;
     std::string db_path;
+    QueryProfiler profiler;
+    std::vector<RatingObserver> rating_observers;
+    DuplicateDetector title_index;   // filmes por título/ano, carregado no primeiro uso
+    bool title_index_loaded;
+    bool title_index_in_transaction;  // alterado dentro de uma transação ainda aberta
+
+    void loadTitleIndex();
+    void noteTitleIndexChange();
+    bool storeRankedRows(const char* delete_sql, const char* insert_sql, const RankedRow* rows,
+                         size_t count, int64_t computed_at);
     
 public:
     Database(const std::string& path);
@@ -45,23 +131,60 @@ public:
     
     bool init();
     bool execute(const std::string& sql);
+    // Consulta genérica: on_row é chamado para cada linha (migrações, admin)
+    bool query(const std::string& sql, const std::function<void(sqlite3_stmt*)>& on_row);
+    // Primeira coluna da primeira linha; fallback se não houver linha ou for NULL
+    int64_t queryInt(const std::string& sql, int64_t fallback = 0);
+    QueryProfiler& queryProfiler() { return profiler; }
     
     int createUser(const std::string& username, const std::string& password_hash, bool is_admin = false);
     User* getUserByUsername(const std::string& username);
     User* getUserById(int id);
     
-    int createMovie(const Movie& movie);
+    // Filme com imdb_id já cadastrado é atualizado (upsert) e o id existente é
+    // devolvido; sem imdb_id, um título equivalente no mesmo ano (±1) também
+    // conta como o mesmo filme. `created` diz se uma linha nova foi inserida
+    int createMovie(const Movie& movie, bool* created = nullptr);
     Movie* getMovieById(int id);
     std::vector<Movie> getAllMovies();
     std::vector<Movie> getMoviesByGenre(const std::string& genre);
     bool updateMovie(const Movie& movie);
     bool deleteMovie(int id);
+    // Última alteração de cada filme com seq > since, em ordem de seq (até
+    // limit); false se o feed ainda não existe (migração pendente)
+    bool getMovieChanges(int64_t since, int limit, std::vector<MovieChange>& changes);
+    int64_t latestMovieChangeSeq();
     
-    bool addRating(int user_id, int movie_id, double rating);
+    // timestamp em unix epoch para importações; 0 = agora
+    bool addRating(int user_id, int movie_id, double rating, int64_t timestamp = 0);
+    // Muitas avaliações com um único prepared statement, em transações de até
+    // chunk_size linhas (dentro de uma transação já aberta, usa a do chamador).
+    // Nota fora de 0-10 ou usuário/filme inexistente rejeitam só a linha, que
+    // vai para `errors`; retorna quantas foram gravadas
+    size_t addRatingsBatch(const RatingInput* rows, size_t count, std::vector<RatingRowError>* errors = nullptr,
+                           size_t chunk_size = 10000);
+    void addRatingObserver(RatingObserver observer);
     std::vector<Rating> getUserRatings(int user_id);
+    // As `limit` avaliações mais recentes do usuário, da mais nova para a mais
+    // antiga (lidas direto do índice (user_id, timestamp DESC))
+    std::vector<Rating> getRecentRatings(int user_id, int limit);
+    int countUserRatings(int user_id);
+    // Tudo do perfil numa única passada pelas avaliações do usuário
+    UserSummary getUserSummary(int user_id, size_t recent_limit, size_t top_limit);
+    std::vector<Rating> getAllRatings();
+    // (movie_id, unix epoch) das avaliações a partir de `since` (unix epoch)
+    std::vector<std::pair<int, int64_t>> getRatingTimesSince(int64_t since);
     double getMovieAverageRating(int movie_id);
     std::map<std::string, double> getAverageRatingsByGenre();
     
+    // Gravam listas pré-calculadas numa única transação; as linhas de um mesmo
+    // dono devem estar contíguas e substituem a lista anterior dele
+    bool storeUserRecommendations(const RankedRow* rows, size_t count, int64_t computed_at);
+    bool storeSimilarMovies(const RankedRow* rows, size_t count, int64_t computed_at);
+    // Listas gravadas pelo último recálculo em lote, por dono e posição
+    std::vector<StoredRankedRow> getStoredUserRecommendations();
+    std::vector<StoredRankedRow> getStoredSimilarMovies(int movie_id, int limit);
+
     std::string getMostWatchedGenre(int user_id);
     std::vector<Movie> getRecommendations(int user_id, int limit = 10);
 };
@@ -0,0 +1,139 @@
+#include "duplicate_detector.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+DuplicateDetector::DuplicateDetector(int max_edits) : max_distance(std::max(0, max_edits)) {}
+
+std::string DuplicateDetector::normalizeTitle(const std::string& title) {
+    std::string normalized;
+    normalized.reserve(title.size());
+    bool pending_space = false;
+    for (unsigned char c : title) {
+        // Bytes UTF-8 (acentos) ficam como estão
+        if (std::isalnum(c) || c >= 0x80) {
+            if (pending_space && !normalized.empty()) normalized += ' ';
+            normalized += static_cast<char>(std::tolower(c));
+            pending_space = false;
+        } else {
+            pending_space = true;
+        }
+    }
+    if (normalized.compare(0, 4, "the ") == 0) {
+        normalized.erase(0, 4);
+    }
+    return normalized;
+}
+
+void DuplicateDetector::add(int movie_id, const std::string& title, int year) {
+    remove(movie_id);
+    Entry entry;
+    entry.normalized = normalizeTitle(title);
+    entry.digits = digitsOf(entry.normalized);
+    entry.year = year;
+    exact[entry.normalized].push_back(movie_id);
+    by_year[year].push_back(movie_id);
+    entries.emplace(movie_id, std::move(entry));
+}
+
+void DuplicateDetector::remove(int movie_id) {
+    auto it = entries.find(movie_id);
+    if (it == entries.end()) return;
+
+    auto title = exact.find(it->second.normalized);
+    if (title != exact.end()) {
+        erase(title->second, movie_id);
+        if (title->second.empty()) exact.erase(title);
+    }
+    auto year = by_year.find(it->second.year);
+    if (year != by_year.end()) {
+        erase(year->second, movie_id);
+        if (year->second.empty()) by_year.erase(year);
+    }
+    entries.erase(it);
+}
+
+void DuplicateDetector::clear() {
+    entries.clear();
+    exact.clear();
+    by_year.clear();
+}
+
+int DuplicateDetector::findDuplicate(const std::string& title, int year) const {
+    std::string normalized = normalizeTitle(title);
+    if (normalized.empty()) return 0;
+
+    auto same_title = exact.find(normalized);
+    if (same_title != exact.end()) {
+        for (int movie_id : same_title->second) {
+            if (std::abs(entries.at(movie_id).year - year) <= 1) return movie_id;
+        }
+    }
+
+    int limit = allowedDistance(normalized.size());
+    if (limit == 0) return 0;
+
+    std::string digits = digitsOf(normalized);
+    int best_id = 0;
+    int best_distance = limit + 1;
+    for (int candidate_year = year - 1; candidate_year <= year + 1; candidate_year++) {
+        auto bucket = by_year.find(candidate_year);
+        if (bucket == by_year.end()) continue;
+
+        for (int movie_id : bucket->second) {
+            const Entry& entry = entries.at(movie_id);
+            if (entry.digits != digits) continue;
+            const std::string& other = entry.normalized;
+            size_t gap = other.size() > normalized.size() ? other.size() - normalized.size()
+                                                          : normalized.size() - other.size();
+            if (static_cast<int>(gap) >= best_distance) continue;
+
+            int distance = boundedEditDistance(normalized, other, best_distance - 1);
+            if (distance < best_distance) {
+                best_distance = distance;
+                best_id = movie_id;
+            }
+        }
+    }
+    return best_id;
+}
+
+int DuplicateDetector::allowedDistance(size_t length) const {
+    // "Up" e "Us" são filmes diferentes: títulos curtos só batem exatos
+    if (length <= 4) return 0;
+    if (length <= 10) return std::min(1, max_distance);
+    return max_distance;
+}
+
+int DuplicateDetector::boundedEditDistance(const std::string& a, const std::string& b, int limit) {
+    if (limit < 0) return 0;
+    std::vector<int> previous(b.size() + 1);
+    std::vector<int> current(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) previous[j] = static_cast<int>(j);
+
+    for (size_t i = 1; i <= a.size(); i++) {
+        current[0] = static_cast<int>(i);
+        int row_min = current[0];
+        for (size_t j = 1; j <= b.size(); j++) {
+            int substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitution});
+            row_min = std::min(row_min, current[j]);
+        }
+        // Nenhum caminho desta linha em diante volta para dentro do limite
+        if (row_min > limit) return limit + 1;
+        previous.swap(current);
+    }
+    return std::min(previous[b.size()], limit + 1);
+}
+
+void DuplicateDetector::erase(std::vector<int>& ids, int movie_id) {
+    ids.erase(std::remove(ids.begin(), ids.end(), movie_id), ids.end());
+}
+
+std::string DuplicateDetector::digitsOf(const std::string& normalized) {
+    std::string digits;
+    for (unsigned char c : normalized) {
+        if (std::isdigit(c)) digits += static_cast<char>(c);
+    }
+    return digits;
+}
@@ -0,0 +1,49 @@
+#ifndef DUPLICATE_DETECTOR_H
+#define DUPLICATE_DETECTOR_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Detecta filmes repetidos sem imdb_id (ex.: dados de demonstração de
+// createMockMovie) pelo título normalizado e pelo ano. Primeiro tenta o título
+// exato; depois compara com os títulos do mesmo ano (±1) e comprimento
+// parecido usando distância de edição limitada, que desiste assim que passa
+// do limite. Números precisam bater ("Toy Story 2" não é "Toy Story 3").
+// Não é thread-safe: o Database usa sob o db_mutex.
+class DuplicateDetector {
+public:
+    // max_distance: edições toleradas em títulos longos (curtos exigem menos)
+    explicit DuplicateDetector(int max_distance = 2);
+
+    // Minúsculas, pontuação vira espaço, espaços colapsados, sem "the " inicial
+    static std::string normalizeTitle(const std::string& title);
+
+    void add(int movie_id, const std::string& title, int year);
+    void remove(int movie_id);
+    void clear();
+
+    // id de um filme já registrado equivalente a (title, year); 0 se não houver
+    int findDuplicate(const std::string& title, int year) const;
+    size_t size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        std::string normalized;
+        std::string digits;  // só os dígitos do título
+        int year;
+    };
+
+    int max_distance;
+    std::unordered_map<int, Entry> entries;                    // movie_id → título normalizado
+    std::unordered_map<std::string, std::vector<int>> exact;   // título normalizado → movie_ids
+    std::unordered_map<int, std::vector<int>> by_year;         // ano → movie_ids
+
+    int allowedDistance(size_t length) const;
+    // Distância de Levenshtein ou limit + 1 se passar de limit
+    static int boundedEditDistance(const std::string& a, const std::string& b, int limit);
+    static void erase(std::vector<int>& ids, int movie_id);
+    static std::string digitsOf(const std::string& normalized);
+};
+
+#endif
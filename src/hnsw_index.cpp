@@ -0,0 +1,454 @@
+#include "hnsw_index.h"
+#include "logger.h"
+#include "simd_kernels.h"
+#include "tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <thread>
+
+namespace {
+    const char kMagic[8] = {'C', 'I', 'N', 'E', 'H', 'N', 'S', 'W'};
+    const uint32_t kFormatVersion = 2;   // 2: fingerprint da origem no cabeçalho
+
+    // Marcação de visitados por geração: evita limpar o vetor a cada busca
+    struct VisitedSet {
+        std::vector<uint32_t> marks;
+        uint32_t generation = 0;
+
+        void reset(size_t size) {
+            if (marks.size() < size) marks.resize(size, 0);
+            if (++generation == 0) {
+                std::fill(marks.begin(), marks.end(), 0);
+                generation = 1;
+            }
+        }
+        bool visit(uint32_t node) {
+            if (marks[node] == generation) return false;
+            marks[node] = generation;
+            return true;
+        }
+    };
+
+    thread_local VisitedSet visited;
+
+    void normalize(float* vector, size_t dim) {
+        float norm = std::sqrt(scoringKernels().dot(vector, vector, dim));
+        if (norm > 0.0f) {
+            for (size_t d = 0; d < dim; d++) vector[d] /= norm;
+        }
+    }
+}
+
+HnswIndex::HnswIndex(size_t dimension, const HnswOptions& options)
+    : dim(dimension), opts(options), dot(scoringKernels().dot) {
+    opts.M = std::max(2, opts.M);
+    opts.ef_construction = std::max(opts.M, opts.ef_construction);
+    level_multiplier = 1.0 / std::log(static_cast<double>(opts.M));
+}
+
+float HnswIndex::distance(const float* a, const float* b) const {
+    return 1.0f - dot(a, b, dim);
+}
+
+int HnswIndex::randomLevel(std::mt19937& rng) const {
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    double r = uniform(rng);
+    return static_cast<int>(-std::log(std::max(r, 1e-12)) * level_multiplier);
+}
+
+size_t HnswIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(structure_mutex);
+    return nodes.size();
+}
+
+bool HnswIndex::contains(int label) const {
+    std::shared_lock<std::shared_mutex> lock(structure_mutex);
+    return label_index.count(label) > 0;
+}
+
+// ===== CONSTRUÇÃO =====
+void HnswIndex::build(const std::vector<int>& labels, const std::vector<float>& vectors) {
+    TRACE_SPAN("hnsw.build");
+    auto started = std::chrono::steady_clock::now();
+    std::unique_lock<std::shared_mutex> lock(structure_mutex);
+
+    // Nós e níveis são criados antes das threads: durante o build paralelo
+    // os vetores não realocam e cada thread só toca links sob o mutex do nó
+    std::mt19937 rng(opts.seed);
+    size_t first = nodes.size();
+    std::vector<uint32_t> pending;
+    for (size_t i = 0; i < labels.size(); i++) {
+        if (label_index.count(labels[i])) continue;
+        uint32_t node = static_cast<uint32_t>(nodes.size());
+        label_index[labels[i]] = node;
+
+        Node entry;
+        entry.label = labels[i];
+        entry.level = randomLevel(rng);
+        entry.links.resize(entry.level + 1);
+        nodes.push_back(std::move(entry));
+        node_mutexes.emplace_back();
+
+        data.insert(data.end(), vectors.begin() + i * dim, vectors.begin() + (i + 1) * dim);
+        if (opts.metric == VectorMetric::Cosine) normalize(&data[static_cast<size_t>(node) * dim], dim);
+        pending.push_back(node);
+    }
+
+    int threads = opts.threads > 0 ? opts.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(pending.size())));
+
+    // O primeiro nó vira o ponto de entrada antes do paralelismo
+    size_t start = 0;
+    if (entry_point < 0 && !pending.empty()) {
+        insert(pending[0], false);
+        start = 1;
+    }
+
+    std::atomic<size_t> next(start);
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < pending.size(); i = next.fetch_add(1)) {
+            insert(pending[i], threads > 1);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    LOG_INFO("🧭 HNSW: %zu vetores (dim %zu, M %d, ef %d) indexados em %.2f s (%d threads)",
+             nodes.size() - first, dim, opts.M, opts.ef_construction, seconds, threads);
+}
+
+bool HnswIndex::add(int label, const float* vector) {
+    std::unique_lock<std::shared_mutex> lock(structure_mutex);
+    if (label_index.count(label)) return false;
+
+    uint32_t node = static_cast<uint32_t>(nodes.size());
+    label_index[label] = node;
+
+    thread_local std::mt19937 rng(std::random_device{}());
+    Node entry;
+    entry.label = label;
+    entry.level = randomLevel(rng);
+    entry.links.resize(entry.level + 1);
+    nodes.push_back(std::move(entry));
+    node_mutexes.emplace_back();
+
+    data.insert(data.end(), vector, vector + dim);
+    if (opts.metric == VectorMetric::Cosine) normalize(&data[static_cast<size_t>(node) * dim], dim);
+
+    insert(node, false);
+    return true;
+}
+
+std::vector<uint32_t> HnswIndex::linksOf(uint32_t node, int level, bool concurrent) const {
+    if (!concurrent) return nodes[node].links[level];
+    std::lock_guard<std::mutex> lock(node_mutexes[node]);
+    return nodes[node].links[level];
+}
+
+void HnswIndex::insert(uint32_t node, bool concurrent) {
+    const float* query = vectorOf(node);
+    const int level = nodes[node].level;
+
+    // Nó acima do topo atual: segura o ponto de entrada até terminar
+    std::unique_lock<std::mutex> entry_lock(entry_mutex);
+    int64_t entry = entry_point;
+    int top = max_level;
+    if (entry < 0) {
+        entry_point = node;
+        max_level = level;
+        return;
+    }
+    if (level <= top) {
+        entry_lock.unlock();
+    }
+
+    uint32_t current = static_cast<uint32_t>(entry);
+    float current_distance = distance(query, vectorOf(current));
+    for (int l = top; l > level; l--) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t neighbor : linksOf(current, l, concurrent)) {
+                float d = distance(query, vectorOf(neighbor));
+                if (d < current_distance) {
+                    current_distance = d;
+                    current = neighbor;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::vector<Candidate> entry_points = {{current_distance, current}};
+    for (int l = std::min(level, top); l >= 0; l--) {
+        std::vector<Candidate> found = searchLayer(query, entry_points, opts.ef_construction, l, concurrent);
+        std::vector<uint32_t> neighbors = selectNeighbors(found, opts.M);
+
+        if (concurrent) {
+            std::lock_guard<std::mutex> lock(node_mutexes[node]);
+            nodes[node].links[l] = neighbors;
+        } else {
+            nodes[node].links[l] = neighbors;
+        }
+        for (uint32_t neighbor : neighbors) {
+            connect(neighbor, node, l, concurrent);
+        }
+        entry_points = std::move(found);
+    }
+
+    if (level > top) {
+        entry_point = node;
+        max_level = level;
+    }
+}
+
+// Liga from → to; se a lista estourar, poda pela heurística de diversidade
+void HnswIndex::connect(uint32_t from, uint32_t to, int level, bool concurrent) {
+    std::unique_lock<std::mutex> lock;
+    if (concurrent) lock = std::unique_lock<std::mutex>(node_mutexes[from]);
+
+    std::vector<uint32_t>& links = nodes[from].links[level];
+    if (std::find(links.begin(), links.end(), to) != links.end()) return;
+
+    size_t max_links = level == 0 ? 2 * opts.M : opts.M;
+    if (links.size() < max_links) {
+        links.push_back(to);
+        return;
+    }
+
+    const float* base = vectorOf(from);
+    std::vector<Candidate> candidates;
+    candidates.reserve(links.size() + 1);
+    candidates.push_back({distance(base, vectorOf(to)), to});
+    for (uint32_t link : links) {
+        candidates.push_back({distance(base, vectorOf(link)), link});
+    }
+    links = selectNeighbors(std::move(candidates), max_links);
+}
+
+// Heurística do artigo: mantém um candidato só se ele estiver mais perto da
+// consulta do que de qualquer vizinho já escolhido (espalha os links)
+std::vector<uint32_t> HnswIndex::selectNeighbors(std::vector<Candidate> candidates, size_t m) const {
+    std::sort(candidates.begin(), candidates.end());
+    std::vector<uint32_t> selected;
+    selected.reserve(m);
+    for (const Candidate& candidate : candidates) {
+        if (selected.size() >= m) break;
+        bool keep = true;
+        for (uint32_t chosen : selected) {
+            if (distance(vectorOf(candidate.node), vectorOf(chosen)) < candidate.distance) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) selected.push_back(candidate.node);
+    }
+    return selected;
+}
+
+std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const float* query, const std::vector<Candidate>& entry_points,
+                                                         size_t ef, int level, bool concurrent) const {
+    visited.reset(nodes.size());
+
+    // candidates: mais próximo primeiro; results: mais distante no topo
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> candidates;
+    std::priority_queue<Candidate> results;
+    for (const Candidate& entry : entry_points) {
+        if (!visited.visit(entry.node)) continue;
+        candidates.push(entry);
+        results.push(entry);
+        if (results.size() > ef) results.pop();
+    }
+
+    while (!candidates.empty()) {
+        Candidate closest = candidates.top();
+        if (closest.distance > results.top().distance && results.size() >= ef) break;
+        candidates.pop();
+
+        // Fora do build paralelo os links não mudam: itera sem copiar
+        std::vector<uint32_t> copied;
+        const std::vector<uint32_t>* links = &nodes[closest.node].links[level];
+        if (concurrent) {
+            copied = linksOf(closest.node, level, true);
+            links = &copied;
+        }
+
+        for (uint32_t neighbor : *links) {
+            if (!visited.visit(neighbor)) continue;
+            float d = distance(query, vectorOf(neighbor));
+            if (results.size() < ef || d < results.top().distance) {
+                candidates.push({d, neighbor});
+                results.push({d, neighbor});
+                if (results.size() > ef) results.pop();
+            }
+        }
+    }
+
+    std::vector<Candidate> found;
+    found.reserve(results.size());
+    while (!results.empty()) {
+        found.push_back(results.top());
+        results.pop();
+    }
+    std::reverse(found.begin(), found.end());
+    return found;
+}
+
+// ===== CONSULTA =====
+std::vector<ScoredMovie> HnswIndex::search(const float* query_vector, size_t k, size_t ef) const {
+    TRACE_SPAN("hnsw.search");
+    std::shared_lock<std::shared_mutex> lock(structure_mutex);
+    if (nodes.empty() || entry_point < 0 || k == 0) return {};
+
+    std::vector<float> query(query_vector, query_vector + dim);
+    if (opts.metric == VectorMetric::Cosine) normalize(query.data(), dim);
+
+    uint32_t current = static_cast<uint32_t>(entry_point);
+    float current_distance = distance(query.data(), vectorOf(current));
+    for (int l = max_level; l > 0; l--) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint32_t neighbor : nodes[current].links[l]) {
+                float d = distance(query.data(), vectorOf(neighbor));
+                if (d < current_distance) {
+                    current_distance = d;
+                    current = neighbor;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    size_t width = std::max(k, ef > 0 ? ef : static_cast<size_t>(opts.ef_search));
+    std::vector<Candidate> found = searchLayer(query.data(), {{current_distance, current}}, width, 0, false);
+
+    std::vector<ScoredMovie> result;
+    for (size_t i = 0; i < found.size() && result.size() < k; i++) {
+        result.push_back({nodes[found[i].node].label, 1.0 - found[i].distance});
+    }
+    return result;
+}
+
+// ===== PERSISTÊNCIA =====
+bool HnswIndex::save(const std::string& path) const {
+    std::shared_lock<std::shared_mutex> lock(structure_mutex);
+
+    std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("❌ Não foi possível gravar o índice HNSW em %s", path.c_str());
+        return false;
+    }
+
+    uint32_t header[11] = {
+        kFormatVersion, static_cast<uint32_t>(dim), static_cast<uint32_t>(opts.M),
+        static_cast<uint32_t>(opts.ef_construction), static_cast<uint32_t>(opts.ef_search),
+        static_cast<uint32_t>(opts.metric), static_cast<uint32_t>(nodes.size()),
+        static_cast<uint32_t>(entry_point), static_cast<uint32_t>(max_level),
+        static_cast<uint32_t>(source_fingerprint), static_cast<uint32_t>(source_fingerprint >> 32)
+    };
+    bool ok = std::fwrite(kMagic, sizeof(kMagic), 1, file) == 1 &&
+              std::fwrite(header, sizeof(header), 1, file) == 1;
+
+    for (size_t n = 0; ok && n < nodes.size(); n++) {
+        const Node& node = nodes[n];
+        int32_t fields[2] = {node.label, node.level};
+        ok = std::fwrite(fields, sizeof(fields), 1, file) == 1;
+        for (int l = 0; ok && l <= node.level; l++) {
+            uint32_t count = static_cast<uint32_t>(node.links[l].size());
+            ok = std::fwrite(&count, sizeof(count), 1, file) == 1 &&
+                 std::fwrite(node.links[l].data(), sizeof(uint32_t), count, file) == count;
+        }
+    }
+    ok = ok && std::fwrite(data.data(), sizeof(float), data.size(), file) == data.size();
+    ok = std::fclose(file) == 0 && ok;
+
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        LOG_ERROR("❌ Falha ao gravar o índice HNSW em %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<HnswIndex> HnswIndex::load(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return nullptr;
+
+    std::fseek(file, 0, SEEK_END);
+    long file_size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    char magic[8];
+    uint32_t header[11];
+    bool ok = std::fread(magic, sizeof(magic), 1, file) == 1 &&
+              std::memcmp(magic, kMagic, sizeof(kMagic)) == 0 &&
+              std::fread(header, sizeof(header), 1, file) == 1 &&
+              header[0] == kFormatVersion && header[1] > 0;
+    // Só os vetores já ocupam count * dim floats: um cabeçalho corrompido
+    // não pode pedir mais memória do que o arquivo tem
+    ok = ok && file_size > 0 &&
+         static_cast<uint64_t>(header[6]) * header[1] * sizeof(float) <= static_cast<uint64_t>(file_size);
+    if (!ok) {
+        std::fclose(file);
+        LOG_WARN("⚠️ Arquivo de índice HNSW inválido: %s", path.c_str());
+        return nullptr;
+    }
+
+    HnswOptions options;
+    options.M = static_cast<int>(header[2]);
+    options.ef_construction = static_cast<int>(header[3]);
+    options.ef_search = static_cast<int>(header[4]);
+    options.metric = static_cast<VectorMetric>(header[5]);
+    std::shared_ptr<HnswIndex> index = std::make_shared<HnswIndex>(header[1], options);
+    index->source_fingerprint = static_cast<uint64_t>(header[9]) | (static_cast<uint64_t>(header[10]) << 32);
+
+    uint32_t count = header[6];
+    index->entry_point = count == 0 ? -1 : static_cast<int64_t>(header[7]);
+    index->max_level = count == 0 ? -1 : static_cast<int>(header[8]);
+    index->nodes.resize(count);
+    for (uint32_t n = 0; ok && n < count; n++) {
+        Node& node = index->nodes[n];
+        int32_t fields[2];
+        ok = std::fread(fields, sizeof(fields), 1, file) == 1 && fields[1] >= 0 && fields[1] < 64;
+        if (!ok) break;
+        node.label = fields[0];
+        node.level = fields[1];
+        node.links.resize(node.level + 1);
+        for (int l = 0; ok && l <= node.level; l++) {
+            uint32_t links = 0;
+            ok = std::fread(&links, sizeof(links), 1, file) == 1 && links <= count;
+            if (!ok) break;
+            node.links[l].resize(links);
+            ok = std::fread(node.links[l].data(), sizeof(uint32_t), links, file) == links &&
+                 std::all_of(node.links[l].begin(), node.links[l].end(), [count](uint32_t id) { return id < count; });
+        }
+        index->label_index[node.label] = n;
+        index->node_mutexes.emplace_back();
+    }
+    index->data.resize(static_cast<size_t>(count) * index->dim);
+    ok = ok && std::fread(index->data.data(), sizeof(float), index->data.size(), file) == index->data.size();
+    std::fclose(file);
+
+    // A busca começa no ponto de entrada e desce a partir de max_level
+    if (ok && count > 0) {
+        ok = header[7] < count && header[8] < index->nodes[header[7]].links.size();
+    }
+
+    if (!ok) {
+        LOG_WARN("⚠️ Arquivo de índice HNSW truncado ou corrompido: %s", path.c_str());
+        return nullptr;
+    }
+
+    LOG_INFO("📂 Índice HNSW carregado de %s (%u vetores, dim %zu)", path.c_str(), count, index->dim);
+    return index;
+}
@@ -0,0 +1,99 @@
+#ifndef HNSW_INDEX_H
+#define HNSW_INDEX_H
+
+#include "ratings_matrix.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class VectorMetric {
+    Cosine,        // vetores normalizados na inserção; score = cosseno
+    InnerProduct   // score = produto escalar (ex.: fatores ALS de usuário × filme)
+};
+
+struct HnswOptions {
+    int M = 16;                  // vizinhos por nó nas camadas superiores (2·M na camada 0)
+    int ef_construction = 200;   // largura da busca durante a inserção
+    int ef_search = 64;          // largura padrão da busca nas consultas
+    int threads = 0;             // build: 0 = std::thread::hardware_concurrency()
+    VectorMetric metric = VectorMetric::Cosine;
+    unsigned seed = 100;
+};
+
+// Índice HNSW (Malkov & Yashunin) para busca aproximada de vizinhos.
+// Rótulos são IDs do banco (ex.: movie_id). Consultas concorrentes são
+// seguras; add() bloqueia as consultas apenas durante a própria inserção.
+class HnswIndex {
+public:
+    HnswIndex(size_t dimension, const HnswOptions& options = HnswOptions());
+
+    // Constrói em paralelo a partir de vetores contíguos (rótulo i → vectors[i * dim])
+    void build(const std::vector<int>& labels, const std::vector<float>& vectors);
+
+    // Inserção incremental; false se o rótulo já existir
+    bool add(int label, const float* vector);
+
+    // Os k vizinhos mais próximos (maior score primeiro). ef = 0 usa ef_search.
+    std::vector<ScoredMovie> search(const float* query, size_t k, size_t ef = 0) const;
+
+    bool save(const std::string& path) const;
+    static std::shared_ptr<HnswIndex> load(const std::string& path);
+
+    size_t size() const;
+    size_t dimension() const { return dim; }
+    bool contains(int label) const;
+    const HnswOptions& options() const { return opts; }
+
+    // Identifica a origem dos vetores (ex.: ContentIndex::fingerprint()); vai
+    // no arquivo para quem carrega saber se o índice ainda corresponde a ela
+    void setFingerprint(uint64_t value) { source_fingerprint = value; }
+    uint64_t fingerprint() const { return source_fingerprint; }
+
+private:
+    struct Node {
+        int label = 0;
+        int level = 0;
+        std::vector<std::vector<uint32_t>> links;   // links[camada]
+    };
+
+    struct Candidate {
+        float distance;
+        uint32_t node;
+        bool operator<(const Candidate& other) const { return distance < other.distance; }
+        bool operator>(const Candidate& other) const { return distance > other.distance; }
+    };
+
+    size_t dim;
+    HnswOptions opts;
+    float (*dot)(const float*, const float*, size_t);   // kernel SIMD escolhido na construção
+    double level_multiplier;
+
+    mutable std::shared_mutex structure_mutex;   // add() exclusivo, consultas compartilhadas
+    std::vector<Node> nodes;
+    mutable std::deque<std::mutex> node_mutexes; // usados só no build paralelo
+    std::vector<float> data;                     // vetores na ordem dos nós
+    std::unordered_map<int, uint32_t> label_index;
+
+    std::mutex entry_mutex;
+    int64_t entry_point = -1;
+    int max_level = -1;
+    uint64_t source_fingerprint = 0;
+
+    float distance(const float* a, const float* b) const;
+    const float* vectorOf(uint32_t node) const { return &data[static_cast<size_t>(node) * dim]; }
+    int randomLevel(std::mt19937& rng) const;
+
+    void insert(uint32_t node, bool concurrent);
+    std::vector<Candidate> searchLayer(const float* query, const std::vector<Candidate>& entry_points,
+                                       size_t ef, int level, bool concurrent) const;
+    std::vector<uint32_t> selectNeighbors(std::vector<Candidate> candidates, size_t m) const;
+    std::vector<uint32_t> linksOf(uint32_t node, int level, bool concurrent) const;
+    void connect(uint32_t from, uint32_t to, int level, bool concurrent);
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "http_metrics.h"
+#include "logger.h"
+
+void UpstreamMetrics::reset() {
+    requests.store(0, std::memory_order_relaxed);
+    errors.store(0, std::memory_order_relaxed);
+    timeouts.store(0, std::memory_order_relaxed);
+    bytes_sent.store(0, std::memory_order_relaxed);
+    bytes_received.store(0, std::memory_order_relaxed);
+    status_2xx.store(0, std::memory_order_relaxed);
+    status_4xx.store(0, std::memory_order_relaxed);
+    status_5xx.store(0, std::memory_order_relaxed);
+    for (auto& counter : errors_by_code) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    dns.reset();
+    connect.reset();
+    tls.reset();
+    first_byte.reset();
+    total.reset();
+    response_size.reset();
+}
+
+HttpMetrics& HttpMetrics::instance() {
+    static HttpMetrics metrics;
+    return metrics;
+}
+
+HttpMetrics::HttpMetrics() {
+    slots[0].name = "omdb";
+    slots[1].name = "openrouter";
+    slots[2].name = "other";
+}
+
+UpstreamMetrics& HttpMetrics::upstream(const char* name) {
+    for (int i = 0; i < kUpstreams - 1; i++) {
+        if (slots[i].name == name) return slots[i];
+    }
+    return slots[kUpstreams - 1];
+}
+
+void HttpMetrics::recordTransfer(const char* upstream_name, CURL* curl, CURLcode result) {
+    UpstreamMetrics& metrics = upstream(upstream_name);
+    metrics.requests.fetch_add(1, std::memory_order_relaxed);
+
+    if (result != CURLE_OK) {
+        metrics.errors.fetch_add(1, std::memory_order_relaxed);
+        if (result == CURLE_OPERATION_TIMEDOUT) {
+            metrics.timeouts.fetch_add(1, std::memory_order_relaxed);
+        }
+        int code = static_cast<int>(result);
+        if (code >= 0 && code < UpstreamMetrics::kMaxCurlCode) {
+            metrics.errors_by_code[code].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Todos os tempos do libcurl são acumulados desde o início da transferência
+    curl_off_t namelookup = 0, connect = 0, appconnect = 0, pretransfer = 0, starttransfer = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+    curl_off_t uploaded = 0, downloaded = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+
+    // Conexões reaproveitadas não passam por DNS/conexão/TLS (tempos zerados)
+    if (namelookup > 0) {
+        metrics.dns.record(namelookup);
+    }
+    if (connect > 0) {
+        metrics.connect.record(connect > namelookup ? connect - namelookup : 0);
+        if (appconnect > 0) {
+            metrics.tls.record(appconnect > connect ? appconnect - connect : 0);
+        }
+    }
+    if (starttransfer > 0) {
+        metrics.first_byte.record(starttransfer > pretransfer ? starttransfer - pretransfer : 0);
+    }
+    metrics.total.record(total);
+
+    metrics.bytes_sent.fetch_add(uploaded, std::memory_order_relaxed);
+    metrics.bytes_received.fetch_add(downloaded, std::memory_order_relaxed);
+    if (result == CURLE_OK) {
+        metrics.response_size.record(downloaded);
+    }
+
+    if (status >= 200 && status < 300) {
+        metrics.status_2xx.fetch_add(1, std::memory_order_relaxed);
+    } else if (status >= 400 && status < 500) {
+        metrics.status_4xx.fetch_add(1, std::memory_order_relaxed);
+    } else if (status >= 500) {
+        metrics.status_5xx.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    LOG_DEBUG("🌐 %s: status %ld, dns %.1f ms, conexão %.1f ms, tls %.1f ms, primeiro byte %.1f ms, total %.1f ms, %lld bytes",
+              metrics.name.c_str(), status,
+              namelookup / 1000.0,
+              connect > namelookup ? (connect - namelookup) / 1000.0 : 0.0,
+              appconnect > connect ? (appconnect - connect) / 1000.0 : 0.0,
+              starttransfer > pretransfer ? (starttransfer - pretransfer) / 1000.0 : 0.0,
+              total / 1000.0,
+              static_cast<long long>(downloaded));
+}
+
+std::vector<const UpstreamMetrics*> HttpMetrics::upstreams() const {
+    std::vector<const UpstreamMetrics*> result;
+    for (const auto& slot : slots) {
+        result.push_back(&slot);
+    }
+    return result;
+}
+
+void HttpMetrics::reset() {
+    for (auto& slot : slots) {
+        slot.reset();
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef HTTP_METRICS_H
+#define HTTP_METRICS_H
+
+#include "metrics.h"
+#include <curl/curl.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Métricas de um serviço externo (OMDB, OpenRouter...). As fases vêm de
+// CURLINFO_*_TIME_T e são registradas já separadas (não acumuladas):
+// dns, conexão TCP, handshake TLS, espera pelo primeiro byte e total.
+struct UpstreamMetrics {
+    static constexpr int kMaxCurlCode = 128;
+
+    std::string name;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> status_2xx{0};
+    std::atomic<uint64_t> status_4xx{0};
+    std::atomic<uint64_t> status_5xx{0};
+    std::atomic<uint64_t> errors_by_code[kMaxCurlCode] = {};
+
+    LatencyHistogram dns;
+    LatencyHistogram connect;
+    LatencyHistogram tls;
+    LatencyHistogram first_byte;   // do envio da requisição até o primeiro byte (tempo do servidor)
+    LatencyHistogram total;
+    LatencyHistogram response_size; // bytes recebidos, nos mesmos buckets de potência de 2
+
+    void reset();
+};
+
+// Registro global por serviço. Os nomes vêm de MovieAPI::upstreamName;
+// nomes desconhecidos são contabilizados em "other".
+class HttpMetrics {
+public:
+    static HttpMetrics& instance();
+
+    // Chamado logo após curl_easy_perform, antes do curl_easy_cleanup
+    void recordTransfer(const char* upstream, CURL* curl, CURLcode result);
+
+    std::vector<const UpstreamMetrics*> upstreams() const;
+    void reset();
+
+private:
+    static constexpr int kUpstreams = 3;
+
+    UpstreamMetrics slots[kUpstreams];
+
+    HttpMetrics();
+    UpstreamMetrics& upstream(const char* name);
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "item_cf.h"
+#include "logger.h"
+#include "tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+std::shared_ptr<ItemCFModel> ItemCFModel::train(RatingsMatrix ratings, const ItemCFOptions& opts) {
+    TRACE_SPAN("itemcf.train");
+    auto started = std::chrono::steady_clock::now();
+
+    std::shared_ptr<ItemCFModel> model(new ItemCFModel());
+    model->matrix = std::move(ratings);
+    model->options = opts;
+
+    const RatingsMatrix& m = model->matrix;
+    const int items = static_cast<int>(m.itemCount());
+    const size_t k = static_cast<size_t>(std::max(1, opts.neighbors));
+
+    // Valores centralizados no layout CSC, na mesma ordem de colUsers()
+    std::vector<float> centered(m.colValues());
+    std::vector<float> centered_rows(m.rowValues());
+    if (opts.adjusted) {
+        for (int i = 0; i < items; i++) {
+            for (uint32_t p = m.colBegin(i); p < m.colEnd(i); p++) {
+                centered[p] -= m.userMean(m.colUsers()[p]);
+            }
+        }
+        for (int u = 0; u < static_cast<int>(m.userCount()); u++) {
+            for (uint32_t p = m.rowBegin(u); p < m.rowEnd(u); p++) {
+                centered_rows[p] -= m.userMean(u);
+            }
+        }
+    }
+
+    std::vector<float> norms(items, 0.0f);
+    for (int i = 0; i < items; i++) {
+        double sum = 0.0;
+        for (uint32_t p = m.colBegin(i); p < m.colEnd(i); p++) {
+            sum += static_cast<double>(centered[p]) * centered[p];
+        }
+        norms[i] = static_cast<float>(std::sqrt(sum));
+    }
+
+    // Cada thread pega o próximo filme livre e calcula seus K vizinhos com
+    // um acumulador denso próprio (sem compartilhamento entre threads).
+    std::vector<std::vector<Neighbor>> per_item(items);
+    std::atomic<int> next_item(0);
+
+    int thread_count = opts.threads > 0 ? opts.threads : static_cast<int>(std::thread::hardware_concurrency());
+    thread_count = std::max(1, std::min(thread_count, std::max(1, items)));
+
+    auto worker = [&]() {
+        std::vector<float> dot(items, 0.0f);
+        std::vector<int> overlap(items, 0);
+        std::vector<int> touched;
+        std::vector<Neighbor> candidates;
+
+        for (int i = next_item.fetch_add(1); i < items; i = next_item.fetch_add(1)) {
+            touched.clear();
+            for (uint32_t p = m.colBegin(i); p < m.colEnd(i); p++) {
+                int user = m.colUsers()[p];
+                float ci = centered[p];
+                for (uint32_t q = m.rowBegin(user); q < m.rowEnd(user); q++) {
+                    int j = m.rowItems()[q];
+                    if (j == i) continue;
+                    if (overlap[j] == 0) touched.push_back(j);
+                    overlap[j]++;
+                    dot[j] += ci * centered_rows[q];
+                }
+            }
+
+            candidates.clear();
+            for (int j : touched) {
+                float denominator = norms[i] * norms[j];
+                if (overlap[j] >= opts.min_overlap && denominator > 0.0f) {
+                    float similarity = dot[j] / denominator;
+                    similarity *= overlap[j] / (overlap[j] + opts.shrinkage);
+                    if (similarity > 0.0f) {
+                        candidates.push_back({j, similarity});
+                    }
+                }
+                dot[j] = 0.0f;
+                overlap[j] = 0;
+            }
+
+            auto by_similarity = [](const Neighbor& a, const Neighbor& b) {
+                return a.similarity > b.similarity;
+            };
+            if (candidates.size() > k) {
+                std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end(), by_similarity);
+                candidates.resize(k);
+            }
+            std::sort(candidates.begin(), candidates.end(), by_similarity);
+            per_item[i] = candidates;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < thread_count; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    model->neighbor_offsets.assign(items + 1, 0);
+    for (int i = 0; i < items; i++) {
+        model->neighbor_offsets[i + 1] = model->neighbor_offsets[i] + static_cast<uint32_t>(per_item[i].size());
+    }
+    model->neighbors.reserve(model->neighbor_offsets[items]);
+    for (int i = 0; i < items; i++) {
+        model->neighbors.insert(model->neighbors.end(), per_item[i].begin(), per_item[i].end());
+    }
+
+    model->training_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    LOG_INFO("🧮 Item-CF treinado: %zu usuários, %d filmes, %zu avaliações, %zu vizinhos em %.2f s (%d threads)",
+             m.userCount(), items, m.nonZeros(), model->neighbors.size(), model->training_seconds, thread_count);
+    return model;
+}
+
+std::vector<ScoredMovie> ItemCFModel::recommend(const std::vector<Rating>& user_ratings, size_t limit) const {
+    TRACE_SPAN("itemcf.recommend");
+    std::vector<ScoredMovie> result;
+    if (user_ratings.empty() || limit == 0) return result;
+
+    double mean = 0.0;
+    for (const auto& rating : user_ratings) mean += rating.rating;
+    mean /= user_ratings.size();
+
+    // Soma ponderada dos desvios do usuário nos vizinhos de cada filme avaliado
+    std::unordered_map<int, std::pair<float, float>> accumulators;
+    std::unordered_set<int> seen;
+    for (const auto& rating : user_ratings) {
+        seen.insert(rating.movie_id);
+    }
+
+    for (const auto& rating : user_ratings) {
+        int item = matrix.itemIndex(rating.movie_id);
+        if (item < 0) continue;
+        float deviation = static_cast<float>(options.adjusted ? rating.rating - mean : rating.rating);
+        for (uint32_t p = neighbor_offsets[item]; p < neighbor_offsets[item + 1]; p++) {
+            const Neighbor& neighbor = neighbors[p];
+            auto& acc = accumulators[neighbor.item];
+            acc.first += neighbor.similarity * deviation;
+            acc.second += neighbor.similarity;
+        }
+    }
+
+    result.reserve(accumulators.size());
+    for (const auto& entry : accumulators) {
+        int movie_id = matrix.itemId(entry.first);
+        if (seen.count(movie_id) || entry.second.second <= 0.0f) continue;
+        double predicted = entry.second.first / entry.second.second;
+        if (options.adjusted) predicted += mean;
+        result.push_back({movie_id, predicted});
+    }
+
+    auto by_score = [](const ScoredMovie& a, const ScoredMovie& b) {
+        return a.score > b.score;
+    };
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + limit, result.end(), by_score);
+        result.resize(limit);
+    } else {
+        std::sort(result.begin(), result.end(), by_score);
+    }
+    return result;
+}
+
+std::vector<ScoredMovie> ItemCFModel::similarMovies(int movie_id, size_t limit) const {
+    std::vector<ScoredMovie> result;
+    int item = matrix.itemIndex(movie_id);
+    if (item < 0) return result;
+
+    for (uint32_t p = neighbor_offsets[item]; p < neighbor_offsets[item + 1] && result.size() < limit; p++) {
+        result.push_back({matrix.itemId(neighbors[p].item), neighbors[p].similarity});
+    }
+    return result;
+}
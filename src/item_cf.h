@@ -0,0 +1,48 @@
+#ifndef ITEM_CF_H
+#define ITEM_CF_H
+
+#include "ratings_matrix.h"
+#include <memory>
+#include <vector>
+
+struct ItemCFOptions {
+    int neighbors = 50;        // vizinhos guardados por filme (top-K)
+    int threads = 0;           // 0 = std::thread::hardware_concurrency()
+    bool adjusted = true;      // cosseno ajustado (centraliza pela média do usuário)
+    int min_overlap = 2;       // usuários em comum exigidos para considerar um par
+    float shrinkage = 10.0f;   // reduz a similaridade de pares com pouco suporte
+};
+
+// Filtragem colaborativa item-item. O modelo é imutável depois de treinado
+// e pode ser compartilhado entre threads via std::shared_ptr.
+class ItemCFModel {
+public:
+    struct Neighbor {
+        int item;
+        float similarity;
+    };
+
+    static std::shared_ptr<ItemCFModel> train(RatingsMatrix matrix, const ItemCFOptions& options = ItemCFOptions());
+
+    // Pontua filmes ainda não avaliados a partir das avaliações atuais do
+    // usuário (lidas do banco na hora, então avaliações novas já contam).
+    std::vector<ScoredMovie> recommend(const std::vector<Rating>& user_ratings, size_t limit) const;
+
+    // Filmes mais parecidos com um filme (pelos vizinhos pré-calculados)
+    std::vector<ScoredMovie> similarMovies(int movie_id, size_t limit) const;
+
+    const RatingsMatrix& ratings() const { return matrix; }
+    double trainingSeconds() const { return training_seconds; }
+    size_t neighborCount() const { return neighbors.size(); }
+
+private:
+    RatingsMatrix matrix;
+    ItemCFOptions options;
+
+    // Vizinhos do filme i em [neighbor_offsets[i], neighbor_offsets[i + 1])
+    std::vector<uint32_t> neighbor_offsets;
+    std::vector<Neighbor> neighbors;
+    double training_seconds = 0.0;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "lock_profiler.h"
+#include <chrono>
+
+namespace {
+    int64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// ===== PONTOS DE AQUISIÇÃO =====
+LockSite::LockSite(const char* site_name, const char* site_file, int site_line)
+    : name(site_name), file(site_file), line(site_line) {
+    LockProfiler::instance().registerSite(this);
+}
+
+void LockSite::reset() {
+    acquisitions.store(0, std::memory_order_relaxed);
+    contended.store(0, std::memory_order_relaxed);
+    caused_wait_ns.store(0, std::memory_order_relaxed);
+    wait.reset();
+    hold.reset();
+}
+
+LockProfiler& LockProfiler::instance() {
+    static LockProfiler profiler;
+    return profiler;
+}
+
+void LockProfiler::registerSite(LockSite* site) {
+    // Lista ligada só de inserção: sites são estáticos e nunca removidos
+    LockSite* current = head.load(std::memory_order_relaxed);
+    do {
+        site->next = current;
+    } while (!head.compare_exchange_weak(current, site, std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::vector<const LockSite*> LockProfiler::sites() const {
+    std::vector<const LockSite*> result;
+    for (const LockSite* site = head.load(std::memory_order_acquire); site; site = site->next) {
+        result.push_back(site);
+    }
+    return result;
+}
+
+void LockProfiler::reset() {
+    for (LockSite* site = head.load(std::memory_order_acquire); site; site = site->next) {
+        site->reset();
+    }
+}
+
+// ===== LOCK PERFILADO =====
+ProfiledLock::ProfiledLock(ProfiledMutex& profiled, LockSite& lock_site)
+    : mutex(&profiled), site(&lock_site) {
+    int64_t start = nowNanos();
+    int64_t acquired = start;
+
+    if (!mutex->mutex.try_lock()) {
+        // Quem segurava o lock quando começamos a esperar leva a culpa pela espera
+        LockSite* blocker = mutex->holder.load(std::memory_order_relaxed);
+        mutex->mutex.lock();
+        acquired = nowNanos();
+
+        uint64_t waited = static_cast<uint64_t>(acquired - start);
+        site->contended.fetch_add(1, std::memory_order_relaxed);
+        if (blocker) {
+            blocker->caused_wait_ns.fetch_add(waited, std::memory_order_relaxed);
+        }
+        site->wait.record(waited / 1000);
+    } else {
+        site->wait.record(0);
+    }
+
+    site->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (!site->mutex_name.load(std::memory_order_relaxed)) {
+        site->mutex_name.store(mutex->name, std::memory_order_relaxed);
+    }
+    mutex->holder.store(site, std::memory_order_relaxed);
+    mutex->acquired_ns = acquired;
+}
+
+ProfiledLock::ProfiledLock(ProfiledLock&& other) noexcept
+    : mutex(other.mutex), site(other.site) {
+    other.mutex = nullptr;
+    other.site = nullptr;
+}
+
+ProfiledLock::~ProfiledLock() {
+    unlock();
+}
+
+void ProfiledLock::unlock() {
+    if (!mutex) return;
+
+    int64_t held = nowNanos() - mutex->acquired_ns;
+    mutex->holder.store(nullptr, std::memory_order_relaxed);
+    mutex->mutex.unlock();
+    site->hold.record(static_cast<uint64_t>(held) / 1000);
+
+    mutex = nullptr;
+}
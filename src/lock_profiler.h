@@ -0,0 +1,89 @@
+#ifndef LOCK_PROFILER_H
+#define LOCK_PROFILER_H
+
+#include "metrics.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Ponto do código que adquire um mutex perfilado. Cada LOCK_SITE cria um
+// estático próprio, registrado no LockProfiler na primeira execução.
+struct LockSite {
+    const char* name;
+    const char* file;
+    int line;
+    std::atomic<const char*> mutex_name{nullptr};
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};     // aquisições que precisaram esperar
+    std::atomic<uint64_t> caused_wait_ns{0}; // espera imposta a outras threads enquanto este ponto segurava o lock
+
+    LatencyHistogram wait;  // µs esperando o lock
+    LatencyHistogram hold;  // µs segurando o lock
+
+    LockSite* next = nullptr;
+
+    LockSite(const char* site_name, const char* site_file, int site_line);
+    void reset();
+};
+
+class LockProfiler {
+public:
+    static LockProfiler& instance();
+
+    void registerSite(LockSite* site);
+    std::vector<const LockSite*> sites() const;
+    void reset();
+
+private:
+    std::atomic<LockSite*> head{nullptr};
+};
+
+// std::mutex que mede espera e posse por ponto de aquisição. Sem disputa
+// o custo extra é um try_lock e duas leituras do relógio.
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char* mutex_name) : name(mutex_name) {}
+
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    const char* getName() const { return name; }
+
+private:
+    friend class ProfiledLock;
+
+    const char* name;
+    std::mutex mutex;
+    std::atomic<LockSite*> holder{nullptr};
+    int64_t acquired_ns = 0; // protegido pelo próprio mutex
+};
+
+// Equivalente a std::unique_lock para ProfiledMutex (pode ser movido/retornado)
+class ProfiledLock {
+public:
+    ProfiledLock(ProfiledMutex& mutex, LockSite& site);
+    ProfiledLock(ProfiledLock&& other) noexcept;
+    ~ProfiledLock();
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(ProfiledLock&&) = delete;
+
+    void unlock();
+    bool owns_lock() const { return mutex != nullptr; }
+
+private:
+    ProfiledMutex* mutex;
+    LockSite* site;
+};
+
+#define LOCK_SITE(site_name) \
+    ([]() -> LockSite& { static LockSite lock_site(site_name, __FILE__, __LINE__); return lock_site; }())
+
+// Adquire o lock do banco; no servidor é o db_mutex perfilado
+using DatabaseLockFn = std::function<ProfiledLock()>;
+
+#endif
@@ -0,0 +1,295 @@
+#include "logger.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace {
+    const char* baseName(const char* path) {
+        const char* base = path;
+        for (const char* p = path; *p; ++p) {
+            if (*p == '/' || *p == '\\') base = p + 1;
+        }
+        return base;
+    }
+
+    void toLocalTime(time_t seconds, std::tm* out) {
+#ifdef _WIN32
+        localtime_s(out, &seconds);
+#else
+        localtime_r(&seconds, out);
+#endif
+    }
+
+    void toUtcTime(time_t seconds, std::tm* out) {
+#ifdef _WIN32
+        gmtime_s(out, &seconds);
+#else
+        gmtime_r(&seconds, out);
+#endif
+    }
+
+    void appendJsonEscaped(std::string& out, const char* text) {
+        for (const char* p = text; *p; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out += escaped;
+                    } else {
+                        out += static_cast<char>(c);
+                    }
+            }
+        }
+    }
+}
+
+uint32_t Logger::threadNumber() {
+    static std::atomic<uint32_t> next_thread{1};
+    thread_local uint32_t number = next_thread.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : slots(new Slot[kCapacity]),
+      enqueue_pos(0),
+      dequeue_pos(0),
+      dropped(0),
+      min_level(static_cast<int>(LogLevel::Info)),
+      sample_every(1),
+      json_output(false),
+      output(stdout),
+      owns_output(false),
+      running(true) {
+    for (size_t i = 0; i < kCapacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    configureFromEnvironment();
+    flusher = std::thread(&Logger::flusherLoop, this);
+}
+
+Logger::~Logger() {
+    stop();
+    if (owns_output && output) {
+        std::fclose(output);
+    }
+}
+
+void Logger::configureFromEnvironment() {
+    if (const char* level = std::getenv("CINEIA_LOG_LEVEL")) {
+        setLevel(parseLevel(level, LogLevel::Info));
+    }
+    if (const char* format = std::getenv("CINEIA_LOG_FORMAT")) {
+        setJson(std::strcmp(format, "json") == 0);
+    }
+    if (const char* sample = std::getenv("CINEIA_LOG_SAMPLE")) {
+        setSampleEvery(static_cast<uint32_t>(std::strtoul(sample, nullptr, 10)));
+    }
+    if (const char* file = std::getenv("CINEIA_LOG_FILE")) {
+        setOutputFile(file);
+    }
+}
+
+void Logger::log(LogLevel level, const char* file, int line, const char* fmt, ...) {
+    uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &slots[pos & (kCapacity - 1)];
+        uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Buffer cheio: descarta em vez de bloquear a thread de IO
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    slot->thread = threadNumber();
+    slot->timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    slot->file = file;
+    slot->line = line;
+
+    va_list args;
+    va_start(args, fmt);
+    std::vsnprintf(slot->text, kMaxMessage, fmt, args);
+    va_end(args);
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+size_t Logger::drain(std::string& buffer) {
+    size_t count = 0;
+    bool json = json_output.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Slot& slot = slots[dequeue_pos & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+            break;
+        }
+
+        if (json) {
+            formatJson(slot, buffer);
+        } else {
+            formatText(slot, buffer);
+        }
+
+        slot.sequence.store(dequeue_pos + kCapacity, std::memory_order_release);
+        dequeue_pos++;
+        count++;
+    }
+
+    if (count > 0 && output) {
+        std::fwrite(buffer.data(), 1, buffer.size(), output);
+        std::fflush(output);
+    }
+    buffer.clear();
+    return count;
+}
+
+void Logger::flusherLoop() {
+    std::string buffer;
+    buffer.reserve(64 * 1024);
+
+    while (running.load(std::memory_order_acquire)) {
+        size_t written;
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            written = drain(buffer);
+        }
+        if (written == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+}
+
+void Logger::flush() {
+    std::string buffer;
+    std::lock_guard<std::mutex> lock(output_mutex);
+    drain(buffer);
+}
+
+void Logger::stop() {
+    if (running.exchange(false) && flusher.joinable()) {
+        flusher.join();
+    }
+    flush();
+}
+
+void Logger::setLevel(LogLevel level) {
+    min_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::setJson(bool json) {
+    json_output.store(json, std::memory_order_relaxed);
+}
+
+void Logger::setSampleEvery(uint32_t every) {
+    sample_every.store(every == 0 ? 1 : every, std::memory_order_relaxed);
+}
+
+bool Logger::setOutputFile(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "a");
+    if (!file) {
+        return false;
+    }
+
+    std::string buffer;
+    std::lock_guard<std::mutex> lock(output_mutex);
+    drain(buffer);
+    if (owns_output && output) {
+        std::fclose(output);
+    }
+    output = file;
+    owns_output = true;
+    return true;
+}
+
+void Logger::formatText(const Slot& slot, std::string& out) const {
+    // localtime é caro; a conversão só muda uma vez por segundo
+    static thread_local time_t cached_seconds = -1;
+    static thread_local std::tm calendar{};
+    time_t seconds = static_cast<time_t>(slot.timestamp_us / 1000000);
+    if (seconds != cached_seconds) {
+        toLocalTime(seconds, &calendar);
+        cached_seconds = seconds;
+    }
+
+    char prefix[64];
+    std::snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%03d] [%-5s] [t%u] ",
+                  calendar.tm_hour, calendar.tm_min, calendar.tm_sec,
+                  static_cast<int>((slot.timestamp_us / 1000) % 1000),
+                  levelName(slot.level), slot.thread);
+    out += prefix;
+    out += slot.text;
+    out += '\n';
+}
+
+void Logger::formatJson(const Slot& slot, std::string& out) const {
+    static thread_local time_t cached_seconds = -1;
+    static thread_local std::tm calendar{};
+    time_t seconds = static_cast<time_t>(slot.timestamp_us / 1000000);
+    if (seconds != cached_seconds) {
+        toUtcTime(seconds, &calendar);
+        cached_seconds = seconds;
+    }
+
+    char timestamp[64];
+    std::snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ",
+                  calendar.tm_year + 1900, calendar.tm_mon + 1, calendar.tm_mday,
+                  calendar.tm_hour, calendar.tm_min, calendar.tm_sec,
+                  static_cast<int>(slot.timestamp_us % 1000000));
+
+    out += "{\"ts\":\"";
+    out += timestamp;
+    out += "\",\"level\":\"";
+    out += levelName(slot.level);
+    out += "\",\"thread\":";
+    out += std::to_string(slot.thread);
+    out += ",\"src\":\"";
+    out += baseName(slot.file);
+    out += ':';
+    out += std::to_string(slot.line);
+    out += "\",\"msg\":\"";
+    appendJsonEscaped(out, slot.text);
+    out += "\"}\n";
+}
+
+LogLevel Logger::parseLevel(const std::string& name, LogLevel fallback) {
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "info") return LogLevel::Info;
+    if (name == "warn") return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off") return LogLevel::Off;
+    return fallback;
+}
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info:  return "info";
+        case LogLevel::Warn:  return "warn";
+        case LogLevel::Error: return "error";
+        default:              return "off";
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__GNUC__)
+    #define LOGGER_PRINTF_FORMAT(fmt_idx, args_idx) __attribute__((format(printf, fmt_idx, args_idx)))
+#else
+    #define LOGGER_PRINTF_FORMAT(fmt_idx, args_idx)
+#endif
+
+enum class LogLevel {
+    Debug = 0,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+// Logger assíncrono: as threads do Crow apenas formatam a mensagem num slot
+// do ring buffer (sem lock); uma thread de fundo escreve tudo em lote.
+// Configuração por variáveis de ambiente:
+//   CINEIA_LOG_LEVEL  = debug | info | warn | error | off   (padrão: info)
+//   CINEIA_LOG_FORMAT = text | json                          (padrão: text)
+//   CINEIA_LOG_SAMPLE = N  -> LOG_SAMPLED registra 1 a cada N chamadas
+//   CINEIA_LOG_FILE   = caminho do arquivo (padrão: stdout)
+class Logger {
+public:
+    static constexpr size_t kCapacity = 4096;     // potência de 2
+    static constexpr size_t kMaxMessage = 1024;
+
+    static Logger& instance();
+
+    bool enabled(LogLevel level) const {
+        return level >= static_cast<LogLevel>(min_level.load(std::memory_order_relaxed));
+    }
+
+    bool sampleHit(std::atomic<uint32_t>& site_counter) const {
+        uint32_t every = sample_every.load(std::memory_order_relaxed);
+        return every <= 1 || site_counter.fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    void log(LogLevel level, const char* file, int line, const char* fmt, ...) LOGGER_PRINTF_FORMAT(5, 6);
+
+    void setLevel(LogLevel level);
+    void setJson(bool json);
+    void setSampleEvery(uint32_t every);
+    bool setOutputFile(const std::string& path);
+
+    // Bloqueia até o buffer ser esvaziado (útil em benchmarks e no encerramento)
+    void flush();
+    void stop();
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Número sequencial da thread atual (o mesmo usado nos logs e nos traces)
+    static uint32_t threadNumber();
+
+    static LogLevel parseLevel(const std::string& name, LogLevel fallback);
+    static const char* levelName(LogLevel level);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        LogLevel level;
+        uint32_t thread;
+        int64_t timestamp_us;
+        const char* file;
+        int line;
+        char text[kMaxMessage];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    alignas(64) uint64_t dequeue_pos;
+    std::atomic<uint64_t> dropped;
+
+    std::atomic<int> min_level;
+    std::atomic<uint32_t> sample_every;
+    std::atomic<bool> json_output;
+
+    std::mutex output_mutex;
+    FILE* output;
+    bool owns_output;
+
+    std::atomic<bool> running;
+    std::thread flusher;
+
+    Logger();
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    void configureFromEnvironment();
+    void flusherLoop();
+    size_t drain(std::string& buffer);
+    void formatText(const Slot& slot, std::string& out) const;
+    void formatJson(const Slot& slot, std::string& out) const;
+};
+
+#define LOG_AT(level, ...)                                                           \
+    do {                                                                             \
+        if (Logger::instance().enabled(level)) {                                     \
+            Logger::instance().log(level, __FILE__, __LINE__, __VA_ARGS__);          \
+        }                                                                            \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
+
+// Amostragem por ponto de chamada: usado nos logs de rotas muito frequentes
+#define LOG_SAMPLED(level, ...)                                                      \
+    do {                                                                             \
+        static std::atomic<uint32_t> log_site_hits_{0};                              \
+        if (Logger::instance().enabled(level) &&                                     \
+            Logger::instance().sampleHit(log_site_hits_)) {                          \
+            Logger::instance().log(level, __FILE__, __LINE__, __VA_ARGS__);          \
+        }                                                                            \
+    } while (0)
+
+#endif
@@ -6,6 +6,8 @@
 #include <map>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include <fstream>
 #include <sstream>
 #include "database.h"
@@ -16,6 +18,22 @@
 #include <sstream>
 #include <curl/curl.h>
 #include "movie_api.h"
+#include "logger.h"
+#include "tracing.h"
+#include "http_metrics.h"
+#include "lock_profiler.h"
+#include "item_cf.h"
+#include "als.h"
+#include "content_index.h"
+#include "hnsw_index.h"
+#include "reco_store.h"
+#include "batch_recompute.h"
+#include "trending.h"
+#include "rating_writer.h"
+#include "catalog_ingest.h"
+#include "migrations.h"
+#include "msgpack_writer.h"
+#include "thread_pool.h"
 #include <cstdlib>
 #include <locale>
 #include "crow_all.h"
@@ -44,7 +62,31 @@ struct AIReco {
 // ===== VARIÁVEIS GLOBAIS COMPARTILHADAS =====
 Database* global_db = nullptr;
 MovieAPI* global_movie_api = nullptr;
-std::mutex db_mutex;
+ProfiledMutex db_mutex("db_mutex");
+std::shared_ptr<const ItemCFModel> global_item_cf;  // acessar via std::atomic_load/atomic_store
+std::shared_ptr<const ALSModel> global_als;         // idem
+std::atomic<bool> recommender_training(false);
+std::shared_ptr<const ContentIndex> global_content_index;  // idem
+std::atomic<bool> content_index_pending(false);
+std::atomic<bool> movie_ann_pending(false);
+std::shared_ptr<HnswIndex> global_movie_ann;  // idem; inserções incrementais são internas ao índice
+RecoStore* global_reco_store = nullptr;
+std::atomic<bool> batch_running(false);
+std::mutex batch_report_mutex;
+BatchReport last_batch_report;  // protegido por batch_report_mutex
+TrendingTracker global_trending;
+RatingWriter* global_rating_writer = nullptr;
+// Sub-requisições de /api/batch: não passam pelo middleware do Crow
+struct BatchCallMetrics {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> status_2xx{0};
+    std::atomic<uint64_t> status_4xx{0};
+    std::atomic<uint64_t> status_5xx{0};
+    LatencyHistogram latency;
+};
+BatchCallMetrics batch_call_metrics;
+KnownIdCache known_users;   // já confirmados no banco, dispensam a consulta em /api/rate
+KnownIdCache known_movies;
 
 
 // ===== FUNÇÕES AUXILIARES PARA ARQUIVOS =====
@@ -72,25 +114,575 @@ std::string getMimeType(const std::string& filename) {
 }
 
 
+// ===== LOGS DO CROW NO LOGGER ASSÍNCRONO =====
+// As linhas "Request:"/"Response:" do Crow saem a cada requisição; sem isso
+// elas iriam direto para std::clog na thread de IO.
+class CrowLogBridge : public crow::ILogHandler {
+public:
+    void log(std::string message, crow::LogLevel level) override {
+        switch (level) {
+            case crow::LogLevel::Debug:
+            case crow::LogLevel::Info:
+                LOG_DEBUG("%s", message.c_str());
+                break;
+            case crow::LogLevel::Warning:
+                LOG_WARN("%s", message.c_str());
+                break;
+            default:
+                LOG_ERROR("%s", message.c_str());
+        }
+    }
+};
+
+// ===== RASTREAMENTO DE REQUISIÇÕES =====
+// Abre o span raiz de cada requisição; os spans de Database, MovieAPI e
+// serialização ficam aninhados nele pela thread do handler.
+struct RequestTracing {
+    struct context {
+        std::unique_ptr<TraceRequest> trace;
+    };
+
+    void before_handle(crow::request& req, crow::response& /*res*/, context& ctx) {
+        if (!Tracer::instance().enabled()) return;
+        bool force = req.get_header_value("X-Trace") == "1";
+        ctx.trace.reset(new TraceRequest(std::string(crow::method_name(req.method)) + " " + req.url, force));
+    }
+
+    void after_handle(crow::request& /*req*/, crow::response& res, context& ctx) {
+        if (ctx.trace && ctx.trace->sampled()) {
+            res.add_header("X-Trace-Id", ctx.trace->traceIdHex());
+            ctx.trace->finish();
+        }
+        ctx.trace.reset();
+    }
+};
+
+// Aguarda o db_mutex registrando o tempo de espera no trace da requisição
+// e a espera/posse por ponto de aquisição no LockProfiler
+ProfiledLock lockDatabase(LockSite& site) {
+    TRACE_SPAN("db_mutex.wait");
+    return ProfiledLock(db_mutex, site);
+}
+
+// Serializa a resposta JSON dentro de um span próprio
+crow::response jsonResponse(crow::json::wvalue& value) {
+    TRACE_SPAN("json.serialize");
+    return crow::response{value};
+}
+
+// Negociação de conteúdo: clientes internos podem pedir MessagePack
+bool acceptsMsgpack(const crow::request& req) {
+    const std::string& accept = req.get_header_value("Accept");
+    return accept.find("application/msgpack") != std::string::npos ||
+           accept.find("application/x-msgpack") != std::string::npos;
+}
+
+crow::response msgpackResponse(MsgpackWriter& out) {
+    crow::response res(200);
+    res.set_header("Content-Type", "application/msgpack");
+    res.body = out.release();
+    return res;
+}
+
+// Rotas administrativas exigem "Authorization: Bearer <token>" com o valor de
+// CINEIA_ADMIN_TOKEN. O servidor não tem sessão: um X-User-Id qualquer seria
+// escolhido pelo próprio cliente. Sem a variável, as rotas ficam fechadas.
+const std::string& adminToken() {
+    static const std::string token = []() {
+        const char* value = std::getenv("CINEIA_ADMIN_TOKEN");
+        return std::string(value ? value : "");
+    }();
+    return token;
+}
+
+bool isAdminRequest(const crow::request& req) {
+    const std::string& token = adminToken();
+    const std::string& header = req.get_header_value("Authorization");
+    const std::string prefix = "Bearer ";
+    if (token.empty() || header.size() != prefix.size() + token.size() ||
+        header.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    // Comparação em tempo constante
+    unsigned char diff = 0;
+    for (size_t i = 0; i < token.size(); i++) {
+        diff |= static_cast<unsigned char>(header[prefix.size() + i] ^ token[i]);
+    }
+    return diff == 0;
+}
+
+crow::response adminOnlyResponse() {
+    return crow::response(403, "{\"success\": false, \"error\": \"Acesso restrito a administradores\"}");
+}
+
+// ===== RECOMENDADORES LOCAIS (ITEM-ITEM E ALS) =====
+std::shared_ptr<const ItemCFModel> currentItemCF() {
+    return std::atomic_load(&global_item_cf);
+}
+
+std::shared_ptr<const ALSModel> currentALS() {
+    return std::atomic_load(&global_als);
+}
+
+ALSOptions alsOptionsFromEnv() {
+    ALSOptions options;
+    if (const char* rank = std::getenv("CINEIA_ALS_RANK")) options.rank = std::max(1, std::atoi(rank));
+    if (const char* lambda = std::getenv("CINEIA_ALS_LAMBDA")) options.lambda = static_cast<float>(std::atof(lambda));
+    if (const char* iterations = std::getenv("CINEIA_ALS_ITERATIONS")) options.iterations = std::max(1, std::atoi(iterations));
+    if (const char* explicit_feedback = std::getenv("CINEIA_ALS_EXPLICIT")) options.implicit = std::atoi(explicit_feedback) == 0;
+    return options;
+}
+
+// Marca o treino como em andamento; false se outro já estiver rodando.
+// Com true, o chamador passa a ser dono do treino e roda runClaimedRecommenderRebuild().
+bool claimRecommenderRebuild() {
+    bool expected = false;
+    return recommender_training.compare_exchange_strong(expected, true);
+}
+
+// Lê as avaliações sob o db_mutex e treina fora dele; os modelos novos
+// substituem os anteriores atomicamente
+void runClaimedRecommenderRebuild() {
+    std::vector<Rating> ratings;
+    {
+        auto lock = lockDatabase(LOCK_SITE("recommender.rebuild"));
+        ratings = global_db->getAllRatings();
+    }
+    RatingsMatrix matrix = RatingsMatrix::build(ratings);
+    std::vector<int> user_ids;
+    user_ids.reserve(matrix.userCount());
+    for (size_t user = 0; user < matrix.userCount(); user++) {
+        user_ids.push_back(matrix.userId(static_cast<int>(user)));
+    }
+
+    std::shared_ptr<const ALSModel> als = ALSModel::train(matrix, alsOptionsFromEnv());
+    if (const char* path = std::getenv("CINEIA_ALS_MODEL")) {
+        als->save(path);
+    }
+    std::atomic_store(&global_als, als);
+
+    ItemCFOptions options;
+    if (const char* neighbors = std::getenv("CINEIA_CF_NEIGHBORS")) {
+        options.neighbors = std::max(1, std::atoi(neighbors));
+    }
+    std::shared_ptr<const ItemCFModel> item_cf = ItemCFModel::train(std::move(matrix), options);
+    std::atomic_store(&global_item_cf, item_cf);
+
+    // Modelos novos: todas as recomendações guardadas ficaram desatualizadas
+    if (global_reco_store) {
+        global_reco_store->markDirty(user_ids);
+    }
+
+    recommender_training = false;
+}
+
+// Retorna false se já houver um treino em andamento
+bool rebuildRecommenders() {
+    if (!claimRecommenderRebuild()) {
+        return false;
+    }
+    runClaimedRecommenderRebuild();
+    return true;
+}
+
+std::shared_ptr<const ContentIndex> currentContentIndex() {
+    return std::atomic_load(&global_content_index);
+}
+
+// Reindexa sinopse/gênero/atores do catálogo inteiro. Pedidos feitos durante
+// uma reindexação são agrupados em uma única rodada seguinte.
+void rebuildContentIndex() {
+    if (content_index_pending.exchange(true)) {
+        return;
+    }
+
+    // Uma reindexação por vez, para que a mais recente seja a última publicada
+    static std::mutex build_mutex;
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+
+    std::vector<Movie> movies;
+    {
+        auto lock = lockDatabase(LOCK_SITE("content.rebuild"));
+        content_index_pending = false;
+        movies = global_db->getAllMovies();
+    }
+    std::atomic_store(&global_content_index, std::shared_ptr<const ContentIndex>(ContentIndex::build(movies)));
+}
+
+// ===== RECOMENDAÇÕES PRÉ-CALCULADAS =====
+size_t recoTopN() {
+    const char* value = std::getenv("CINEIA_RECO_TOP_N");
+    return value ? static_cast<size_t>(std::max(1, std::atoi(value))) : 10;
+}
+
+// Mensagem exibida ao usuário conforme o modelo que gerou a lista
+// ("als", "cf" ou "content", o mesmo valor gravado em `source`)
+const char* recommendationMessage(const std::string& source) {
+    if (source == "als") return "Recomendações baseadas em usuários com gostos parecidos";
+    if (source == "cf") return "Recomendações baseadas em filmes avaliados de forma parecida";
+    if (source == "content") return "Recomendações baseadas no conteúdo dos filmes que você avaliou";
+    return "Recomendações baseadas em popularidade";
+}
+
+// Usado pelo worker do RecoStore: ALS primeiro, depois item-item e conteúdo
+bool computeStoredRecommendations(int user_id, StoredRecommendations& out) {
+    std::vector<Rating> ratings;
+    {
+        auto lock = lockDatabase(LOCK_SITE("reco_store.compute"));
+        ratings = global_db->getUserRatings(user_id);
+    }
+    if (ratings.empty()) return false;
+
+    size_t limit = recoTopN();
+    if (auto model = currentALS()) {
+        out.movies = model->recommend(ratings, limit);
+        out.source = "als";
+    }
+    if (out.movies.empty()) {
+        if (auto model = currentItemCF()) {
+            out.movies = model->recommend(ratings, limit);
+            out.source = "cf";
+        }
+    }
+    if (out.movies.empty()) {
+        if (auto index = currentContentIndex()) {
+            out.movies = index->recommend(ratings, limit);
+            out.source = "content";
+        }
+    }
+    return !out.movies.empty();
+}
+
+// Carrega no RecoStore as listas gravadas pelo último recálculo em lote, para
+// que /api/recommendations responda desde a subida. O próximo treino marca
+// todos como sujos e o worker as substitui.
+void seedRecoStoreFromBatch() {
+    std::vector<StoredRankedRow> rows;
+    {
+        auto lock = lockDatabase(LOCK_SITE("reco_store.seed"));
+        rows = global_db->getStoredUserRecommendations();
+    }
+
+    size_t users = 0;
+    for (size_t begin = 0; begin < rows.size();) {
+        auto entry = std::make_shared<StoredRecommendations>();
+        entry->source = rows[begin].source;
+        entry->computed_at = rows[begin].computed_at;
+        size_t end = begin;
+        while (end < rows.size() && rows[end].owner_id == rows[begin].owner_id) {
+            entry->movies.push_back({rows[end].movie_id, rows[end].score});
+            end++;
+        }
+        global_reco_store->put(rows[begin].owner_id, std::move(entry));
+        users++;
+        begin = end;
+    }
+    if (users > 0) {
+        LOG_INFO("🗂️ %zu usuários com recomendações do último recálculo em lote", users);
+    }
+}
+
+// ===== EM ALTA =====
+// Recarrega as avaliações recentes (contadores ficam só em memória) e passa a
+// publicar um snapshot a cada CINEIA_TRENDING_SNAPSHOT_S segundos
+void startTrending() {
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    std::vector<std::pair<int, int64_t>> events;
+    {
+        auto lock = lockDatabase(LOCK_SITE("trending.load"));
+        events = global_db->getRatingTimesSince(now - 60 * 86400);
+    }
+    for (const auto& event : events) {
+        global_trending.record(event.first, event.second);
+    }
+    global_trending.snapshot(now);
+
+    int interval = 10;
+    if (const char* seconds = std::getenv("CINEIA_TRENDING_SNAPSHOT_S")) {
+        interval = std::max(1, std::atoi(seconds));
+    }
+    std::thread([interval]() {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(interval));
+            global_trending.snapshot(static_cast<int64_t>(std::time(nullptr)));
+        }
+    }).detach();
+}
+
+// Filmes em alta como JSON (chamar com o db_mutex preso); vazio se nada foi avaliado na janela
+std::vector<crow::json::wvalue> trendingMovieList(const TrendingSnapshot& snapshot, size_t limit) {
+    std::vector<crow::json::wvalue> movie_list;
+    for (const auto& item : snapshot.movies) {
+        if (movie_list.size() >= limit) break;
+        Movie* movie = global_db->getMovieById(item.movie_id);
+        if (!movie) continue;
+
+        crow::json::wvalue movie_json;
+        movie_json["id"] = movie->id;
+        movie_json["title"] = movie->title;
+        movie_json["genre"] = movie->genre;
+        movie_json["year"] = movie->year;
+        movie_json["imdb_rating"] = movie->imdb_rating;
+        movie_json["poster_url"] = movie->poster_url;
+        movie_json["trending_score"] = item.score;
+        movie_list.push_back(std::move(movie_json));
+        delete movie;
+    }
+    return movie_list;
+}
+
+// ===== RECÁLCULO EM LOTE =====
+BatchOptions batchOptionsFromEnv() {
+    BatchOptions options;
+    options.top_n = recoTopN();
+    if (const char* threads = std::getenv("CINEIA_BATCH_THREADS")) options.threads = std::max(0, std::atoi(threads));
+    if (const char* rows = std::getenv("CINEIA_BATCH_TX_ROWS")) options.rows_per_transaction = std::max(1, std::atoi(rows));
+    return options;
+}
+
+// Reserva o lote: só um recálculo por vez. Quem recebe true deve chamar
+// runClaimedBatchRecompute(), que libera a reserva ao terminar.
+bool claimBatchRecompute() {
+    bool expected = false;
+    return batch_running.compare_exchange_strong(expected, true);
+}
+
+void runClaimedBatchRecompute() {
+    BatchModels models;
+    models.als = currentALS();
+    models.item_cf = currentItemCF();
+    models.content = currentContentIndex();
+
+    BatchReport report = runBatchRecompute(*global_db,
+        []() { return lockDatabase(LOCK_SITE("batch.recompute")); },
+        models, batchOptionsFromEnv(), global_reco_store);
+    {
+        std::lock_guard<std::mutex> lock(batch_report_mutex);
+        last_batch_report = report;
+    }
+
+    batch_running = false;
+}
+
+// Recalcula todos os usuários e filmes com os modelos atuais. Retorna false
+// se já houver um lote em andamento.
+bool runBatchRecomputeNow() {
+    if (!claimBatchRecompute()) {
+        return false;
+    }
+    runClaimedBatchRecompute();
+    return true;
+}
+
+crow::json::wvalue batchReportJson(const BatchReport& report) {
+    crow::json::wvalue json;
+    json["success"] = report.success;
+    json["threads"] = report.threads;
+    json["users"] = report.users;
+    json["movies"] = report.movies;
+    json["rows_written"] = report.rows_written;
+    json["steals"] = report.steals;
+    json["total_seconds"] = report.total_seconds;
+    json["items_per_second"] = report.itemsPerSecond();
+    json["finished_at"] = report.finished_at;
+
+    std::vector<crow::json::wvalue> stages;
+    for (const auto& stage : report.stages) {
+        crow::json::wvalue stage_json;
+        stage_json["name"] = stage.name;
+        stage_json["seconds"] = stage.seconds;
+        stage_json["items"] = stage.items;
+        stage_json["items_per_second"] = stage.itemsPerSecond();
+        stages.push_back(std::move(stage_json));
+    }
+    json["stages"] = std::move(stages);
+    return json;
+}
+
+// ===== ÍNDICE HNSW DOS FILMES =====
+std::shared_ptr<HnswIndex> currentMovieAnn() {
+    return std::atomic_load(&global_movie_ann);
+}
+
+// A partir deste tamanho de catálogo /similar usa o HNSW por padrão
+size_t annMinMovies() {
+    const char* value = std::getenv("CINEIA_ANN_MIN_MOVIES");
+    return value ? static_cast<size_t>(std::atol(value)) : 5000;
+}
+
+void saveMovieAnn(const HnswIndex& index) {
+    static std::mutex save_mutex;
+    if (const char* path = std::getenv("CINEIA_HNSW_FILE")) {
+        std::lock_guard<std::mutex> lock(save_mutex);
+        index.save(path);
+    }
+}
+
+// Alinha o HNSW ao índice de conteúdo atual. Na primeira chamada tenta o
+// arquivo de CINEIA_HNSW_FILE; se os vetores de conteúdo mudaram desde a
+// gravação (fingerprint diferente), reconstrói do zero, grava com o novo
+// fingerprint e troca o índice publicado. Pedidos feitos durante uma
+// reconstrução são agrupados em uma única rodada seguinte.
+void loadOrBuildMovieAnn() {
+    if (movie_ann_pending.exchange(true)) {
+        return;
+    }
+
+    static std::mutex build_mutex;
+    std::lock_guard<std::mutex> build_lock(build_mutex);
+    movie_ann_pending = false;
+
+    std::shared_ptr<const ContentIndex> content = currentContentIndex();
+    if (!content) return;
+
+    std::shared_ptr<HnswIndex> index = currentMovieAnn();
+    if (index && index->fingerprint() == content->fingerprint()) {
+        return;
+    }
+
+    std::vector<Movie> movies;
+    {
+        auto lock = lockDatabase(LOCK_SITE("hnsw.build"));
+        movies = global_db->getAllMovies();
+    }
+
+    const char* path = std::getenv("CINEIA_HNSW_FILE");
+    if (!index && path) {
+        index = HnswIndex::load(path);
+        if (index && index->dimension() != content->embeddingDims()) {
+            index = nullptr;
+        } else if (index && index->fingerprint() != content->fingerprint()) {
+            LOG_INFO("🔄 Índice HNSW de %s é de outro catálogo/dicionário; reconstruindo", path);
+            index = nullptr;
+        }
+    } else {
+        index = nullptr;
+    }
+    if (!index) {
+        HnswOptions options;
+        if (const char* m = std::getenv("CINEIA_HNSW_M")) options.M = std::atoi(m);
+        if (const char* ef = std::getenv("CINEIA_HNSW_EF")) options.ef_search = std::max(1, std::atoi(ef));
+        index = std::make_shared<HnswIndex>(content->embeddingDims(), options);
+        index->setFingerprint(content->fingerprint());
+    }
+
+    std::vector<int> labels;
+    std::vector<float> vectors;
+    for (const auto& movie : movies) {
+        if (index->contains(movie.id)) continue;
+        std::vector<float> vector = content->embed(movie);
+        labels.push_back(movie.id);
+        vectors.insert(vectors.end(), vector.begin(), vector.end());
+    }
+    if (!labels.empty()) {
+        index->build(labels, vectors);
+        saveMovieAnn(*index);
+    }
+    std::atomic_store(&global_movie_ann, index);
+}
+
+crow::json::wvalue histogramJson(const LatencyHistogram& histogram) {
+    crow::json::wvalue json;
+    json["count"] = histogram.count();
+    json["avg_ms"] = histogram.averageMicros() / 1000.0;
+    json["p50_ms"] = histogram.percentileMicros(0.50) / 1000.0;
+    json["p90_ms"] = histogram.percentileMicros(0.90) / 1000.0;
+    json["p99_ms"] = histogram.percentileMicros(0.99) / 1000.0;
+    json["max_ms"] = histogram.maxMicros() / 1000.0;
+    return json;
+}
+
+// ===== IMPORTAÇÃO DE AVALIAÇÕES EM MASSA =====
+const size_t kBulkChunkRows = 5000;      // linhas por transação (o lock é solto entre elas)
+const size_t kBulkMaxReportedErrors = 1000;
+
+bool parseIntField(const std::string& text, long long& out) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    out = std::strtoll(text.c_str(), &end, 10);
+    return end && *end == '\0';
+}
+
+bool parseDoubleField(const std::string& text, double& out) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return end && *end == '\0';
+}
+
+// CSV: user_id,movie_id,rating[,timestamp] (timestamp em unix epoch)
+bool parseBulkCsvLine(const std::string& line, RatingInput& out, std::string& error) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+        size_t first = field.find_first_not_of(" \t");
+        size_t last = field.find_last_not_of(" \t");
+        fields.push_back(first == std::string::npos ? "" : field.substr(first, last - first + 1));
+    }
+
+    long long user_id = 0, movie_id = 0, timestamp = 0;
+    if (fields.size() < 3 || fields.size() > 4) {
+        error = "esperado user_id,movie_id,rating[,timestamp]";
+        return false;
+    }
+    if (!parseIntField(fields[0], user_id) || !parseIntField(fields[1], movie_id) ||
+        !parseDoubleField(fields[2], out.rating) ||
+        (fields.size() == 4 && !parseIntField(fields[3], timestamp))) {
+        error = "campo numérico inválido";
+        return false;
+    }
+    out.user_id = static_cast<int>(user_id);
+    out.movie_id = static_cast<int>(movie_id);
+    out.timestamp = timestamp;
+    return true;
+}
+
+// NDJSON: {"user_id": 1, "movie_id": 2, "rating": 8, "timestamp": 1700000000}
+bool parseBulkJsonLine(const std::string& line, RatingInput& out, std::string& error) {
+    auto json = crow::json::load(line);
+    if (!json || json.t() != crow::json::type::Object) {
+        error = "JSON inválido";
+        return false;
+    }
+    if (!json.has("user_id") || !json.has("movie_id") || !json.has("rating")) {
+        error = "campos obrigatórios: user_id, movie_id, rating";
+        return false;
+    }
+    try {
+        out.user_id = static_cast<int>(json["user_id"].i());
+        out.movie_id = static_cast<int>(json["movie_id"].i());
+        out.rating = json["rating"].d();
+        out.timestamp = json.has("timestamp") ? json["timestamp"].i() : 0;
+    } catch (const std::exception&) {
+        error = "campo numérico inválido";
+        return false;
+    }
+    return true;
+}
+
 // ===== FUNÇÕES DO SERVIDOR WEB CROW =====
 void setupWebServer(int port = 8081) {
-    crow::SimpleApp app;
+    static CrowLogBridge crow_log_bridge;
+    crow::logger::setHandler(&crow_log_bridge);
+
+    crow::App<RequestTracing> app;
+    app.loglevel(Logger::instance().enabled(LogLevel::Debug) ? crow::LogLevel::Debug : crow::LogLevel::Warning);
 
     // API - Obter quantidade de filmes avaliados pelo usuário
     CROW_ROUTE(app, "/api/user/<int>/ratings/count")
     ([](int user_id) {
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("GET /api/user/<id>/ratings/count"));
 
         crow::json::wvalue response;
 
-        // Obter apenas as avaliações do usuário
-        std::vector<Rating> user_ratings = global_db->getUserRatings(user_id);
-        int ratings_count = user_ratings.size();
+        int ratings_count = global_db->countUserRatings(user_id);
 
         response["success"] = true;
         response["count"] = ratings_count;
 
-        return crow::response{response};
+        return jsonResponse(response);
     });
 
 
@@ -98,11 +690,11 @@ void setupWebServer(int port = 8081) {
     // API - Avaliar filme (VERSÃO CORRIGIDA)
 CROW_ROUTE(app, "/api/rate").methods("POST"_method)
 ([](const crow::request& req) {
-    std::cout << "📝 Recebendo avaliação: " << req.body << std::endl;
+    LOG_DEBUG("📝 Recebendo avaliação: %s", req.body.c_str());
 
     auto json = crow::json::load(req.body);
     if (!json) {
-        std::cout << "❌ JSON inválido" << std::endl;
+        LOG_WARN("❌ JSON inválido");
         return crow::response(400, "{\"success\": false, \"error\": \"JSON inválido\"}");
     }
 
@@ -111,52 +703,72 @@ CROW_ROUTE(app, "/api/rate").methods("POST"_method)
         int movie_id = json["movie_id"].i();
         double rating = json["rating"].d();
 
-        std::cout << "🎯 Dados recebidos - User: " << user_id
-                  << ", Movie: " << movie_id
-                  << ", Rating: " << rating << std::endl;
+        LOG_SAMPLED(LogLevel::Info, "🎯 Dados recebidos - User: %d, Movie: %d, Rating: %g",
+                    user_id, movie_id, rating);
 
         // Validar avaliação
         if (rating < 0 || rating > 10) {
-            std::cout << "❌ Avaliação inválida: " << rating << std::endl;
+            LOG_WARN("❌ Avaliação inválida: %g", rating);
             return crow::response(400, "{\"success\": false, \"error\": \"Avaliação deve ser entre 0 e 10\"}");
         }
 
-        std::lock_guard<std::mutex> lock(db_mutex);
+        // Modo durável: só responde depois do COMMIT do lote com a avaliação
+        bool durable = (req.url_params.get("durable") && std::string(req.url_params.get("durable")) == "1") ||
+                       (json.has("durable") && json["durable"].t() == crow::json::type::True);
 
-        // Verificar se usuário existe
-        User* user = global_db->getUserById(user_id);
-        if (!user) {
-            std::cout << "❌ Usuário não encontrado: " << user_id << std::endl;
-            return crow::response(400, "{\"success\": false, \"error\": \"Usuário não encontrado\"}");
+        // Checagem de existência só para IDs ainda não vistos
+        if (!known_users.contains(user_id) || !known_movies.contains(movie_id)) {
+            auto lock = lockDatabase(LOCK_SITE("POST /api/rate"));
+
+            // Verificar se usuário existe
+            User* user = global_db->getUserById(user_id);
+            if (!user) {
+                LOG_WARN("❌ Usuário não encontrado: %d", user_id);
+                return crow::response(400, "{\"success\": false, \"error\": \"Usuário não encontrado\"}");
+            }
+            delete user;
+
+            // Verificar se filme existe
+            Movie* movie = global_db->getMovieById(movie_id);
+            if (!movie) {
+                LOG_WARN("❌ Filme não encontrado: %d", movie_id);
+                return crow::response(400, "{\"success\": false, \"error\": \"Filme não encontrado\"}");
+            }
+            delete movie;
+
+            known_users.insert(user_id);
+            known_movies.insert(movie_id);
         }
-        delete user;
 
-        // Verificar se filme existe
-        Movie* movie = global_db->getMovieById(movie_id);
-        if (!movie) {
-            std::cout << "❌ Filme não encontrado: " << movie_id << std::endl;
-            return crow::response(400, "{\"success\": false, \"error\": \"Filme não encontrado\"}");
+        crow::json::wvalue response;
+        if (!durable) {
+            global_rating_writer->submit(user_id, movie_id, rating);
+            response["success"] = true;
+            response["queued"] = true;
+            response["message"] = "Avaliação recebida";
+            response["rating_id"] = user_id;
+            crow::response res = jsonResponse(response);
+            res.code = 202;
+            return res;
         }
-        delete movie;
 
-        std::cout << "💾 Tentando salvar avaliação no banco..." << std::endl;
-        bool success = global_db->addRating(user_id, movie_id, rating);
+        LOG_DEBUG("💾 Aguardando gravação durável da avaliação...");
+        bool success = global_rating_writer->submitDurable(user_id, movie_id, rating).get();
 
-        crow::json::wvalue response;
         response["success"] = success;
         if (success) {
-            std::cout << "✅ Avaliação salva com sucesso!" << std::endl;
+            LOG_SAMPLED(LogLevel::Info, "✅ Avaliação salva com sucesso!");
             response["message"] = "Avaliação registrada com sucesso";
             response["rating_id"] = user_id; // Você pode ajustar para retornar o ID real se necessário
         } else {
-            std::cout << "❌ Erro ao salvar avaliação no banco" << std::endl;
+            LOG_ERROR("❌ Erro ao salvar avaliação no banco");
             response["error"] = "Erro ao registrar avaliação no banco de dados";
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
 
     } catch (const std::exception& e) {
-        std::cout << "💥 Exception na API de avaliação: " << e.what() << std::endl;
+        LOG_ERROR("💥 Exception na API de avaliação: %s", e.what());
         return crow::response(500, "{\"success\": false, \"error\": \"Erro interno do servidor\"}");
     }
 });
@@ -164,30 +776,18 @@ CROW_ROUTE(app, "/api/rate").methods("POST"_method)
     // API - Obter 6 filmes recentemente avaliados (Para Perfil)
 CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
 ([](int user_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
+    auto lock = lockDatabase(LOCK_SITE("GET /api/user/<id>/recent-ratings"));
 
     crow::json::wvalue response;
 
-    // Obter avaliações do usuário ordenadas por data (mais recentes primeiro)
-    std::vector<Rating> user_ratings = global_db->getUserRatings(user_id);
-
-    // Ordenar por timestamp (assumindo que timestamp é string com data)
-    std::sort(user_ratings.begin(), user_ratings.end(),
-        [](const Rating& a, const Rating& b) {
-            return a.timestamp > b.timestamp; // Mais recentes primeiro
-        });
-
-    // Pegar apenas os 6 mais recentes
-    std::vector<Rating> recent_ratings;
-    for (size_t i = 0; i < std::min(user_ratings.size(), size_t(6)); i++) {
-        recent_ratings.push_back(user_ratings[i]);
-    }
+    // 6 avaliações mais recentes, já ordenadas pelo banco
+    std::vector<Rating> recent_ratings = global_db->getRecentRatings(user_id, 6);
 
     if (recent_ratings.empty()) {
         response["success"] = true;
         response["message"] = "Nenhuma avaliação recente encontrada";
         response["recent_ratings"] = crow::json::wvalue::list();
-        return crow::response{response};
+        return jsonResponse(response);
     }
 
     std::vector<crow::json::wvalue> recent_list;
@@ -212,24 +812,240 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
     response["count"] = recent_list.size();
     response["recent_ratings"] = std::move(recent_list);
 
-    return crow::response{response};
+    return jsonResponse(response);
 });
 
 
+    // API - Resumo do perfil numa chamada (?recent=N e ?top=N, até 50; padrão 6)
+    CROW_ROUTE(app, "/api/user/<int>/summary")
+    ([](const crow::request& req, int user_id) {
+        auto limitParam = [&](const char* name) {
+            const char* value = req.url_params.get(name);
+            return static_cast<size_t>(value ? std::max(0, std::min(std::atoi(value), 50)) : 6);
+        };
+        size_t recent_limit = limitParam("recent");
+        size_t top_limit = limitParam("top");
+
+        auto lock = lockDatabase(LOCK_SITE("GET /api/user/<id>/summary"));
+
+        crow::json::wvalue response;
+
+        User* user = global_db->getUserById(user_id);
+        if (!user) {
+            response["success"] = false;
+            response["error"] = "Usuário não encontrado";
+            return jsonResponse(response);
+        }
+        response["user"] = {
+            {"id", user->id},
+            {"username", user->username},
+            {"is_admin", user->is_admin}
+        };
+        delete user;
+
+        UserSummary summary = global_db->getUserSummary(user_id, recent_limit, top_limit);
+
+        auto movieList = [](const std::vector<UserRatedMovie>& movies) {
+            std::vector<crow::json::wvalue> list;
+            for (const auto& movie : movies) {
+                crow::json::wvalue movie_json;
+                movie_json["movie_id"] = movie.movie_id;
+                movie_json["title"] = movie.title;
+                movie_json["year"] = movie.year;
+                movie_json["genre"] = movie.genre;
+                movie_json["poster_url"] = movie.poster_url;
+                movie_json["user_rating"] = movie.rating;
+                movie_json["rating_date"] = movie.timestamp;
+                list.push_back(std::move(movie_json));
+            }
+            return list;
+        };
+
+        std::vector<crow::json::wvalue> genres;
+        for (const auto& genre : summary.genres) {
+            crow::json::wvalue genre_json;
+            genre_json["genre"] = genre.genre;
+            genre_json["count"] = genre.count;
+            genre_json["average"] = genre.average;
+            genres.push_back(std::move(genre_json));
+        }
+
+        response["success"] = true;
+        response["rating_count"] = summary.rating_count;
+        response["average_rating"] = summary.average_rating;
+        response["genres"] = std::move(genres);
+        response["recent_ratings"] = movieList(summary.recent);
+        response["top_rated"] = movieList(summary.top_rated);
+
+        return jsonResponse(response);
+    });
+
+
+    // API - Várias leituras numa única requisição. Corpo: lista (ou {"requests": [...]})
+    // de caminhos ou objetos {"id", "path"}; cada item passa pelas rotas normais,
+    // em paralelo, e volta com o status e o JSON da sua resposta, na mesma ordem
+    CROW_ROUTE(app, "/api/batch").methods("POST"_method)
+    ([&app](const crow::request& req) {
+        static const size_t kBatchMaxRequests = 20;
+        static const size_t kBatchThreads = 4;
+
+        auto json = crow::json::load(req.body);
+        if (!json) {
+            return crow::response(400, "{\"success\": false, \"error\": \"JSON inválido\"}");
+        }
+        const crow::json::rvalue* items = &json;
+        if (json.t() == crow::json::type::Object && json.has("requests")) {
+            items = &json["requests"];
+        }
+        if (items->t() != crow::json::type::List || items->size() == 0 || items->size() > kBatchMaxRequests) {
+            return crow::response(400, "{\"success\": false, \"error\": \"Envie de 1 a 20 requisições\"}");
+        }
+
+        struct SubRequest {
+            std::string id;
+            std::string path;
+            std::string error;
+            crow::response res;
+        };
+        std::vector<SubRequest> subs(items->size());
+        for (size_t i = 0; i < subs.size(); i++) {
+            const auto& item = (*items)[i];
+            SubRequest& sub = subs[i];
+            sub.id = std::to_string(i);
+            if (item.t() == crow::json::type::String) {
+                sub.path = item.s();
+            } else if (item.t() == crow::json::type::Object && item.has("path")) {
+                sub.path = item["path"].s();
+                if (item.has("id")) sub.id = item["id"].t() == crow::json::type::String
+                                                 ? std::string(item["id"].s())
+                                                 : std::to_string(item["id"].i());
+                if (item.has("method") && std::string(item["method"].s()) != "GET") {
+                    sub.error = "Apenas GET é permitido em lote";
+                }
+            } else {
+                sub.error = "Item sem path";
+            }
+            if (sub.error.empty() && (sub.path.compare(0, 5, "/api/") != 0 || sub.path.compare(0, 10, "/api/batch") == 0)) {
+                sub.error = "Caminho inválido";
+            }
+        }
+
+        // Cada leitura usa a mesma rota de uma requisição avulsa (inclusive os
+        // cabeçalhos do pedido original); as que não tocam no banco não esperam
+        // pelas que estão no db_mutex. handle_full pula o middleware, então o
+        // trace e as métricas de cada item são abertos aqui.
+        bool force_trace = req.get_header_value("X-Trace") == "1";
+        auto dispatch = [&](SubRequest& sub) {
+            if (!sub.error.empty()) return;
+            crow::request sub_req;
+            sub_req.method = crow::HTTPMethod::Get;
+            sub_req.raw_url = sub.path;
+            sub_req.url = sub.path.substr(0, sub.path.find('?'));
+            sub_req.url_params = crow::query_string(sub.path);
+            sub_req.headers = req.headers;
+            sub_req.headers.erase("Accept");   // o lote embute as respostas em JSON
+            sub_req.remote_ip_address = req.remote_ip_address;
+
+            // Numa thread do pool vira um trace próprio; na thread do handler
+            // o span fica aninhado no trace do /api/batch
+            TraceRequest trace("GET " + sub_req.url + " (batch)", force_trace);
+            TRACE_SPAN("batch.request", sub.path);
+            auto started = std::chrono::steady_clock::now();
+            app.handle_full(sub_req, sub.res);
+
+            batch_call_metrics.requests.fetch_add(1, std::memory_order_relaxed);
+            batch_call_metrics.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count());
+            if (sub.res.code >= 500) {
+                batch_call_metrics.status_5xx.fetch_add(1, std::memory_order_relaxed);
+            } else if (sub.res.code >= 400) {
+                batch_call_metrics.status_4xx.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                batch_call_metrics.status_2xx.fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        // Pool fixo compartilhado entre lotes; se outro lote estiver usando,
+        // este roda na própria thread do handler em vez de esperar na fila
+        static WorkStealingPool pool(static_cast<int>(kBatchThreads));
+        static std::mutex pool_mutex;
+        std::unique_lock<std::mutex> pool_lock(pool_mutex, std::try_to_lock);
+        if (pool_lock.owns_lock()) {
+            pool.parallelFor(subs.size(), 1, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++) dispatch(subs[i]);
+            });
+            pool_lock.unlock();
+        } else {
+            for (auto& sub : subs) dispatch(sub);
+        }
+
+        std::vector<crow::json::wvalue> responses;
+        for (auto& sub : subs) {
+            crow::json::wvalue entry;
+            entry["id"] = sub.id;
+            entry["path"] = sub.path;
+            if (!sub.error.empty()) {
+                entry["status"] = 400;
+                entry["error"] = sub.error;
+            } else {
+                entry["status"] = sub.res.code;
+                auto body = crow::json::load(sub.res.body);
+                if (body) {
+                    entry["body"] = body;
+                } else {
+                    entry["body"] = sub.res.body;
+                }
+            }
+            responses.push_back(std::move(entry));
+        }
+
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["count"] = responses.size();
+        response["responses"] = std::move(responses);
+        return jsonResponse(response);
+    });
+
+
     // API - LISTAR FILMES
     CROW_ROUTE(app, "/api/movies")
-([]() {
-    std::cout << "🎬 /api/movies chamada" << std::endl;
+([](const crow::request& req) {
+    LOG_SAMPLED(LogLevel::Info, "🎬 /api/movies chamada");
 
     try {
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("GET /api/movies"));
         auto movies = global_db->getAllMovies();
-
-        std::cout << "📊 " << movies.size() << " filmes encontrados" << std::endl;
+        int64_t change_seq = global_db->latestMovieChangeSeq();
+
+        LOG_DEBUG("📊 %zu filmes encontrados", movies.size());
+
+        if (acceptsMsgpack(req)) {
+            MsgpackWriter out;
+            {
+                TRACE_SPAN("msgpack.encode");
+                out.reserve(movies.size() * 512);
+                out.mapHeader(4);
+                out.key("success");
+                out.boolean(true);
+                out.key("count");
+                out.integer(static_cast<int64_t>(movies.size()));
+                out.key("change_seq");
+                out.integer(change_seq);
+                out.key("movies");
+                out.arrayHeader(static_cast<uint32_t>(movies.size()));
+                for (const auto& movie : movies) writeMovie(out, movie);
+            }
+            auto response = msgpackResponse(out);
+            response.add_header("Access-Control-Allow-Origin", "*");
+            response.add_header("Vary", "Accept");
+            return response;
+        }
 
         crow::json::wvalue result;
         result["success"] = true;
         result["count"] = static_cast<int>(movies.size());
+        // Ponto de partida para /api/movies/changes?since=
+        result["change_seq"] = change_seq;
 
         std::vector<crow::json::wvalue> movie_list;
         for (const auto& movie : movies) {
@@ -248,30 +1064,90 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
         }
         result["movies"] = std::move(movie_list);
 
-        auto response = crow::response{result};
+        auto response = jsonResponse(result);
         response.add_header("Content-Type", "application/json");
         response.add_header("Access-Control-Allow-Origin", "*");
+        response.add_header("Vary", "Accept");
 
-        std::cout << "✅ Resposta enviada" << std::endl;
+        LOG_DEBUG("✅ Resposta enviada");
         return response;
 
     } catch (const std::exception& e) {
-        std::cout << "❌ Erro: " << e.what() << std::endl;
+        LOG_ERROR("❌ Erro em /api/movies: %s", e.what());
         crow::json::wvalue error_result;
         error_result["success"] = false;
         error_result["error"] = "Erro interno";
 
-        auto response = crow::response{error_result};
+        auto response = jsonResponse(error_result);
         response.add_header("Content-Type", "application/json");
         response.add_header("Access-Control-Allow-Origin", "*");
         return response;
     }
 });
 
+    // API - Alterações no catálogo desde um seq (?since=N, ?limit= até 5000).
+    // Devolve os filmes novos/alterados e os ids excluídos; o cliente guarda
+    // next_since e repete enquanto has_more
+    CROW_ROUTE(app, "/api/movies/changes")
+    ([](const crow::request& req) {
+        const char* since_param = req.url_params.get("since");
+        int64_t since = since_param ? std::max(0LL, std::atoll(since_param)) : 0;
+        int limit = 1000;
+        if (const char* limit_param = req.url_params.get("limit")) {
+            limit = std::max(1, std::min(std::atoi(limit_param), 5000));
+        }
+
+        std::vector<MovieChange> changes;
+        int64_t latest_seq = 0;
+        {
+            auto lock = lockDatabase(LOCK_SITE("GET /api/movies/changes"));
+            if (!global_db->getMovieChanges(since, limit, changes)) {
+                return crow::response(503, "{\"success\": false, \"error\": \"Feed de alterações indisponível\"}");
+            }
+            latest_seq = global_db->latestMovieChangeSeq();
+        }
+
+        std::vector<crow::json::wvalue> movie_list;
+        std::vector<crow::json::wvalue> deleted;
+        for (const auto& change : changes) {
+            if (change.deleted) {
+                deleted.push_back(change.movie_id);
+                continue;
+            }
+            const Movie& movie = change.movie;
+            crow::json::wvalue movie_json;
+            movie_json["id"] = movie.id;
+            movie_json["title"] = movie.title;
+            movie_json["imdb_id"] = movie.imdb_id;
+            movie_json["genre"] = movie.genre;
+            movie_json["year"] = movie.year;
+            movie_json["actors"] = movie.actors;
+            movie_json["description"] = movie.description;
+            movie_json["poster_url"] = movie.poster_url;
+            movie_json["imdb_rating"] = movie.imdb_rating;
+            movie_json["rotten_tomatoes_rating"] = movie.rotten_tomatoes_rating;
+            movie_list.push_back(std::move(movie_json));
+        }
+
+        int64_t next_since = changes.empty() ? since : changes.back().seq;
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["since"] = since;
+        response["next_since"] = next_since;
+        response["latest_seq"] = latest_seq;
+        response["has_more"] = next_since < latest_seq;
+        response["movies"] = std::move(movie_list);
+        response["deleted"] = std::move(deleted);
+
+        auto res = jsonResponse(response);
+        res.add_header("Access-Control-Allow-Origin", "*");
+        return res;
+    });
+
     // API - Buscar filme por ID
     CROW_ROUTE(app, "/api/movies/<int>")
     ([](int movie_id) {
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("GET /api/movies/<id>"));
         Movie* movie = global_db->getMovieById(movie_id);
 
         crow::json::wvalue response;
@@ -295,7 +1171,89 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             response["error"] = "Filme não encontrado";
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
+    });
+
+    // API - Filmes parecidos por conteúdo (sinopse, gênero e atores)
+    CROW_ROUTE(app, "/api/movies/<int>/similar")
+    ([](const crow::request& req, int movie_id) {
+        int limit = req.url_params.get("limit") ? std::atoi(req.url_params.get("limit")) : 10;
+        limit = std::max(1, std::min(limit, 50));
+
+        crow::json::wvalue response;
+        const char* method_param = req.url_params.get("method");
+        vector<ScoredMovie> similar;
+        std::string method;
+
+        // Sem ?method=, a lista gravada pelo último recálculo em lote tem
+        // prioridade; filmes sem lista gravada (ex.: recém-cadastrados) caem
+        // no cálculo ao vivo
+        if (!method_param) {
+            auto lock = lockDatabase(LOCK_SITE("GET /api/movies/<id>/similar"));
+            for (const auto& row : global_db->getStoredSimilarMovies(movie_id, limit)) {
+                similar.push_back({row.movie_id, row.score});
+            }
+            if (!similar.empty()) method = "precomputed";
+        }
+
+        std::shared_ptr<const ContentIndex> index = currentContentIndex();
+        if (method.empty() && (!index || !index->contains(movie_id))) {
+            response["success"] = false;
+            response["error"] = index ? "Filme não encontrado no índice" : "Índice de conteúdo ainda em construção";
+            crow::response res = jsonResponse(response);
+            res.code = index ? 404 : 503;
+            return res;
+        }
+
+        // ?method=ann|exact; sem parâmetro, catálogos grandes usam o HNSW
+        // Durante a reconstrução o HNSW publicado ainda é do dicionário
+        // anterior: a consulta só é comparável se os fingerprints baterem
+        std::shared_ptr<HnswIndex> ann = method.empty() ? currentMovieAnn() : nullptr;
+        if (ann && ann->fingerprint() != index->fingerprint()) ann = nullptr;
+        if (method.empty()) {
+            method = method_param ? method_param : (ann && ann->size() >= annMinMovies() ? "ann" : "exact");
+            if (!ann) method = "exact";
+        }
+
+        if (method == "exact") {
+            similar = index->similar(movie_id, limit);
+        }
+
+        auto lock = lockDatabase(LOCK_SITE("GET /api/movies/<id>/similar"));
+        if (method == "ann") {
+            Movie* source = global_db->getMovieById(movie_id);
+            if (source) {
+                std::vector<float> query = index->embed(*source);
+                for (const auto& item : ann->search(query.data(), limit + 1)) {
+                    if (item.movie_id != movie_id && static_cast<int>(similar.size()) < limit) {
+                        similar.push_back(item);
+                    }
+                }
+                delete source;
+            }
+        }
+
+        vector<crow::json::wvalue> movie_list;
+        for (const auto& item : similar) {
+            Movie* movie = global_db->getMovieById(item.movie_id);
+            if (!movie) continue;
+
+            crow::json::wvalue movie_json;
+            movie_json["id"] = movie->id;
+            movie_json["title"] = movie->title;
+            movie_json["genre"] = movie->genre;
+            movie_json["year"] = movie->year;
+            movie_json["imdb_rating"] = movie->imdb_rating;
+            movie_json["poster_url"] = movie->poster_url;
+            movie_json["similarity"] = item.score;
+            movie_list.push_back(movie_json);
+            delete movie;
+        }
+
+        response["success"] = true;
+        response["method"] = method;
+        response["similar"] = move(movie_list);
+        return jsonResponse(response);
     });
 
     // API - Login
@@ -309,7 +1267,7 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
         string username = json["username"].s();
         string password = json["password"].s();
 
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("POST /api/login"));
         User* user = global_db->getUserByUsername(username);
 
         crow::json::wvalue response;
@@ -327,7 +1285,7 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             if (user) delete user;
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
     });
 
     // API - Registrar usuário
@@ -341,7 +1299,7 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
         string username = json["username"].s();
         string password = json["password"].s();
 
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("POST /api/register"));
 
         // Verificar se usuário existe
         User* existing = global_db->getUserByUsername(username);
@@ -368,20 +1326,123 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             response["error"] = "Erro ao criar usuário";
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
     });
 
 
 
     // API - Obter recomendações
     CROW_ROUTE(app, "/api/recommendations/<int>")
-    ([](int user_id) {
-        std::lock_guard<std::mutex> lock(db_mutex);
+    ([](const crow::request& req, int user_id) {
+        auto lock = lockDatabase(LOCK_SITE("GET /api/recommendations/<id>"));
 
         crow::json::wvalue response;
 
+        // ?mode=cf (item-item), ?mode=als (fatores latentes) ou ?mode=content
+        // (TF-IDF): modelos locais, sem depender do OpenRouter
+        const char* mode_param = req.url_params.get("mode");
+        std::string mode = mode_param ? mode_param : "";
+        if (mode == "cf" || mode == "als" || mode == "content") {
+            vector<Rating> ratings = global_db->getUserRatings(user_id);
+            vector<ScoredMovie> scored;
+            if (mode == "cf") {
+                if (auto model = currentItemCF()) scored = model->recommend(ratings, 10);
+            } else if (mode == "als") {
+                if (auto model = currentALS()) scored = model->recommend(ratings, 10);
+            } else {
+                if (auto index = currentContentIndex()) scored = index->recommend(ratings, 10);
+            }
+
+            vector<crow::json::wvalue> movie_list;
+            for (const auto& item : scored) {
+                Movie* movie = global_db->getMovieById(item.movie_id);
+                if (!movie) continue;
+
+                crow::json::wvalue movie_json;
+                movie_json["id"] = movie->id;
+                movie_json["title"] = movie->title;
+                movie_json["genre"] = movie->genre;
+                movie_json["year"] = movie->year;
+                movie_json["imdb_rating"] = movie->imdb_rating;
+                movie_json["poster_url"] = movie->poster_url;
+                movie_json["score"] = item.score;
+                movie_list.push_back(movie_json);
+                delete movie;
+            }
+
+            if (movie_list.empty() && ratings.empty()) {
+                movie_list = trendingMovieList(*global_trending.latest("24h"), 10);
+                if (!movie_list.empty()) {
+                    response["type"] = "trending";
+                    response["message"] = "Em alta nas últimas 24 horas";
+                }
+            } else if (!movie_list.empty()) {
+                response["type"] = mode;
+                response["message"] = recommendationMessage(mode);
+            }
+
+            if (movie_list.empty()) {
+                // Sem modelo ainda: popularidade no gênero favorito
+                for (const auto& movie : global_db->getRecommendations(user_id, 10)) {
+                    crow::json::wvalue movie_json;
+                    movie_json["id"] = movie.id;
+                    movie_json["title"] = movie.title;
+                    movie_json["genre"] = movie.genre;
+                    movie_json["year"] = movie.year;
+                    movie_json["imdb_rating"] = movie.imdb_rating;
+                    movie_json["poster_url"] = movie.poster_url;
+                    movie_list.push_back(movie_json);
+                }
+                response["type"] = "general";
+                response["message"] = "Recomendações baseadas em popularidade";
+            }
+            response["recommendations"] = move(movie_list);
+            response["success"] = true;
+
+            return jsonResponse(response);
+        }
+
+        // Padrão: top-N pré-calculado pelo RecoStore; ?mode=ai força o OpenRouter
+        if (mode != "ai" && global_reco_store) {
+            if (auto stored = global_reco_store->lookup(user_id)) {
+                vector<crow::json::wvalue> movie_list;
+                for (const auto& item : stored->movies) {
+                    Movie* movie = global_db->getMovieById(item.movie_id);
+                    if (!movie) continue;
+
+                    crow::json::wvalue movie_json;
+                    movie_json["id"] = movie->id;
+                    movie_json["title"] = movie->title;
+                    movie_json["genre"] = movie->genre;
+                    movie_json["year"] = movie->year;
+                    movie_json["imdb_rating"] = movie->imdb_rating;
+                    movie_json["poster_url"] = movie->poster_url;
+                    movie_json["score"] = item.score;
+                    movie_list.push_back(movie_json);
+                    delete movie;
+                }
+
+                if (!movie_list.empty()) {
+                    int64_t now = static_cast<int64_t>(std::time(nullptr));
+                    response["type"] = "precomputed";
+                    response["source"] = stored->source;
+                    response["message"] = recommendationMessage(stored->source);
+                    response["computed_at"] = stored->computed_at;
+                    response["age_seconds"] = now - stored->computed_at;
+                    response["stale"] = global_reco_store->isDirty(user_id);
+                    response["recommendations"] = move(movie_list);
+                    response["success"] = true;
+                    return jsonResponse(response);
+                }
+            }
+        }
+
         // Obter histórico do usuário
         vector<Rating> ratings = global_db->getUserRatings(user_id);
+        if (!ratings.empty() && global_reco_store) {
+            // Ainda não calculado (ex.: servidor recém-iniciado): entra na próxima rodada
+            global_reco_store->markDirty(user_id);
+        }
         vector<Movie> history;
         for (const auto& rating : ratings) {
             Movie* movie = global_db->getMovieById(rating.movie_id);
@@ -391,8 +1452,18 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             }
         }
 
+        vector<crow::json::wvalue> trending;
         if (history.empty()) {
-            // Sem histórico - recomendações gerais
+            trending = trendingMovieList(*global_trending.latest("24h"), 10);
+        }
+
+        if (!trending.empty()) {
+            // Sem histórico (cold start): o que está em alta agora
+            response["type"] = "trending";
+            response["message"] = "Em alta nas últimas 24 horas";
+            response["recommendations"] = move(trending);
+        } else if (history.empty()) {
+            // Sem histórico e nada em alta - recomendações gerais
             auto movies = global_db->getRecommendations(user_id, 10);
             response["type"] = "general";
             response["message"] = "Recomendações baseadas em popularidade";
@@ -457,7 +1528,32 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
 
         response["success"] = true;
 
-        return crow::response{response};
+        return jsonResponse(response);
+    });
+
+    // API - Filmes em alta (?window=1h|24h|7d, ?limit=N até 100)
+    CROW_ROUTE(app, "/api/trending")
+    ([](const crow::request& req) {
+        const char* window_param = req.url_params.get("window");
+        std::string window = window_param ? window_param : "24h";
+        std::shared_ptr<const TrendingSnapshot> snapshot = global_trending.latest(window);
+        if (!snapshot) {
+            return crow::response(400, "{\"success\": false, \"error\": \"Janela inválida (use 1h, 24h ou 7d)\"}");
+        }
+
+        size_t limit = 10;
+        if (const char* limit_param = req.url_params.get("limit")) {
+            limit = static_cast<size_t>(std::max(1, std::min(std::atoi(limit_param),
+                                                             static_cast<int>(TrendingTracker::kSnapshotSize))));
+        }
+
+        auto lock = lockDatabase(LOCK_SITE("GET /api/trending"));
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["window"] = snapshot->window;
+        response["snapshot_at"] = snapshot->taken_at;
+        response["movies"] = trendingMovieList(*snapshot, limit);
+        return jsonResponse(response);
     });
 
     // API - Buscar filme na OMDB (Admin)
@@ -470,7 +1566,7 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
 
         string title = json["title"].s();
 
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("POST /api/search-movie"));
         Movie movie = global_movie_api->searchMovie(title);
 
         crow::json::wvalue response;
@@ -491,7 +1587,7 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             response["error"] = "Filme não encontrado";
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
     });
 
     // API - Adicionar filme (Admin)
@@ -511,12 +1607,31 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
         movie.poster_url = json["poster_url"].s();
         movie.imdb_rating = json["imdb_rating"].d();
         movie.rotten_tomatoes_rating = json["rotten_tomatoes_rating"].d();
+        if (json.has("imdb_id")) {
+            movie.imdb_id = json["imdb_id"].s();
+        }
 
-        std::lock_guard<std::mutex> lock(db_mutex);
-        int movie_id = global_db->createMovie(movie);
+        auto lock = lockDatabase(LOCK_SITE("POST /api/movies"));
+        bool created = false;
+        int movie_id = global_db->createMovie(movie, &created);
 
         crow::json::wvalue response;
-        if (movie_id > 0) {
+        if (movie_id > 0 && !created) {
+            // Mesmo imdb_id (dados atualizados) ou título equivalente já cadastrado
+            response["success"] = true;
+            response["movie_id"] = movie_id;
+            response["duplicate"] = true;
+            response["message"] = "Filme já cadastrado";
+        } else if (movie_id > 0) {
+            // Filme novo já aparece em /similar sem esperar o próximo treino
+            movie.id = movie_id;
+            // O novo vocabulário/IDF muda todos os vetores: o HNSW é refeito em
+            // segundo plano e gravado com o fingerprint novo
+            std::thread([]() {
+                rebuildContentIndex();
+                loadOrBuildMovieAnn();
+            }).detach();
+
             response["success"] = true;
             response["movie_id"] = movie_id;
             response["message"] = "Filme adicionado com sucesso";
@@ -525,13 +1640,13 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             response["error"] = "Erro ao adicionar filme";
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
     });
 
     // API - Estatísticas (Admin)
     CROW_ROUTE(app, "/api/stats")
     ([]() {
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("GET /api/stats"));
 
         auto genre_ratings = global_db->getAverageRatingsByGenre();
         auto all_movies = global_db->getAllMovies();
@@ -549,7 +1664,399 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
         }
         response["genre_ratings"] = move(genre_list);
 
-        return crow::response{response};
+        return jsonResponse(response);
+    });
+
+    // API - Perfil das consultas SQL (Admin)
+    CROW_ROUTE(app, "/api/admin/db-profile")
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        QueryProfiler& profiler = global_db->queryProfiler();
+        std::vector<QueryStats> queries = profiler.snapshot();
+        if (req.url_params.get("reset")) {
+            profiler.reset();
+        }
+
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["slow_threshold_ms"] = profiler.slowThresholdMs();
+
+        vector<crow::json::wvalue> query_list;
+        for (const auto& query : queries) {
+            crow::json::wvalue query_json;
+            query_json["sql"] = query.sql;
+            query_json["calls"] = query.calls;
+            query_json["rows"] = query.rows;
+            query_json["total_ms"] = query.total_ns / 1e6;
+            query_json["avg_ms"] = query.total_ns / 1e6 / query.calls;
+            query_json["max_ms"] = query.max_ns / 1e6;
+            query_json["slow_calls"] = query.slow_calls;
+            if (!query.plan.empty()) {
+                query_json["plan"] = query.plan;
+            }
+            query_list.push_back(query_json);
+        }
+        response["queries"] = move(query_list);
+
+        return jsonResponse(response);
+    });
+
+    CROW_ROUTE(app, "/api/admin/http-metrics")
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        crow::json::wvalue response;
+        response["success"] = true;
+
+        vector<crow::json::wvalue> upstream_list;
+        for (const UpstreamMetrics* upstream : HttpMetrics::instance().upstreams()) {
+            crow::json::wvalue upstream_json;
+            upstream_json["name"] = upstream->name;
+            upstream_json["requests"] = upstream->requests.load();
+            upstream_json["errors"] = upstream->errors.load();
+            upstream_json["timeouts"] = upstream->timeouts.load();
+            upstream_json["bytes_sent"] = upstream->bytes_sent.load();
+            upstream_json["bytes_received"] = upstream->bytes_received.load();
+            upstream_json["status"]["2xx"] = upstream->status_2xx.load();
+            upstream_json["status"]["4xx"] = upstream->status_4xx.load();
+            upstream_json["status"]["5xx"] = upstream->status_5xx.load();
+
+            crow::json::wvalue errors_by_code;
+            for (int code = 1; code < UpstreamMetrics::kMaxCurlCode; code++) {
+                uint64_t count = upstream->errors_by_code[code].load();
+                if (count > 0) {
+                    errors_by_code[std::to_string(code) + " " + curl_easy_strerror(static_cast<CURLcode>(code))] = count;
+                }
+            }
+            upstream_json["errors_by_code"] = move(errors_by_code);
+
+            upstream_json["dns"] = histogramJson(upstream->dns);
+            upstream_json["connect"] = histogramJson(upstream->connect);
+            upstream_json["tls"] = histogramJson(upstream->tls);
+            upstream_json["first_byte"] = histogramJson(upstream->first_byte);
+            upstream_json["total"] = histogramJson(upstream->total);
+
+            const LatencyHistogram& size = upstream->response_size;
+            upstream_json["response_bytes"]["avg"] = size.averageMicros();
+            upstream_json["response_bytes"]["p50"] = size.percentileMicros(0.50);
+            upstream_json["response_bytes"]["p99"] = size.percentileMicros(0.99);
+            upstream_json["response_bytes"]["max"] = size.maxMicros();
+
+            upstream_list.push_back(move(upstream_json));
+        }
+        response["upstreams"] = move(upstream_list);
+
+        response["batch_subrequests"]["requests"] = batch_call_metrics.requests.load();
+        response["batch_subrequests"]["status"]["2xx"] = batch_call_metrics.status_2xx.load();
+        response["batch_subrequests"]["status"]["4xx"] = batch_call_metrics.status_4xx.load();
+        response["batch_subrequests"]["status"]["5xx"] = batch_call_metrics.status_5xx.load();
+        response["batch_subrequests"]["latency"] = histogramJson(batch_call_metrics.latency);
+
+        if (req.url_params.get("reset")) {
+            HttpMetrics::instance().reset();
+            batch_call_metrics.requests = 0;
+            batch_call_metrics.status_2xx = 0;
+            batch_call_metrics.status_4xx = 0;
+            batch_call_metrics.status_5xx = 0;
+            batch_call_metrics.latency.reset();
+        }
+
+        return jsonResponse(response);
+    });
+
+    CROW_ROUTE(app, "/api/admin/recommender/rebuild").methods("POST"_method)
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        if (!claimRecommenderRebuild()) {
+            return crow::response(409, "{\"success\": false, \"error\": \"Treinamento já em andamento\"}");
+        }
+        std::thread([]() { runClaimedRecommenderRebuild(); }).detach();
+
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["message"] = "Treinamento do modelo iniciado";
+        crow::response res = jsonResponse(response);
+        res.code = 202;
+        return res;
+    });
+
+    CROW_ROUTE(app, "/api/admin/recommender/batch").methods("GET"_method, "POST"_method)
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        if (req.method == crow::HTTPMethod::Get) {
+            std::lock_guard<std::mutex> lock(batch_report_mutex);
+            if (last_batch_report.finished_at == 0) {
+                return crow::response(404, "{\"success\": false, \"error\": \"Nenhum recálculo em lote executado\"}");
+            }
+            crow::json::wvalue response;
+            response["success"] = true;
+            response["running"] = batch_running.load();
+            response["report"] = batchReportJson(last_batch_report);
+            return jsonResponse(response);
+        }
+
+        // Reserva aqui, não na thread: dois POSTs simultâneos não podem
+        // receber 202 para um único lote
+        if (!claimBatchRecompute()) {
+            return crow::response(409, "{\"success\": false, \"error\": \"Recálculo em lote já em andamento\"}");
+        }
+        std::thread([]() { runClaimedBatchRecompute(); }).detach();
+
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["message"] = "Recálculo em lote iniciado";
+        crow::response res = jsonResponse(response);
+        res.code = 202;
+        return res;
+    });
+
+    CROW_ROUTE(app, "/api/admin/reco-store")
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+        if (!global_reco_store) {
+            return crow::response(503, "{\"success\": false, \"error\": \"Recomendações pré-calculadas desativadas\"}");
+        }
+
+        RecoStoreStats stats = global_reco_store->stats();
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["users"] = stats.users;
+        response["dirty"] = stats.dirty;
+        response["runs"] = stats.runs;
+        response["recomputed"] = stats.recomputed;
+        response["last_run_users"] = stats.last_run_users;
+        response["last_run_at"] = stats.last_run_at;
+        response["compute"] = histogramJson(global_reco_store->computeLatency());
+        return jsonResponse(response);
+    });
+
+    CROW_ROUTE(app, "/api/admin/rating-writer")
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        RatingWriterStats stats = global_rating_writer->stats();
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["enqueued"] = stats.enqueued;
+        response["committed"] = stats.committed;
+        response["failed"] = stats.failed;
+        response["pending"] = stats.pending;
+        response["batches"] = stats.batches;
+        response["largest_batch"] = stats.largest_batch;
+        response["avg_batch"] = stats.batches ? static_cast<double>(stats.committed + stats.failed) / stats.batches : 0.0;
+        response["commit"] = histogramJson(global_rating_writer->commitLatency());
+        response["queue"] = histogramJson(global_rating_writer->queueLatency());
+        return jsonResponse(response);
+    });
+
+    // Importação em massa: corpo NDJSON ou CSV, processado linha a linha em
+    // transações de kBulkChunkRows; devolve os erros por linha e a vazão
+    CROW_ROUTE(app, "/api/admin/ratings/bulk").methods("POST"_method)
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        const std::string& body = req.body;
+        std::string format = req.url_params.get("format") ? req.url_params.get("format") : "";
+        if (format.empty()) {
+            std::string content_type = req.get_header_value("Content-Type");
+            if (content_type.find("csv") != std::string::npos) {
+                format = "csv";
+            } else if (content_type.find("json") != std::string::npos) {
+                format = "ndjson";
+            } else {
+                size_t first = body.find_first_not_of(" \t\r\n");
+                format = first != std::string::npos && body[first] == '{' ? "ndjson" : "csv";
+            }
+        }
+        if (format != "csv" && format != "ndjson") {
+            return crow::response(400, "{\"success\": false, \"error\": \"Formato deve ser csv ou ndjson\"}");
+        }
+        bool csv = format == "csv";
+
+        auto started = std::chrono::steady_clock::now();
+        std::vector<RatingInput> chunk;
+        std::vector<size_t> chunk_lines;   // linha de origem de cada item do chunk
+        std::vector<RatingRowError> chunk_errors;
+        std::vector<crow::json::wvalue> errors;
+        size_t rows = 0, inserted = 0, failed = 0;
+
+        auto report = [&](size_t line, const std::string& error) {
+            failed++;
+            if (errors.size() < kBulkMaxReportedErrors) {
+                crow::json::wvalue item;
+                item["line"] = line;
+                item["error"] = error;
+                errors.push_back(std::move(item));
+            }
+        };
+
+        auto flush = [&]() {
+            if (chunk.empty()) return;
+            chunk_errors.clear();
+            {
+                auto lock = lockDatabase(LOCK_SITE("POST /api/admin/ratings/bulk"));
+                inserted += global_db->addRatingsBatch(chunk.data(), chunk.size(), &chunk_errors, chunk.size());
+            }
+            for (const auto& error : chunk_errors) {
+                report(chunk_lines[error.index], error.error);
+            }
+            chunk.clear();
+            chunk_lines.clear();
+        };
+
+        size_t line_number = 0;
+        std::string line;
+        std::string error;
+        for (size_t pos = 0; pos < body.size();) {
+            size_t end = body.find('\n', pos);
+            if (end == std::string::npos) end = body.size();
+            line.assign(body, pos, end - pos);
+            pos = end + 1;
+            line_number++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.find_first_not_of(" \t") == std::string::npos) continue;
+
+            RatingInput input{0, 0, 0.0, 0};
+            bool parsed = csv ? parseBulkCsvLine(line, input, error) : parseBulkJsonLine(line, input, error);
+            // Cabeçalho opcional na primeira linha do CSV
+            if (!parsed && csv && line_number == 1 && line.find("user_id") != std::string::npos) {
+                continue;
+            }
+
+            rows++;
+            if (!parsed) {
+                report(line_number, error);
+                continue;
+            }
+            chunk.push_back(input);
+            chunk_lines.push_back(line_number);
+            if (chunk.size() >= kBulkChunkRows) {
+                flush();
+            }
+        }
+        flush();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        LOG_INFO("📥 Importação em massa (%s): %zu linhas, %zu gravadas, %zu com erro em %.2f s",
+                 format.c_str(), rows, inserted, failed, seconds);
+
+        crow::json::wvalue response;
+        response["success"] = failed == 0;
+        response["format"] = format;
+        response["rows"] = rows;
+        response["inserted"] = inserted;
+        response["failed"] = failed;
+        response["errors"] = std::move(errors);
+        response["errors_truncated"] = failed > kBulkMaxReportedErrors;
+        response["seconds"] = seconds;
+        response["rows_per_second"] = seconds > 0 ? rows / seconds : 0.0;
+        return jsonResponse(response);
+    });
+
+    CROW_ROUTE(app, "/api/admin/migrations")
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        auto lock = lockDatabase(LOCK_SITE("GET /api/admin/migrations"));
+        MigrationRunner runner(*global_db, schemaMigrations());
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["version"] = runner.currentVersion();
+        response["latest"] = runner.latestVersion();
+
+        std::vector<crow::json::wvalue> applied;
+        for (const auto& record : runner.history()) {
+            crow::json::wvalue item;
+            item["version"] = record.version;
+            item["name"] = record.name;
+            item["applied_at"] = record.applied_at;
+            item["duration_ms"] = record.duration_ms;
+            applied.push_back(std::move(item));
+        }
+        response["migrations"] = std::move(applied);
+        return jsonResponse(response);
+    });
+
+    CROW_ROUTE(app, "/api/admin/locks")
+    ([](const crow::request& req) {
+        if (!isAdminRequest(req)) {
+            return adminOnlyResponse();
+        }
+
+        // Padrão: quem mais fez os outros esperarem (ex.: segurar o lock durante I/O de rede)
+        std::string sort_by = req.url_params.get("sort") ? req.url_params.get("sort") : "caused";
+        // Os contadores continuam mudando durante a requisição: copia os
+        // valores antes de ordenar para o comparador ser estável
+        struct SiteSnapshot {
+            const LockSite* site;
+            uint64_t acquisitions;
+            uint64_t contended;
+            uint64_t wait_us;
+            uint64_t hold_us;
+            uint64_t caused_ns;
+        };
+        std::vector<SiteSnapshot> sites;
+        for (const LockSite* site : LockProfiler::instance().sites()) {
+            uint64_t acquisitions = site->acquisitions.load();
+            if (acquisitions == 0) continue;
+            sites.push_back({site, acquisitions, site->contended.load(), site->wait.sumMicros(),
+                             site->hold.sumMicros(), site->caused_wait_ns.load()});
+        }
+        std::sort(sites.begin(), sites.end(), [&sort_by](const SiteSnapshot& a, const SiteSnapshot& b) {
+            if (sort_by == "wait") return a.wait_us > b.wait_us;
+            if (sort_by == "hold") return a.hold_us > b.hold_us;
+            return a.caused_ns > b.caused_ns;
+        });
+
+        crow::json::wvalue response;
+        response["success"] = true;
+        response["sort"] = sort_by;
+
+        vector<crow::json::wvalue> site_list;
+        for (const SiteSnapshot& snapshot : sites) {
+            const LockSite* site = snapshot.site;
+            const char* mutex_name = site->mutex_name.load();
+            crow::json::wvalue site_json;
+            site_json["site"] = site->name;
+            site_json["mutex"] = mutex_name ? mutex_name : "";
+            std::string file = site->file;
+            site_json["location"] = file.substr(file.find_last_of('/') + 1) + ":" + std::to_string(site->line);
+            site_json["acquisitions"] = snapshot.acquisitions;
+            site_json["contended"] = snapshot.contended;
+            site_json["contention_rate"] = static_cast<double>(snapshot.contended) / snapshot.acquisitions;
+            site_json["wait_total_ms"] = snapshot.wait_us / 1000.0;
+            site_json["hold_total_ms"] = snapshot.hold_us / 1000.0;
+            site_json["caused_wait_ms"] = snapshot.caused_ns / 1e6;
+            site_json["wait"] = histogramJson(site->wait);
+            site_json["hold"] = histogramJson(site->hold);
+            site_list.push_back(move(site_json));
+        }
+        response["sites"] = move(site_list);
+
+        if (req.url_params.get("reset")) {
+            LockProfiler::instance().reset();
+        }
+
+        return jsonResponse(response);
     });
 
     // Servir arquivos estáticos da estrutura nova
@@ -661,7 +2168,7 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
     // API - Obter informações do usuário
     CROW_ROUTE(app, "/api/user/<int>")
     ([](int user_id) {
-        std::lock_guard<std::mutex> lock(db_mutex);
+        auto lock = lockDatabase(LOCK_SITE("GET /api/user/<id>"));
 
         crow::json::wvalue response;
 
@@ -680,58 +2187,86 @@ CROW_ROUTE(app, "/api/user/<int>/recent-ratings")
             response["error"] = "Usuário não encontrado";
         }
 
-        return crow::response{response};
+        return jsonResponse(response);
     });
 
     // API - Obter avaliações do usuário (Minhas Avaliações)
 CROW_ROUTE(app, "/api/user/<int>/ratings")
 
-([](int user_id) {
-    std::lock_guard<std::mutex> lock(db_mutex);
+([](const crow::request& req, int user_id) {
+    auto lock = lockDatabase(LOCK_SITE("GET /api/user/<id>/ratings"));
 
     crow::json::wvalue response;
 
     // Obter todas as avaliações do usuário
     std::vector<Rating> user_ratings = global_db->getUserRatings(user_id);
 
+    // Buscar detalhes dos filmes
+    std::vector<std::pair<Rating, Movie>> rated;
+    for (const auto& rating : user_ratings) {
+        Movie* movie = global_db->getMovieById(rating.movie_id);
+        if (movie) {
+            rated.emplace_back(rating, *movie);
+            delete movie;
+        }
+    }
+
+    if (acceptsMsgpack(req)) {
+        MsgpackWriter out;
+        {
+            TRACE_SPAN("msgpack.encode");
+            out.reserve(rated.size() * 512);
+            out.mapHeader(3);
+            out.key("success");
+            out.boolean(true);
+            out.key("count");
+            out.integer(static_cast<int64_t>(rated.size()));
+            out.key("ratings");
+            out.arrayHeader(static_cast<uint32_t>(rated.size()));
+            for (const auto& entry : rated) writeUserRating(out, entry.first, entry.second);
+        }
+        auto res = msgpackResponse(out);
+        res.add_header("Vary", "Accept");
+        return res;
+    }
+
     if (user_ratings.empty()) {
         response["success"] = true;
         response["message"] = "Nenhuma avaliação encontrada";
         response["ratings"] = crow::json::wvalue::list();
 
-        return crow::response{response};
+        return jsonResponse(response);
     }
 
     std::vector<crow::json::wvalue> ratings_list;
 
-    for (const auto& rating : user_ratings) {
-        // Buscar detalhes do filme
-        Movie* movie = global_db->getMovieById(rating.movie_id);
-        if (movie) {
-            crow::json::wvalue rating_json;
-            rating_json["rating_id"] = rating.id;
-            rating_json["movie_id"] = movie->id;
-            rating_json["title"] = movie->title;
-            rating_json["year"] = movie->year;
-            rating_json["genre"] = movie->genre;
-            rating_json["poster_url"] = movie->poster_url;
-            rating_json["imdb_rating"] = movie->imdb_rating;
-            rating_json["rotten_tomatoes_rating"] = movie->rotten_tomatoes_rating;
-            rating_json["user_rating"] = rating.rating;
-            rating_json["rating_date"] = rating.timestamp;
-            rating_json["actors"] = movie->actors;
-            rating_json["description"] = movie->description;
-
-            ratings_list.push_back(rating_json);
-            delete movie;
-        }
+    for (const auto& entry : rated) {
+        const Rating& rating = entry.first;
+        const Movie& movie = entry.second;
+        crow::json::wvalue rating_json;
+        rating_json["rating_id"] = rating.id;
+        rating_json["movie_id"] = movie.id;
+        rating_json["title"] = movie.title;
+        rating_json["year"] = movie.year;
+        rating_json["genre"] = movie.genre;
+        rating_json["poster_url"] = movie.poster_url;
+        rating_json["imdb_rating"] = movie.imdb_rating;
+        rating_json["rotten_tomatoes_rating"] = movie.rotten_tomatoes_rating;
+        rating_json["user_rating"] = rating.rating;
+        rating_json["rating_date"] = rating.timestamp;
+        rating_json["actors"] = movie.actors;
+        rating_json["description"] = movie.description;
+
+        ratings_list.push_back(rating_json);
     }
 
     response["success"] = true;
     response["count"] = ratings_list.size();
     response["ratings"] = std::move(ratings_list);
 
-    return crow::response{response};
+    auto res = jsonResponse(response);
+    res.add_header("Vary", "Accept");
+    return res;
 });
 
 
@@ -1053,7 +2588,14 @@ void rateMovie(Database &db, User *user) {
         return;
     }
 
-    if (db.addRating(user->id, selected.id, rating)) {
+    // Mesma conexão do RatingWriter: sem o lock a avaliação poderia cair no
+    // meio da transação de um lote (e ser desfeita junto com ele)
+    bool saved;
+    {
+        auto lock = lockDatabase(LOCK_SITE("console.addRating"));
+        saved = db.addRating(user->id, selected.id, rating);
+    }
+    if (saved) {
         std::cout << "\n✅ Avaliação registrada com sucesso!\n";
         std::cout << "🤖 Suas recomendações inteligentes foram atualizadas!\n";
     } else {
@@ -1117,7 +2659,12 @@ void browseMovies(Database &db, User *user) {
                 std::cin >> rating;
 
                 if (rating >= 0 && rating <= 10) {
-                    if (db.addRating(user->id, movies[choice - 1].id, rating)) {
+                    bool saved;
+                    {
+                        auto lock = lockDatabase(LOCK_SITE("console.addRating"));
+                        saved = db.addRating(user->id, movies[choice - 1].id, rating);
+                    }
+                    if (saved) {
                         std::cout << "✅ Avaliação registrada!\n";
                     } else {
                         std::cout << "❌ Erro ao registrar avaliação!\n";
@@ -1172,8 +2719,16 @@ void adminAddMovieWithAI(Database &db, MovieAPI &movie_api) {
             std::cin >> confirm;
 
             if (confirm == 's' || confirm == 'S') {
-                int id = db.createMovie(movie);
-                if (id > 0) {
+                bool created = false;
+                int id;
+                {
+                    // O servidor web pode estar no ar: o detector de duplicatas é compartilhado
+                    auto lock = lockDatabase(LOCK_SITE("console.createMovie"));
+                    id = db.createMovie(movie, &created);
+                }
+                if (id > 0 && !created) {
+                    std::cout << "\nℹ️  Filme já estava cadastrado (ID: " << id << ")\n";
+                } else if (id > 0) {
                     std::cout << "\n✅ Filme adicionado com sucesso! ID: " << id << "\n";
                 } else {
                     std::cout << "\n❌ Erro ao adicionar filme!\n";
@@ -1220,8 +2775,15 @@ void adminAddMovieWithAI(Database &db, MovieAPI &movie_api) {
                     std::cin >> confirm;
 
                     if (confirm == 's' || confirm == 'S') {
-                        int id = db.createMovie(movie);
-                        if (id > 0) {
+                        bool created = false;
+                        int id;
+                        {
+                            auto lock = lockDatabase(LOCK_SITE("console.createMovie"));
+                            id = db.createMovie(movie, &created);
+                        }
+                        if (id > 0 && !created) {
+                            std::cout << "\nℹ️  Filme já estava cadastrado (ID: " << id << ")\n";
+                        } else if (id > 0) {
                             std::cout << "\n✅ Filme adicionado com sucesso! ID: " << id << "\n";
                         } else {
                             std::cout << "\n❌ Erro ao adicionar filme!\n";
@@ -1335,7 +2897,7 @@ void userMenu(Database &db, MovieAPI &movie_api, User *user) {
 
 
 // ===== FUNÇÃO MAIN =====
-int main() {
+int main(int argc, char* argv[]) {
 #ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
     SetConsoleCP(CP_UTF8);
@@ -1360,6 +2922,83 @@ int main() {
     global_db = &db;
     global_movie_api = &movie_api;
 
+    // Modo batch (ex.: cron noturno): treina, recalcula tudo e sai sem servidor
+    if (argc > 1 && std::string(argv[1]) == "--batch-recompute") {
+        rebuildContentIndex();
+        rebuildRecommenders();
+        runBatchRecomputeNow();
+
+        BatchReport report;
+        {
+            std::lock_guard<std::mutex> lock(batch_report_mutex);
+            report = last_batch_report;
+        }
+        std::cout << "📦 Recálculo em lote: " << report.users << " usuários, " << report.movies
+                  << " filmes, " << report.rows_written << " linhas gravadas (" << report.threads << " threads)\n";
+        for (const auto& stage : report.stages) {
+            std::cout << "   " << std::left << std::setw(14) << stage.name << std::right
+                      << std::fixed << std::setprecision(3) << std::setw(9) << stage.seconds << " s  "
+                      << std::setw(10) << stage.items << " itens  "
+                      << std::setprecision(0) << std::setw(10) << stage.itemsPerSecond() << " itens/s\n";
+        }
+        std::cout << "   total " << std::setprecision(3) << report.total_seconds << " s, "
+                  << std::setprecision(0) << report.itemsPerSecond() << " itens/s\n";
+        return report.success ? 0 : 1;
+    }
+
+    // Importação do catálogo: ./cine --ingest-catalog titulos.txt [--concurrency N]
+    // [--rps X] [--batch N] [--restart]
+    if (argc > 2 && std::string(argv[1]) == "--ingest-catalog") {
+        if (!movie_api.hasOMDBKey()) {
+            std::cerr << "❌ Configure a variável de ambiente OMDB_API_KEY\n";
+            return 1;
+        }
+
+        std::string path = argv[2];
+        CatalogIngestOptions options;
+        options.checkpoint_path = path + ".checkpoint";
+        for (int i = 3; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--concurrency" && has_value) options.concurrency = std::max(1, std::atoi(argv[++i]));
+            else if (arg == "--rps" && has_value) options.requests_per_second = std::atof(argv[++i]);
+            else if (arg == "--batch" && has_value) options.batch_size = std::max(1, std::atoi(argv[++i]));
+            else if (arg == "--restart") options.resume = false;
+        }
+
+        std::vector<std::string> entries = readCatalogEntries(path);
+        if (entries.empty()) {
+            std::cerr << "❌ Nenhum título encontrado em " << path << "\n";
+            return 1;
+        }
+        std::cout << "🎬 Importando " << entries.size() << " entradas de " << path << " ("
+                  << options.concurrency << " conexões, " << options.requests_per_second << " req/s)\n";
+
+        CatalogIngestReport report = runCatalogIngest(db,
+            []() { return lockDatabase(LOCK_SITE("catalog.ingest")); }, movie_api, entries, options,
+            [](const CatalogIngestProgress& progress) {
+                size_t done = progress.resumed + progress.fetched + progress.duplicates;
+                std::cout << "   … " << done << "/" << progress.total << " (" << progress.inserted << " novos, "
+                          << progress.duplicates << " duplicados, " << progress.not_found << " inexistentes, "
+                          << progress.failed << " falhas) " << std::fixed << std::setprecision(1)
+                          << progress.fetchesPerSecond() << " consultas/s\n" << std::flush;
+            });
+
+        for (size_t i = 0; i < report.failures.size() && i < 20; i++) {
+            std::cout << "   ❌ " << report.failures[i].first << ": " << report.failures[i].second << "\n";
+        }
+        if (report.failures.size() > 20) {
+            std::cout << "   … e mais " << report.failures.size() - 20 << " falhas\n";
+        }
+        if (report.progress.resumed > 0) {
+            std::cout << "   " << report.progress.resumed << " entradas já concluídas numa execução anterior\n";
+        }
+        if (report.progress.failed > 0) {
+            std::cout << "   Execute de novo para tentar as falhas (checkpoint em " << options.checkpoint_path << ")\n";
+        }
+        return report.progress.failed == 0 ? 0 : 1;
+    }
+
     // Verificar se a estrutura de pastas existe
     std::vector<std::string> required_folders = {
         "www/inicio", "www/AllMov", "www/profile",
@@ -1368,6 +3007,62 @@ int main() {
 
 
 
+    if (adminToken().empty()) {
+        LOG_WARN("⚠️ CINEIA_ADMIN_TOKEN não definido: rotas /api/admin desativadas");
+    }
+
+    // Modelo ALS salvo (se houver) fica disponível antes do primeiro treino
+    if (const char* als_path = std::getenv("CINEIA_ALS_MODEL")) {
+        std::shared_ptr<const ALSModel> als = ALSModel::load(als_path);
+        if (als) std::atomic_store(&global_als, als);
+    }
+
+    // Recomendações pré-calculadas: cada avaliação marca o usuário para recálculo
+    long reco_refresh_ms = 2000;
+    if (const char* refresh = std::getenv("CINEIA_RECO_REFRESH_MS")) {
+        reco_refresh_ms = std::max(100L, std::atol(refresh));
+    }
+    RecoStore reco_store(computeStoredRecommendations, std::chrono::milliseconds(reco_refresh_ms));
+    global_reco_store = &reco_store;
+    seedRecoStoreFromBatch();
+    db.addRatingObserver([](int user_id, int movie_id, double, int64_t timestamp) {
+        global_reco_store->markDirty(user_id);
+        global_trending.record(movie_id, timestamp);
+    });
+    reco_store.start();
+
+    // Avaliações da API entram numa fila e são gravadas em lote (group commit)
+    size_t rating_batch = 1024;
+    if (const char* batch = std::getenv("CINEIA_RATING_BATCH")) {
+        rating_batch = static_cast<size_t>(std::max(1L, std::atol(batch)));
+    }
+    long rating_delay_ms = 2;
+    if (const char* delay = std::getenv("CINEIA_RATING_MAX_DELAY_MS")) {
+        rating_delay_ms = std::max(0L, std::atol(delay));
+    }
+    RatingWriter rating_writer(db, []() { return lockDatabase(LOCK_SITE("ratings.group_commit")); },
+                               rating_batch, std::chrono::milliseconds(rating_delay_ms));
+    global_rating_writer = &rating_writer;
+    rating_writer.start();
+
+    // Migrações adiadas (índices grandes, backfills) sem atrasar a subida do
+    // servidor; cada transação ainda segura o db_mutex enquanto roda
+    if (MigrationRunner(db, schemaMigrations()).hasPending()) {
+        std::thread([]() {
+            MigrationRunner(*global_db, schemaMigrations()).runPending([]() {
+                return lockDatabase(LOCK_SITE("db.migrations"));
+            });
+        }).detach();
+    }
+
+    // Indexar o catálogo e treinar os recomendadores locais em segundo plano
+    std::thread([]() {
+        startTrending();
+        rebuildContentIndex();
+        loadOrBuildMovieAnn();
+        rebuildRecommenders();
+    }).detach();
+
     // Iniciar servidor web em thread separada
     int web_port = 8081;
     std::thread web_thread([web_port]() {
@@ -0,0 +1,60 @@
+#include "metrics.h"
+
+LatencyHistogram::LatencyHistogram()
+    : total_count(0), sum_micros(0), max_micros(0) {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketFor(uint64_t micros) {
+    int bucket = 0;
+    while (micros > 0 && bucket < kBuckets - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    sum_micros.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t current = max_micros.load(std::memory_order_relaxed);
+    while (micros > current &&
+           !max_micros.compare_exchange_weak(current, micros, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total_count.store(0, std::memory_order_relaxed);
+    sum_micros.store(0, std::memory_order_relaxed);
+    max_micros.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::averageMicros() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sumMicros()) / n;
+}
+
+uint64_t LatencyHistogram::percentileMicros(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(p * n);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t upper = i == 0 ? 0 : (1ULL << i) - 1;
+            return upper < maxMicros() ? upper : maxMicros();
+        }
+    }
+    return maxMicros();
+}
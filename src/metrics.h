@@ -0,0 +1,36 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Histograma de latência sem lock: buckets exponenciais de base 2 em
+// microssegundos (bucket i cobre [2^(i-1), 2^i) µs). Gravar custa alguns
+// incrementos atômicos relaxados, então pode ser usado em caminhos quentes.
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 40;
+
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+    void reset();
+
+    uint64_t count() const { return total_count.load(std::memory_order_relaxed); }
+    uint64_t sumMicros() const { return sum_micros.load(std::memory_order_relaxed); }
+    uint64_t maxMicros() const { return max_micros.load(std::memory_order_relaxed); }
+    double averageMicros() const;
+
+    // Limite superior do bucket que contém o percentil p (0 < p <= 1)
+    uint64_t percentileMicros(double p) const;
+
+private:
+    std::atomic<uint64_t> buckets[kBuckets];
+    std::atomic<uint64_t> total_count;
+    std::atomic<uint64_t> sum_micros;
+    std::atomic<uint64_t> max_micros;
+
+    static int bucketFor(uint64_t micros);
+};
+
+#endif
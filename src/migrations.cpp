@@ -0,0 +1,198 @@
+#include "migrations.h"
+#include "logger.h"
+#include "tracing.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+    double millisSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Executa fn com o lock do banco, se houver (na inicialização não há)
+    bool withLock(const DatabaseLockFn* lock_db, const std::function<bool()>& fn) {
+        if (!lock_db) return fn();
+        auto lock = (*lock_db)();
+        return fn();
+    }
+
+    // ===== MIGRAÇÕES =====
+    // Nunca edite uma migração já publicada: acrescente uma nova versão.
+    // As da inicialização vêm antes das adiadas (runBlocking para na primeira adiada).
+
+    // 1: imdb_id único. Bancos antigos podem ter o mesmo imdb_id repetido: as
+    // cópias são fundidas no menor id, levando as avaliações, antes do índice.
+    const char* kUniqueImdbId = R"(
+        UPDATE movies SET imdb_id = '' WHERE imdb_id = 'N/A';
+        CREATE TEMP TABLE movie_merge AS
+            SELECT m.id AS old_id, k.keep_id AS new_id
+            FROM movies m
+            JOIN (SELECT imdb_id, MIN(id) AS keep_id FROM movies
+                  WHERE imdb_id <> '' GROUP BY imdb_id HAVING COUNT(*) > 1) k
+              ON m.imdb_id = k.imdb_id
+            WHERE m.id <> k.keep_id;
+        UPDATE OR IGNORE ratings
+            SET movie_id = (SELECT new_id FROM movie_merge WHERE old_id = ratings.movie_id)
+            WHERE movie_id IN (SELECT old_id FROM movie_merge);
+        DELETE FROM ratings WHERE movie_id IN (SELECT old_id FROM movie_merge);
+        DELETE FROM user_recommendations WHERE movie_id IN (SELECT old_id FROM movie_merge);
+        DELETE FROM similar_movies WHERE movie_id IN (SELECT old_id FROM movie_merge)
+                                      OR similar_id IN (SELECT old_id FROM movie_merge);
+        DELETE FROM movies WHERE id IN (SELECT old_id FROM movie_merge);
+        DROP TABLE movie_merge;
+        CREATE UNIQUE INDEX IF NOT EXISTS idx_movies_imdb_id ON movies(imdb_id) WHERE imdb_id <> '';
+    )";
+
+    // 2: feed de alterações do catálogo. Cada filme guarda só a última
+    // alteração (apaga a anterior e insere com um seq novo, sempre crescente
+    // por causa do AUTOINCREMENT); exclusões ficam como marcas com deleted = 1.
+    // Nada de INSERT OR REPLACE no trigger: o conflito do comando externo
+    // prevalece, e o DO UPDATE do upsert de createMovie o transformaria em
+    // ABORT. O backfill põe o catálogo atual no feed, então since=0 devolve
+    // tudo. Roda na inicialização, antes dos índices adiados: /api/movies e as
+    // ferramentas de linha de comando (que só rodam runBlocking) contam com ele.
+    const char* kMovieChanges = R"(
+        CREATE TABLE IF NOT EXISTS movie_changes (
+            seq INTEGER PRIMARY KEY AUTOINCREMENT,
+            movie_id INTEGER NOT NULL UNIQUE,
+            deleted INTEGER NOT NULL DEFAULT 0,
+            changed_at INTEGER NOT NULL
+        );
+        INSERT OR IGNORE INTO movie_changes (movie_id, deleted, changed_at)
+            SELECT id, 0, CAST(strftime('%s', 'now') AS INTEGER) FROM movies ORDER BY id;
+        CREATE TRIGGER IF NOT EXISTS movies_change_insert AFTER INSERT ON movies BEGIN
+            DELETE FROM movie_changes WHERE movie_id = NEW.id;
+            INSERT INTO movie_changes (movie_id, deleted, changed_at)
+                VALUES (NEW.id, 0, CAST(strftime('%s', 'now') AS INTEGER));
+        END;
+        CREATE TRIGGER IF NOT EXISTS movies_change_update AFTER UPDATE ON movies BEGIN
+            DELETE FROM movie_changes WHERE movie_id = NEW.id;
+            INSERT INTO movie_changes (movie_id, deleted, changed_at)
+                VALUES (NEW.id, 0, CAST(strftime('%s', 'now') AS INTEGER));
+        END;
+        CREATE TRIGGER IF NOT EXISTS movies_change_delete AFTER DELETE ON movies BEGIN
+            DELETE FROM movie_changes WHERE movie_id = OLD.id;
+            INSERT INTO movie_changes (movie_id, deleted, changed_at)
+                VALUES (OLD.id, 1, CAST(strftime('%s', 'now') AS INTEGER));
+        END;
+    )";
+
+    // 3: índices no formato das consultas. (movie_id, rating) responde a média
+    // do filme sem tocar na tabela; (user_id, timestamp DESC) entrega as
+    // avaliações recentes já ordenadas. Nos filmes, ORDER BY imdb_rating DESC
+    // LIMIT (com ou sem gênero) para no LIMIT em vez de ordenar o catálogo
+    // inteiro. Substituem idx_user_ratings e idx_genre, que eram prefixos.
+    const char* kQueryShapeIndexes = R"(
+        CREATE INDEX IF NOT EXISTS idx_ratings_movie_rating ON ratings(movie_id, rating);
+        CREATE INDEX IF NOT EXISTS idx_ratings_user_time ON ratings(user_id, timestamp DESC);
+        CREATE INDEX IF NOT EXISTS idx_movies_rating ON movies(imdb_rating DESC, id);
+        CREATE INDEX IF NOT EXISTS idx_movies_genre_rating ON movies(genre, imdb_rating DESC, id);
+        DROP INDEX IF EXISTS idx_user_ratings;
+        DROP INDEX IF EXISTS idx_genre;
+    )";
+}
+
+const std::vector<Migration>& schemaMigrations() {
+    static const std::vector<Migration> migrations = {
+        {1, "movies_imdb_id_unique", kUniqueImdbId, false},
+        {2, "movie_changes_feed", kMovieChanges, false},
+        {3, "query_shape_indexes", kQueryShapeIndexes, true},
+    };
+    return migrations;
+}
+
+MigrationRunner::MigrationRunner(Database& database, const std::vector<Migration>& list)
+    : db(database), migrations(list) {}
+
+int MigrationRunner::currentVersion() {
+    return static_cast<int>(db.queryInt("PRAGMA user_version", 0));
+}
+
+int MigrationRunner::latestVersion() const {
+    return migrations.empty() ? 0 : migrations.back().version;
+}
+
+bool MigrationRunner::hasPending() {
+    return currentVersion() < latestVersion();
+}
+
+bool MigrationRunner::runBlocking() {
+    int version = currentVersion();
+    for (const auto& migration : migrations) {
+        if (migration.version <= version) continue;
+        if (migration.deferred) {
+            LOG_INFO("🧱 Esquema na versão %d; migrações a partir da %d (%s) rodam em segundo plano",
+                     version, migration.version, migration.name);
+            return true;
+        }
+        if (!apply(migration, nullptr)) return false;
+        version = migration.version;
+    }
+    return true;
+}
+
+bool MigrationRunner::runPending(const DatabaseLockFn& lock_db) {
+    int version = 0;
+    withLock(&lock_db, [&]() {
+        version = currentVersion();
+        return true;
+    });
+    for (const auto& migration : migrations) {
+        if (migration.version <= version) continue;
+        if (!apply(migration, &lock_db)) return false;
+        version = migration.version;
+    }
+    return true;
+}
+
+bool MigrationRunner::apply(const Migration& migration, const DatabaseLockFn* lock_db) {
+    TRACE_SPAN("db.migration", migration.name);
+    auto started = std::chrono::steady_clock::now();
+
+    // sql, registro e user_version no mesmo COMMIT
+    bool ok = withLock(lock_db, [&]() {
+        if (!db.execute("BEGIN")) return false;
+        char record[512];
+        std::snprintf(record, sizeof(record),
+                      "INSERT OR REPLACE INTO schema_migrations (version, name, started_at, applied_at, duration_ms) "
+                      "VALUES (%d, '%s', %lld, NULL, 0)",
+                      migration.version, migration.name, static_cast<long long>(std::time(nullptr)));
+        bool body = (!migration.sql || db.execute(migration.sql)) && db.execute(record);
+        if (body) {
+            char finish[256];
+            std::snprintf(finish, sizeof(finish),
+                          "PRAGMA user_version = %d; "
+                          "UPDATE schema_migrations SET applied_at = %lld, duration_ms = %.3f WHERE version = %d",
+                          migration.version, static_cast<long long>(std::time(nullptr)), millisSince(started),
+                          migration.version);
+            body = db.execute(finish);
+        }
+        if (body && db.execute("COMMIT")) return true;
+        db.execute("ROLLBACK");
+        return false;
+    });
+    if (!ok) {
+        LOG_ERROR("❌ Migração %d (%s) falhou; esquema continua na versão anterior",
+                  migration.version, migration.name);
+        return false;
+    }
+
+    LOG_INFO("🧱 Migração %d (%s) aplicada em %.1f ms", migration.version, migration.name, millisSince(started));
+    return true;
+}
+
+std::vector<MigrationRecord> MigrationRunner::history() {
+    std::vector<MigrationRecord> records;
+    db.query("SELECT version, name, COALESCE(applied_at, 0), duration_ms FROM schema_migrations ORDER BY version",
+             [&](sqlite3_stmt* stmt) {
+                 MigrationRecord record;
+                 record.version = sqlite3_column_int(stmt, 0);
+                 const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+                 record.name = name ? name : "";
+                 record.applied_at = sqlite3_column_int64(stmt, 2);
+                 record.duration_ms = sqlite3_column_double(stmt, 3);
+                 records.push_back(record);
+             });
+    return records;
+}
@@ -0,0 +1,55 @@
+#ifndef MIGRATIONS_H
+#define MIGRATIONS_H
+
+#include "database.h"
+#include "lock_profiler.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct Migration {
+    int version;
+    const char* name;
+    const char* sql;          // executado numa transação; nullptr se não houver
+    bool deferred;            // fica para depois que o servidor sobe (não deixa de bloquear)
+};
+
+struct MigrationRecord {
+    int version = 0;
+    std::string name;
+    int64_t applied_at = 0;   // unix epoch
+    double duration_ms = 0.0;
+};
+
+// Migrações versionadas por PRAGMA user_version, aplicadas em ordem, cada uma
+// numa única transação (o user_version muda no mesmo COMMIT). runBlocking roda
+// na inicialização até a primeira migração adiada; o resto fica para
+// runPending, que o servidor chama em segundo plano. Adiar só tira a migração
+// do caminho da subida: ela segura o lock do banco durante a transação inteira
+// e, enquanto isso, toda requisição que usa o banco espera (um CREATE INDEX
+// numa tabela grande trava o servidor pelo tempo da construção).
+class MigrationRunner {
+public:
+    MigrationRunner(Database& db, const std::vector<Migration>& migrations);
+
+    int currentVersion();
+    int latestVersion() const;
+    bool hasPending();
+
+    bool runBlocking();
+    bool runPending(const DatabaseLockFn& lock_db);
+
+    std::vector<MigrationRecord> history();
+
+private:
+    Database& db;
+    const std::vector<Migration>& migrations;
+
+    bool apply(const Migration& migration, const DatabaseLockFn* lock_db);
+};
+
+// Lista de migrações do esquema, em ordem de versão
+const std::vector<Migration>& schemaMigrations();
+
+#endif
@@ -1,6 +1,11 @@
 #include "movie_api.h"
+#include "logger.h"
+#include "tracing.h"
+#include "http_metrics.h"
 #include <curl/curl.h>
-#include <iostream>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
 #include <sstream>
 #include <algorithm>
 #include <regex>
@@ -15,13 +20,21 @@ namespace {
         ~CurlGlobal() { curl_global_cleanup(); }
     };
     static CurlGlobal curl_global;
+
+    long timeoutFromEnv(const char* name, long fallback) {
+        const char* value = std::getenv(name);
+        long seconds = value ? std::atol(value) : 0;
+        return seconds > 0 ? seconds : fallback;
+    }
 }
 
 MovieAPI::MovieAPI(const std::string& omdb_key, const std::string& openrouter_key)
     : omdb_api_key(omdb_key),
       openrouter_api_key(openrouter_key),
-      base_omdb_url("http://www.omdbapi.com/"),
+      base_omdb_url(std::getenv("CINEIA_OMDB_URL") ? std::getenv("CINEIA_OMDB_URL") : "http://www.omdbapi.com/"),
       base_openrouter_url("https://openrouter.ai/api/v1/chat/completions"),
+      get_timeout_seconds(timeoutFromEnv("CINEIA_HTTP_TIMEOUT", 15L)),
+      post_timeout_seconds(timeoutFromEnv("CINEIA_LLM_TIMEOUT", 30L)),
       rng(std::random_device{}()) {}
 
 size_t MovieAPI::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp) {
@@ -30,7 +43,14 @@ size_t MovieAPI::WriteCallback(void* contents, size_t size, size_t nmemb, std::s
     return totalSize;
 }
 
+const char* MovieAPI::upstreamName(const std::string& url) const {
+    if (url.compare(0, base_omdb_url.size(), base_omdb_url) == 0) return "omdb";
+    if (url.compare(0, base_openrouter_url.size(), base_openrouter_url) == 0) return "openrouter";
+    return "other";
+}
+
 std::string MovieAPI::makeRequest(const std::string& url, const std::vector<std::string>& headers) {
+    TRACE_SPAN("http.get", upstreamName(url));
     CURL* curl;
     CURLcode res;
     std::string response;
@@ -41,7 +61,7 @@ std::string MovieAPI::makeRequest(const std::string& url, const std::vector<std:
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         curl_easy_setopt(curl, CURLOPT_USERAGENT, "MiniNetflix/2.0");
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, get_timeout_seconds);
         curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 
         struct curl_slist* header_list = nullptr;
@@ -53,9 +73,10 @@ std::string MovieAPI::makeRequest(const std::string& url, const std::vector<std:
         }
 
         res = curl_easy_perform(curl);
+        HttpMetrics::instance().recordTransfer(upstreamName(url), curl, res);
 
         if(res != CURLE_OK) {
-            std::cerr << "❌ Erro na requisição: " << curl_easy_strerror(res) << std::endl;
+            LOG_WARN("❌ Erro na requisição: %s", curl_easy_strerror(res));
         }
 
         if (header_list) {
@@ -68,6 +89,7 @@ std::string MovieAPI::makeRequest(const std::string& url, const std::vector<std:
 }
 
 std::string MovieAPI::makePostRequest(const std::string& url, const std::string& postData, const std::vector<std::string>& headers) {
+    TRACE_SPAN("http.post", upstreamName(url));
     CURL* curl;
     CURLcode res;
     std::string response;
@@ -79,7 +101,7 @@ std::string MovieAPI::makePostRequest(const std::string& url, const std::string&
         curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
         curl_easy_setopt(curl, CURLOPT_USERAGENT, "MiniNetflix/2.0");
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, post_timeout_seconds);
 
         struct curl_slist* header_list = nullptr;
         header_list = curl_slist_append(header_list, "Content-Type: application/json");
@@ -89,9 +111,10 @@ std::string MovieAPI::makePostRequest(const std::string& url, const std::string&
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
 
         res = curl_easy_perform(curl);
+        HttpMetrics::instance().recordTransfer(upstreamName(url), curl, res);
 
         if(res != CURLE_OK) {
-            std::cerr << "❌ Erro na requisição POST: " << curl_easy_strerror(res) << std::endl;
+            LOG_WARN("❌ Erro na requisição POST: %s", curl_easy_strerror(res));
         }
 
         curl_slist_free_all(header_list);
@@ -168,11 +191,12 @@ double MovieAPI::extractRating(const std::string& json, const std::string& sourc
 }
 
 Movie MovieAPI::searchMovie(const std::string& title) {
+    TRACE_SPAN("omdb.searchMovie");
     Movie movie;
     movie.id = 0;
 
     if (!hasOMDBKey()) {
-        std::cout << "❌ Chave da API OMDB não configurada!\n";
+        LOG_WARN("❌ Chave da API OMDB não configurada!");
         return createMockMovie(title);
     }
 
@@ -181,17 +205,59 @@ Movie MovieAPI::searchMovie(const std::string& title) {
     std::string response = makeRequest(url);
 
     if (response.empty() || response.find("\"Response\":\"False\"") != std::string::npos) {
-        std::cout << "❌ Filme não encontrado: " << title << std::endl;
+        LOG_INFO("❌ Filme não encontrado: %s", title.c_str());
         return createMockMovie(title);
     }
 
+    movie = parseOmdbMovie(response, title);
+    LOG_INFO("✅ Filme encontrado: %s (%d)", movie.title.c_str(), movie.year);
+    return movie;
+}
+
+bool MovieAPI::fetchMovie(const std::string& title_or_imdb_id, Movie& movie, std::string& error) {
+    TRACE_SPAN("omdb.fetchMovie");
+    if (!hasOMDBKey()) {
+        error = "OMDB_API_KEY não configurada";
+        return false;
+    }
+
+    bool by_id = title_or_imdb_id.size() > 2 && title_or_imdb_id.compare(0, 2, "tt") == 0 &&
+                 std::all_of(title_or_imdb_id.begin() + 2, title_or_imdb_id.end(), ::isdigit);
+    std::string url = base_omdb_url + "?apikey=" + omdb_api_key + (by_id ? "&i=" : "&t=") +
+                      urlEncode(title_or_imdb_id) + "&plot=full";
+    std::string response = makeRequest(url);
+
+    if (response.empty()) {
+        error = "falha na requisição";
+        return false;
+    }
+    if (response.find("\"Response\":\"False\"") != std::string::npos) {
+        std::string message = extractJsonValue(response, "Error");
+        bool missing = message.find("not found") != std::string::npos ||
+                       message.find("Incorrect IMDb ID") != std::string::npos;
+        error = missing ? "not_found" : message;
+        return false;
+    }
+
+    movie = parseOmdbMovie(response, title_or_imdb_id);
+    if (movie.imdb_id.empty() || movie.imdb_id == "N/A") {
+        error = "resposta sem imdbID";
+        return false;
+    }
+    return true;
+}
+
+Movie MovieAPI::parseOmdbMovie(const std::string& response, const std::string& fallback_title) {
+    Movie movie;
+    movie.id = 0;
+
     movie.title = extractJsonValue(response, "Title");
-    if (movie.title == "N/A") movie.title = title;
+    if (movie.title == "N/A") movie.title = fallback_title;
 
     movie.imdb_id = extractJsonValue(response, "imdbID");
 
     std::string year_str = extractJsonValue(response, "Year");
-    if (year_str != "N/A" && !year_str.empty()) {
+    if (year_str != "N/A" && !year_str.empty() && std::isdigit(static_cast<unsigned char>(year_str[0]))) {
         movie.year = std::stoi(year_str.substr(0, 4));
     } else {
         movie.year = 0;
@@ -204,14 +270,12 @@ Movie MovieAPI::searchMovie(const std::string& title) {
 
     std::string imdbRating = extractJsonValue(response, "imdbRating");
     if (imdbRating != "N/A") {
-        movie.imdb_rating = std::stod(imdbRating);
+        movie.imdb_rating = std::atof(imdbRating.c_str());
     } else {
         movie.imdb_rating = 0.0;
     }
 
     movie.rotten_tomatoes_rating = extractRating(response, "Rotten Tomatoes");
-
-    std::cout << "✅ Filme encontrado: " << movie.title << " (" << movie.year << ")\n";
     return movie;
 }
 
@@ -255,18 +319,18 @@ std::vector<Recommendation> MovieAPI::parseRecommendationsFromContent(const std:
     std::vector<Recommendation> recommendations;
 
     if (content.empty()) {
-        std::cerr << "❌ Conteúdo vazio para parsear\n";
+        LOG_WARN("❌ Conteúdo vazio para parsear");
         return recommendations;
     }
 
     std::string cleanedContent = cleanJsonContent(content);
 
     if (cleanedContent.empty()) {
-        std::cerr << "❌ Conteúdo vazio após limpeza\n";
+        LOG_WARN("❌ Conteúdo vazio após limpeza");
         return recommendations;
     }
 
-    std::cout << "🔧 Tentando parsear JSON limpo: " << cleanedContent.substr(0, 100) << "..." << std::endl;
+    LOG_DEBUG("🔧 Tentando parsear JSON limpo: %.100s...", cleanedContent.c_str());
 
     Json::Value recRoot;
     Json::CharReaderBuilder reader;
@@ -278,7 +342,7 @@ std::vector<Recommendation> MovieAPI::parseRecommendationsFromContent(const std:
     reader["allowTrailingCommas"] = true;
 
     if (!Json::parseFromStream(reader, contentStream, &recRoot, &errors)) {
-        std::cerr << "❌ Erro ao parsear conteúdo JSON: " << errors << std::endl;
+        LOG_WARN("❌ Erro ao parsear conteúdo JSON: %s", errors.c_str());
         return recommendations;
     }
 
@@ -292,13 +356,13 @@ std::vector<Recommendation> MovieAPI::parseRecommendationsFromContent(const std:
                 recommendation.mood = rec["mood"].asString();
                 recommendations.push_back(recommendation);
 
-                std::cout << "✅ Recomendação extraída: " << recommendation.title << std::endl;
+                LOG_DEBUG("✅ Recomendação extraída: %s", recommendation.title.c_str());
             } else {
-                std::cerr << "⚠️ Recomendação com campos faltantes\n";
+                LOG_WARN("⚠️ Recomendação com campos faltantes");
             }
         }
     } else {
-        std::cerr << "❌ Campo 'recommendations' não encontrado\n";
+        LOG_WARN("❌ Campo 'recommendations' não encontrado");
     }
 
     return recommendations;
@@ -439,8 +503,9 @@ std::string MovieAPI::buildRecommendationPrompt(const std::vector<Movie>& userHi
 }
 
 std::vector<Recommendation> MovieAPI::getMovieRecommendations(const std::vector<Movie>& userHistory, const std::string& currentMood) {
+    TRACE_SPAN("llm.getMovieRecommendations");
     if (!hasOpenRouterKey()) {
-        std::cout << "❌ Chave da API OpenRouter não configurada! Usando recomendações locais.\n";
+        LOG_WARN("❌ Chave da API OpenRouter não configurada! Usando recomendações locais.");
         return getFallbackRecommendations();
     }
 
@@ -468,15 +533,15 @@ std::vector<Recommendation> MovieAPI::getMovieRecommendations(const std::vector<
         "X-Title: MiniNetflix"
     };
 
-    std::cout << "🚀 Fazendo requisição para OpenRouter com prompt melhorado..." << std::endl;
+    LOG_INFO("🚀 Fazendo requisição para OpenRouter com prompt melhorado...");
     std::string response = makePostRequest(base_openrouter_url, requestBodyStr, headers);
 
     if (response.empty()) {
-        std::cerr << "❌ Resposta vazia da API OpenRouter\n";
+        LOG_WARN("❌ Resposta vazia da API OpenRouter");
         return getFallbackRecommendations();
     }
 
-    std::cout << "📥 Resposta bruta recebida: " << response.substr(0, 200) << "..." << std::endl;
+    LOG_DEBUG("📥 Resposta bruta recebida: %.200s...", response.c_str());
 
     std::string cleanResponse = cleanJsonContent(response);
     std::stringstream responseStream(cleanResponse);
@@ -489,38 +554,38 @@ std::vector<Recommendation> MovieAPI::getMovieRecommendations(const std::vector<
     reader["allowComments"] = true;
 
     if (!Json::parseFromStream(reader, responseStream, &root, &errors)) {
-        std::cerr << "❌ Erro ao parsear resposta JSON da API: " << errors << std::endl;
+        LOG_WARN("❌ Erro ao parsear resposta JSON da API: %s", errors.c_str());
         return getFallbackRecommendations();
     }
 
     if (!root.isMember("choices") || !root["choices"].isArray() || root["choices"].empty()) {
-        std::cerr << "❌ Estrutura de resposta inválida\n";
+        LOG_WARN("❌ Estrutura de resposta inválida");
         return getFallbackRecommendations();
     }
 
     Json::Value firstChoice = root["choices"][0];
     if (!firstChoice.isMember("message") || !firstChoice["message"].isMember("content")) {
-        std::cerr << "❌ Estrutura de resposta inválida\n";
+        LOG_WARN("❌ Estrutura de resposta inválida");
         return getFallbackRecommendations();
     }
 
     std::string content = firstChoice["message"]["content"].asString();
-    std::cout << "📋 Conteúdo extraído: " << content.substr(0, 100) << "..." << std::endl;
+    LOG_DEBUG("📋 Conteúdo extraído: %.100s...", content.c_str());
 
     std::vector<Recommendation> recommendations = parseRecommendationsFromContent(content);
 
     if (recommendations.empty()) {
-        std::cerr << "❌ Nenhuma recomendação extraída, usando fallback\n";
+        LOG_WARN("❌ Nenhuma recomendação extraída, usando fallback");
         return getFallbackRecommendations();
     }
 
-    std::cout << "✅ " << recommendations.size() << " recomendações diversificadas extraídas com sucesso!\n";
+    LOG_INFO("✅ %zu recomendações diversificadas extraídas com sucesso!", recommendations.size());
     return recommendations;
 }
 
 // FALLBACK MUITO MAIS DIVERSSO
 std::vector<Recommendation> MovieAPI::getFallbackRecommendations() {
-    std::cout << "🔄 Usando recomendações de fallback diversificadas\n";
+    LOG_INFO("🔄 Usando recomendações de fallback diversificadas");
 
     // Lista expandida de fallbacks
     std::vector<Recommendation> fallbacks = {
@@ -554,7 +619,13 @@ Movie MovieAPI::createMockMovie(const std::string& title) {
     Movie movie;
     movie.id = 0;
     movie.title = title;
-    movie.year = 2000 + (std::rand() % 24);
+    // Ano derivado do título (FNV-1a): repetir a busca gera o mesmo filme,
+    // e o detector de duplicados do Database o reconhece
+    uint32_t title_hash = 2166136261u;
+    for (unsigned char c : title) {
+        title_hash = (title_hash ^ static_cast<uint32_t>(std::tolower(c))) * 16777619u;
+    }
+    movie.year = 2000 + static_cast<int>(title_hash % 24);
     movie.imdb_rating = 6.0 + (std::rand() % 40) / 10.0;
     movie.rotten_tomatoes_rating = 50.0 + (std::rand() % 50);
     movie.poster_url = "https://via.placeholder.com/300x450?text=" + title;
@@ -569,7 +640,7 @@ Movie MovieAPI::createMockMovie(const std::string& title) {
     movie.actors = actors[actorDist(rng)] + ", " + actors[(actorDist(rng) + 1) % actors.size()];
     movie.description = "A compelling story about " + title + " that explores deep themes and features memorable characters.";
 
-    std::cout << "⚠️  Usando dados de demonstração para: " << movie.title << "\n";
+    LOG_INFO("⚠️  Usando dados de demonstração para: %s", movie.title.c_str());
     return movie;
 }
 
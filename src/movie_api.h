@@ -19,6 +19,10 @@ private:
     std::string base_omdb_url;
     std::string base_openrouter_url;
 
+    // CURLOPT_TIMEOUT em segundos (CINEIA_HTTP_TIMEOUT e CINEIA_LLM_TIMEOUT)
+    long get_timeout_seconds;
+    long post_timeout_seconds;
+
     // Sistema de aleatoriedade para diversificação
     std::mt19937 rng;
 
@@ -26,11 +30,13 @@ private:
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* userp);
     std::string makeRequest(const std::string& url, const std::vector<std::string>& headers = {});
     std::string makePostRequest(const std::string& url, const std::string& postData, const std::vector<std::string>& headers = {});
+    const char* upstreamName(const std::string& url) const;
 
     // Utilitários
     std::string extractJsonValue(const std::string& json, const std::string& key);
     double extractRating(const std::string& json, const std::string& source);
     Movie createMockMovie(const std::string& title);
+    Movie parseOmdbMovie(const std::string& response, const std::string& fallback_title);
     std::string urlEncode(const std::string& value);
     std::string cleanJsonContent(const std::string& content);
 
@@ -47,6 +53,10 @@ public:
 
     // Funcionalidades principais
     Movie searchMovie(const std::string& title);
+    // Consulta o OMDB por título ou IMDb id ("tt0111161") sem cair nos dados de
+    // demonstração. false com error = "not_found" se o filme não existe; outros
+    // valores de error (rede, limite de requisições) valem uma nova tentativa
+    bool fetchMovie(const std::string& title_or_imdb_id, Movie& movie, std::string& error);
     std::vector<Recommendation> getMovieRecommendations(const std::vector<Movie>& userHistory, const std::string& currentMood = "");
     std::vector<Recommendation> getPersonalizedRecommendations(const std::vector<std::string>& favoriteGenres, const std::string& mood = "");
     std::vector<Recommendation> parseRecommendationsFromContent(const std::string& content);
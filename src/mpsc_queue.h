@@ -0,0 +1,65 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Fila sem lock com vários produtores e um único consumidor (algoritmo
+// intrusivo de Vyukov). push() é um exchange atômico no topo mais um store,
+// sem laço de CAS: nenhum produtor espera pelo outro. pop() só pode ser
+// chamado pela thread consumidora; pode devolver false por um instante
+// enquanto um produtor está entre o exchange e o store do próximo nó.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(&stub), tail(&stub) {
+        stub.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue() {
+        T discarded;
+        while (pop(discarded)) {
+        }
+        if (tail != &stub) delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T& out) {
+        Node* current = tail;
+        Node* next = current->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        // O nó seguinte vira o novo "stub"; o valor sai dele
+        out = std::move(next->value);
+        tail = next;
+        if (current != &stub) delete current;
+        return true;
+    }
+
+    // Aproximado: só o consumidor enxerga um valor confiável
+    bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node*> head;  // produtores
+    Node* tail;               // consumidor
+    Node stub;
+};
+
+#endif
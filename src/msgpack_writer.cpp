@@ -0,0 +1,147 @@
+#include "msgpack_writer.h"
+
+void MsgpackWriter::putBigEndian(uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        put(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void MsgpackWriter::mapHeader(uint32_t size) {
+    if (size < 16) {
+        put(static_cast<uint8_t>(0x80 | size));
+    } else if (size <= 0xffff) {
+        put(0xde);
+        putBigEndian(size, 2);
+    } else {
+        put(0xdf);
+        putBigEndian(size, 4);
+    }
+}
+
+void MsgpackWriter::arrayHeader(uint32_t size) {
+    if (size < 16) {
+        put(static_cast<uint8_t>(0x90 | size));
+    } else if (size <= 0xffff) {
+        put(0xdc);
+        putBigEndian(size, 2);
+    } else {
+        put(0xdd);
+        putBigEndian(size, 4);
+    }
+}
+
+void MsgpackWriter::nil() {
+    put(0xc0);
+}
+
+void MsgpackWriter::boolean(bool value) {
+    put(value ? 0xc3 : 0xc2);
+}
+
+void MsgpackWriter::integer(int64_t value) {
+    if (value >= 0) {
+        uint64_t u = static_cast<uint64_t>(value);
+        if (u < 128) {
+            put(static_cast<uint8_t>(u));
+        } else if (u <= 0xff) {
+            put(0xcc);
+            put(static_cast<uint8_t>(u));
+        } else if (u <= 0xffff) {
+            put(0xcd);
+            putBigEndian(u, 2);
+        } else if (u <= 0xffffffffULL) {
+            put(0xce);
+            putBigEndian(u, 4);
+        } else {
+            put(0xcf);
+            putBigEndian(u, 8);
+        }
+    } else if (value >= -32) {
+        put(static_cast<uint8_t>(value));   // negative fixint (111xxxxx)
+    } else if (value >= INT8_MIN) {
+        put(0xd0);
+        put(static_cast<uint8_t>(value));
+    } else if (value >= INT16_MIN) {
+        put(0xd1);
+        putBigEndian(static_cast<uint64_t>(value), 2);
+    } else if (value >= INT32_MIN) {
+        put(0xd2);
+        putBigEndian(static_cast<uint64_t>(value), 4);
+    } else {
+        put(0xd3);
+        putBigEndian(static_cast<uint64_t>(value), 8);
+    }
+}
+
+void MsgpackWriter::number(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put(0xcb);
+    putBigEndian(bits, 8);
+}
+
+void MsgpackWriter::string(const char* data, size_t length) {
+    if (length < 32) {
+        put(static_cast<uint8_t>(0xa0 | length));
+    } else if (length <= 0xff) {
+        put(0xd9);
+        put(static_cast<uint8_t>(length));
+    } else if (length <= 0xffff) {
+        put(0xda);
+        putBigEndian(length, 2);
+    } else {
+        put(0xdb);
+        putBigEndian(length, 4);
+    }
+    buffer.append(data, length);
+}
+
+void writeMovie(MsgpackWriter& out, const Movie& movie) {
+    out.mapHeader(9);
+    out.key("id");
+    out.integer(movie.id);
+    out.key("title");
+    out.string(movie.title);
+    out.key("genre");
+    out.string(movie.genre);
+    out.key("year");
+    out.integer(movie.year);
+    out.key("actors");
+    out.string(movie.actors);
+    out.key("description");
+    out.string(movie.description);
+    out.key("poster_url");
+    out.string(movie.poster_url);
+    out.key("imdb_rating");
+    out.number(movie.imdb_rating);
+    out.key("rotten_tomatoes_rating");
+    out.number(movie.rotten_tomatoes_rating);
+}
+
+void writeUserRating(MsgpackWriter& out, const Rating& rating, const Movie& movie) {
+    out.mapHeader(12);
+    out.key("rating_id");
+    out.integer(rating.id);
+    out.key("movie_id");
+    out.integer(movie.id);
+    out.key("title");
+    out.string(movie.title);
+    out.key("year");
+    out.integer(movie.year);
+    out.key("genre");
+    out.string(movie.genre);
+    out.key("poster_url");
+    out.string(movie.poster_url);
+    out.key("imdb_rating");
+    out.number(movie.imdb_rating);
+    out.key("rotten_tomatoes_rating");
+    out.number(movie.rotten_tomatoes_rating);
+    out.key("user_rating");
+    out.number(rating.rating);
+    out.key("rating_date");
+    out.string(rating.timestamp);
+    out.key("actors");
+    out.string(movie.actors);
+    out.key("description");
+    out.string(movie.description);
+}
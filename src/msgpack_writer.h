@@ -0,0 +1,43 @@
+#ifndef MSGPACK_WRITER_H
+#define MSGPACK_WRITER_H
+
+#include "database.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+// Codificador MessagePack direto num buffer, sem montar um DOM como o
+// crow::json::wvalue: quem chama escreve o cabeçalho do mapa/lista com a
+// quantidade de itens e em seguida os itens. Inteiros e strings usam a menor
+// forma que cabe; números reais vão sempre como float64.
+class MsgpackWriter {
+public:
+    void reserve(size_t bytes) { buffer.reserve(bytes); }
+
+    void mapHeader(uint32_t size);
+    void arrayHeader(uint32_t size);
+    void nil();
+    void boolean(bool value);
+    void integer(int64_t value);
+    void number(double value);
+    void string(const char* data, size_t length);
+    void string(const std::string& value) { string(value.data(), value.size()); }
+    void key(const char* name) { string(name, std::strlen(name)); }
+
+    const std::string& data() const { return buffer; }
+    std::string release() { return std::move(buffer); }
+
+private:
+    std::string buffer;
+
+    void put(uint8_t byte) { buffer.push_back(static_cast<char>(byte)); }
+    void putBigEndian(uint64_t value, int bytes);
+};
+
+// Mesmos campos do JSON de /api/movies e de /api/user/<id>/ratings
+void writeMovie(MsgpackWriter& out, const Movie& movie);
+void writeUserRating(MsgpackWriter& out, const Rating& rating, const Movie& movie);
+
+#endif
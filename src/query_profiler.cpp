@@ -0,0 +1,167 @@
+#include "query_profiler.h"
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+    // O tempo do SQLITE_TRACE_PROFILE tem resolução de milissegundos em
+    // algumas plataformas; medimos com steady_clock a partir do SQLITE_TRACE_STMT.
+    struct StatementInFlight {
+        std::chrono::steady_clock::time_point start;
+        uint64_t rows = 0;
+    };
+
+    // Instruções em execução na thread atual
+    thread_local std::unordered_map<sqlite3_stmt*, StatementInFlight> statements_in_flight;
+
+    // Evita que o próprio EXPLAIN (executado dentro do callback) seja perfilado
+    thread_local bool explaining = false;
+}
+
+QueryProfiler::QueryProfiler() : db(nullptr), slow_threshold_ns(50ULL * 1000000ULL) {
+    if (const char* threshold = std::getenv("CINEIA_SLOW_QUERY_MS")) {
+        setSlowThresholdMs(std::atof(threshold));
+    }
+}
+
+void QueryProfiler::attach(sqlite3* connection) {
+    db = connection;
+    sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW,
+                     &QueryProfiler::traceCallback, this);
+}
+
+void QueryProfiler::setSlowThresholdMs(double ms) {
+    slow_threshold_ns = ms <= 0 ? 0 : static_cast<uint64_t>(ms * 1000000.0);
+}
+
+double QueryProfiler::slowThresholdMs() const {
+    return slow_threshold_ns / 1000000.0;
+}
+
+int QueryProfiler::traceCallback(unsigned type, void* context, void* p, void* x) {
+    if (explaining) return 0;
+
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+    if (type == SQLITE_TRACE_STMT) {
+        auto inserted = statements_in_flight.emplace(stmt, StatementInFlight());
+        if (inserted.second) {
+            inserted.first->second.start = std::chrono::steady_clock::now();
+        }
+    } else if (type == SQLITE_TRACE_ROW) {
+        statements_in_flight[stmt].rows++;
+    } else if (type == SQLITE_TRACE_PROFILE) {
+        uint64_t elapsed_ns = static_cast<uint64_t>(*static_cast<sqlite3_int64*>(x));
+        uint64_t rows = 0;
+        auto in_flight = statements_in_flight.find(stmt);
+        if (in_flight != statements_in_flight.end()) {
+            if (in_flight->second.start != std::chrono::steady_clock::time_point()) {
+                elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - in_flight->second.start).count();
+            }
+            rows = in_flight->second.rows;
+            statements_in_flight.erase(in_flight);
+        }
+        static_cast<QueryProfiler*>(context)->onProfile(stmt, elapsed_ns, rows);
+    }
+    return 0;
+}
+
+void QueryProfiler::onProfile(sqlite3_stmt* stmt, uint64_t elapsed_ns, uint64_t rows) {
+    const char* sql = sqlite3_sql(stmt);
+    if (!sql) return;
+
+    bool slow = slow_threshold_ns > 0 && elapsed_ns >= slow_threshold_ns;
+    bool needs_plan = false;
+    std::string normalized;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        QueryStats& entry = stats[sql];
+        if (entry.calls == 0) {
+            entry.sql = normalize(sql);
+        }
+        entry.calls++;
+        entry.rows += rows;
+        entry.total_ns += elapsed_ns;
+        entry.max_ns = std::max(entry.max_ns, elapsed_ns);
+        if (slow) {
+            entry.slow_calls++;
+            needs_plan = entry.plan.empty();
+            normalized = entry.sql;
+        }
+    }
+
+    if (!slow) return;
+
+    std::string plan;
+    if (needs_plan) {
+        plan = explain(sql);
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats[sql].plan = plan;
+    } else {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        plan = stats[sql].plan;
+    }
+
+    LOG_WARN("🐢 Consulta lenta (%.2f ms, %llu linhas): %s | plano: %s",
+             elapsed_ns / 1000000.0, static_cast<unsigned long long>(rows),
+             normalized.c_str(), plan.c_str());
+}
+
+std::string QueryProfiler::explain(const char* sql) {
+    std::string plan;
+    explaining = true;
+
+    sqlite3_stmt* stmt = nullptr;
+    std::string query = std::string("EXPLAIN QUERY PLAN ") + sql;
+    if (sqlite3_prepare_v2(db, query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* detail = sqlite3_column_text(stmt, 3);
+            if (!detail) continue;
+            if (!plan.empty()) plan += "; ";
+            plan += reinterpret_cast<const char*>(detail);
+        }
+    }
+    sqlite3_finalize(stmt);
+
+    explaining = false;
+    return plan.empty() ? "(sem plano)" : plan;
+}
+
+std::vector<QueryStats> QueryProfiler::snapshot() const {
+    std::vector<QueryStats> result;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        result.reserve(stats.size());
+        for (const auto& entry : stats) {
+            result.push_back(entry.second);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const QueryStats& a, const QueryStats& b) {
+        return a.total_ns > b.total_ns;
+    });
+    return result;
+}
+
+void QueryProfiler::reset() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.clear();
+}
+
+std::string QueryProfiler::normalize(const char* sql) {
+    std::string result;
+    bool pending_space = false;
+    for (const char* p = sql; *p; ++p) {
+        if (std::isspace(static_cast<unsigned char>(*p))) {
+            pending_space = !result.empty();
+            continue;
+        }
+        if (pending_space) {
+            result += ' ';
+            pending_space = false;
+        }
+        result += *p;
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+#ifndef QUERY_PROFILER_H
+#define QUERY_PROFILER_H
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct QueryStats {
+    std::string sql;        // texto preparado com espaços colapsados; literais embutidos não viram ?
+    uint64_t calls = 0;
+    uint64_t rows = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t slow_calls = 0;
+    std::string plan;       // EXPLAIN QUERY PLAN, preenchido na primeira execução lenta
+};
+
+// Perfil por instrução SQL usando sqlite3_trace_v2 (SQLITE_TRACE_STMT/PROFILE/ROW).
+// Consultas acima do limite são registradas no log junto com o plano.
+// Limite configurável por CINEIA_SLOW_QUERY_MS (padrão: 50 ms).
+class QueryProfiler {
+public:
+    QueryProfiler();
+
+    void attach(sqlite3* db);
+    void setSlowThresholdMs(double ms);
+    double slowThresholdMs() const;
+
+    // Ordenado por tempo total, do maior para o menor
+    std::vector<QueryStats> snapshot() const;
+    void reset();
+
+private:
+    sqlite3* db;
+    uint64_t slow_threshold_ns;
+
+    mutable std::mutex stats_mutex;
+    std::unordered_map<std::string, QueryStats> stats;
+
+    static int traceCallback(unsigned type, void* context, void* p, void* x);
+    void onProfile(sqlite3_stmt* stmt, uint64_t elapsed_ns, uint64_t rows);
+    std::string explain(const char* sql);
+    static std::string normalize(const char* sql);
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "rating_writer.h"
+#include "logger.h"
+#include "tracing.h"
+#include <algorithm>
+#include <ctime>
+
+namespace {
+    uint64_t microsSince(std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+RatingWriter::RatingWriter(Database& database, DatabaseLockFn lock_fn, size_t batch_limit,
+                           std::chrono::microseconds delay)
+    : db(database), lock_db(std::move(lock_fn)), max_batch(std::max<size_t>(1, batch_limit)),
+      max_delay(delay), running(false), sleeping(false), enqueued(0), committed(0), failed(0),
+      batches(0), largest_batch(0) {}
+
+RatingWriter::~RatingWriter() {
+    stop();
+}
+
+void RatingWriter::start() {
+    if (running.exchange(true)) return;
+    writer = std::thread(&RatingWriter::writerLoop, this);
+}
+
+void RatingWriter::stop() {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void RatingWriter::submit(int user_id, int movie_id, double rating) {
+    RatingEvent event;
+    event.user_id = user_id;
+    event.movie_id = movie_id;
+    event.rating = rating;
+    enqueue(std::move(event));
+}
+
+std::future<bool> RatingWriter::submitDurable(int user_id, int movie_id, double rating) {
+    RatingEvent event;
+    event.user_id = user_id;
+    event.movie_id = movie_id;
+    event.rating = rating;
+    event.ack = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = event.ack->get_future();
+    enqueue(std::move(event));
+    return result;
+}
+
+void RatingWriter::enqueue(RatingEvent event) {
+    event.timestamp = static_cast<int64_t>(std::time(nullptr));
+    event.enqueued_at = std::chrono::steady_clock::now();
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+    queue.push(std::move(event));
+
+    // Par do fence em writerLoop: ou a escritora vê o evento antes de dormir,
+    // ou este produtor vê que ela está dormindo e a acorda
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+}
+
+size_t RatingWriter::drain(std::vector<RatingEvent>& batch) {
+    size_t taken = 0;
+    RatingEvent event;
+    while (batch.size() < max_batch && queue.pop(event)) {
+        batch.push_back(std::move(event));
+        taken++;
+    }
+    return taken;
+}
+
+void RatingWriter::commit(std::vector<RatingEvent>& batch) {
+    TRACE_SPAN("ratings.group_commit");
+    std::vector<RatingInput> rows;
+    rows.reserve(batch.size());
+    for (const RatingEvent& event : batch) {
+        rows.push_back({event.user_id, event.movie_id, event.rating, event.timestamp});
+    }
+
+    // Um lote = uma transação (chunk_size = tamanho do lote)
+    std::vector<RatingRowError> errors;
+    auto start = std::chrono::steady_clock::now();
+    {
+        auto lock = lock_db();
+        db.addRatingsBatch(rows.data(), rows.size(), &errors, rows.size());
+    }
+    commit_latency.record(microsSince(start));
+
+    std::vector<char> saved(batch.size(), 1);
+    for (const RatingRowError& error : errors) {
+        saved[error.index] = 0;
+    }
+
+    size_t ok = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+        RatingEvent& event = batch[i];
+        queue_latency.record(microsSince(event.enqueued_at));
+        if (saved[i]) ok++;
+        if (event.ack) {
+            event.ack->set_value(saved[i] != 0);
+        }
+    }
+
+    committed.fetch_add(ok, std::memory_order_relaxed);
+    failed.fetch_add(batch.size() - ok, std::memory_order_relaxed);
+    batches.fetch_add(1, std::memory_order_relaxed);
+    uint64_t size = batch.size();
+    uint64_t largest = largest_batch.load(std::memory_order_relaxed);
+    while (size > largest && !largest_batch.compare_exchange_weak(largest, size, std::memory_order_relaxed)) {
+    }
+
+    if (!errors.empty()) {
+        LOG_ERROR("❌ Gravação em lote: %zu de %zu avaliações falharam (%s)", errors.size(), batch.size(),
+                  errors.front().error.c_str());
+    }
+}
+
+void RatingWriter::writerLoop() {
+    LOG_INFO("✍️ Gravação de avaliações em lote ativa (até %zu por COMMIT, espera máx. %lld µs)",
+             max_batch, static_cast<long long>(max_delay.count()));
+    std::vector<RatingEvent> batch;
+    batch.reserve(max_batch);
+
+    while (true) {
+        // Lido antes de esvaziar a fila: o que foi enfileirado antes do stop() é gravado
+        bool stopping = !running.load(std::memory_order_acquire);
+        drain(batch);
+
+        if (batch.empty()) {
+            if (stopping) break;
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (queue.empty() && running.load(std::memory_order_acquire)) {
+                wake.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        // Group commit: se o lote não encheu, espera mais avaliações até
+        // max_delay contado a partir da mais antiga. Durante o COMMIT
+        // anterior a fila já acumula, então sob carga quase não há espera.
+        if (!stopping && max_delay.count() > 0) {
+            auto deadline = batch.front().enqueued_at + max_delay;
+            while (batch.size() < max_batch) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= deadline) break;
+                if (drain(batch) == 0) {
+                    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        deadline - now, std::chrono::microseconds(200)));
+                }
+            }
+        }
+
+        commit(batch);
+        batch.clear();
+    }
+}
+
+RatingWriterStats RatingWriter::stats() const {
+    RatingWriterStats result;
+    result.enqueued = enqueued.load(std::memory_order_relaxed);
+    result.committed = committed.load(std::memory_order_relaxed);
+    result.failed = failed.load(std::memory_order_relaxed);
+    result.batches = batches.load(std::memory_order_relaxed);
+    result.largest_batch = largest_batch.load(std::memory_order_relaxed);
+    uint64_t done = result.committed + result.failed;
+    result.pending = result.enqueued > done ? result.enqueued - done : 0;
+    return result;
+}
+
+bool KnownIdCache::contains(int id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ids.count(id) > 0;
+}
+
+void KnownIdCache::insert(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ids.insert(id);
+}
@@ -0,0 +1,100 @@
+#ifndef RATING_WRITER_H
+#define RATING_WRITER_H
+
+#include "database.h"
+#include "lock_profiler.h"
+#include "metrics.h"
+#include "mpsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Avaliação já validada aguardando gravação
+struct RatingEvent {
+    int user_id = 0;
+    int movie_id = 0;
+    double rating = 0.0;
+    int64_t timestamp = 0;  // unix epoch do recebimento, segundos
+    std::chrono::steady_clock::time_point enqueued_at;
+    std::shared_ptr<std::promise<bool>> ack;  // só no modo durável
+};
+
+struct RatingWriterStats {
+    uint64_t enqueued = 0;
+    uint64_t committed = 0;
+    uint64_t failed = 0;
+    uint64_t batches = 0;
+    uint64_t largest_batch = 0;
+    uint64_t pending = 0;  // na fila ou no lote em gravação
+};
+
+// Gravação das avaliações por trás da API (write-behind). Os handlers só
+// enfileiram numa MpscQueue, sem lock; uma única thread escritora junta o que
+// chegou num lote (até max_batch, esperando no máximo max_delay desde o
+// evento mais antigo) e grava tudo numa transação só, um fsync por lote em
+// vez de um por avaliação. Quem precisa saber que a avaliação está no disco
+// usa submitDurable e espera o COMMIT do lote.
+class RatingWriter {
+public:
+    RatingWriter(Database& db, DatabaseLockFn lock_db, size_t max_batch, std::chrono::microseconds max_delay);
+    ~RatingWriter();
+
+    void start();
+    // Grava o que ainda estiver na fila e encerra a thread escritora
+    void stop();
+
+    void submit(int user_id, int movie_id, double rating);
+    // Resolve com true depois do COMMIT do lote que contém a avaliação
+    std::future<bool> submitDurable(int user_id, int movie_id, double rating);
+
+    RatingWriterStats stats() const;
+    LatencyHistogram& commitLatency() { return commit_latency; }
+    LatencyHistogram& queueLatency() { return queue_latency; }
+
+private:
+    Database& db;
+    DatabaseLockFn lock_db;
+    size_t max_batch;
+    std::chrono::microseconds max_delay;
+
+    MpscQueue<RatingEvent> queue;
+    std::atomic<bool> running;
+    std::atomic<bool> sleeping;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::thread writer;
+
+    std::atomic<uint64_t> enqueued;
+    std::atomic<uint64_t> committed;
+    std::atomic<uint64_t> failed;
+    std::atomic<uint64_t> batches;
+    std::atomic<uint64_t> largest_batch;
+    LatencyHistogram commit_latency;  // µs por lote, do BEGIN ao COMMIT
+    LatencyHistogram queue_latency;   // µs por avaliação, da fila ao COMMIT
+
+    void enqueue(RatingEvent event);
+    size_t drain(std::vector<RatingEvent>& batch);
+    void commit(std::vector<RatingEvent>& batch);
+    void writerLoop();
+};
+
+// IDs que já passaram pela checagem de existência. Usuários e filmes não são
+// apagados pela API, então um acerto dispensa a consulta ao banco.
+class KnownIdCache {
+public:
+    bool contains(int id) const;
+    void insert(int id);
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_set<int> ids;
+};
+
+#endif
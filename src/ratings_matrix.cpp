@@ -0,0 +1,93 @@
+#include "ratings_matrix.h"
+#include <algorithm>
+
+RatingsMatrix RatingsMatrix::build(const std::vector<Rating>& ratings) {
+    RatingsMatrix matrix;
+
+    // IDs ordenados deixam os índices densos estáveis entre execuções
+    for (const auto& rating : ratings) {
+        matrix.user_ids.push_back(rating.user_id);
+        matrix.item_ids.push_back(rating.movie_id);
+    }
+    std::sort(matrix.user_ids.begin(), matrix.user_ids.end());
+    matrix.user_ids.erase(std::unique(matrix.user_ids.begin(), matrix.user_ids.end()), matrix.user_ids.end());
+    std::sort(matrix.item_ids.begin(), matrix.item_ids.end());
+    matrix.item_ids.erase(std::unique(matrix.item_ids.begin(), matrix.item_ids.end()), matrix.item_ids.end());
+
+    matrix.user_index.reserve(matrix.user_ids.size());
+    for (size_t i = 0; i < matrix.user_ids.size(); i++) {
+        matrix.user_index[matrix.user_ids[i]] = static_cast<int>(i);
+    }
+    matrix.item_index.reserve(matrix.item_ids.size());
+    for (size_t i = 0; i < matrix.item_ids.size(); i++) {
+        matrix.item_index[matrix.item_ids[i]] = static_cast<int>(i);
+    }
+
+    size_t users = matrix.user_ids.size();
+    size_t items = matrix.item_ids.size();
+    size_t nnz = ratings.size();
+
+    // Contagem por linha/coluna seguida de soma de prefixos (counting sort)
+    matrix.row_offsets.assign(users + 1, 0);
+    matrix.col_offsets.assign(items + 1, 0);
+    std::vector<int> user_of(nnz), item_of(nnz);
+    double total = 0.0;
+    for (size_t k = 0; k < nnz; k++) {
+        user_of[k] = matrix.user_index[ratings[k].user_id];
+        item_of[k] = matrix.item_index[ratings[k].movie_id];
+        matrix.row_offsets[user_of[k] + 1]++;
+        matrix.col_offsets[item_of[k] + 1]++;
+        total += ratings[k].rating;
+    }
+    for (size_t u = 0; u < users; u++) matrix.row_offsets[u + 1] += matrix.row_offsets[u];
+    for (size_t i = 0; i < items; i++) matrix.col_offsets[i + 1] += matrix.col_offsets[i];
+
+    matrix.row_items.resize(nnz);
+    matrix.row_values.resize(nnz);
+    matrix.col_users.resize(nnz);
+    matrix.col_values.resize(nnz);
+
+    std::vector<uint32_t> row_fill(matrix.row_offsets.begin(), matrix.row_offsets.end() - 1);
+    std::vector<uint32_t> col_fill(matrix.col_offsets.begin(), matrix.col_offsets.end() - 1);
+    for (size_t k = 0; k < nnz; k++) {
+        float value = static_cast<float>(ratings[k].rating);
+        uint32_t row_slot = row_fill[user_of[k]]++;
+        matrix.row_items[row_slot] = item_of[k];
+        matrix.row_values[row_slot] = value;
+        uint32_t col_slot = col_fill[item_of[k]]++;
+        matrix.col_users[col_slot] = user_of[k];
+        matrix.col_values[col_slot] = value;
+    }
+
+    matrix.global_mean = nnz ? static_cast<float>(total / nnz) : 0.0f;
+
+    matrix.user_means.assign(users, matrix.global_mean);
+    for (size_t u = 0; u < users; u++) {
+        uint32_t begin = matrix.row_offsets[u], end = matrix.row_offsets[u + 1];
+        if (end == begin) continue;
+        double sum = 0.0;
+        for (uint32_t k = begin; k < end; k++) sum += matrix.row_values[k];
+        matrix.user_means[u] = static_cast<float>(sum / (end - begin));
+    }
+
+    matrix.item_means.assign(items, matrix.global_mean);
+    for (size_t i = 0; i < items; i++) {
+        uint32_t begin = matrix.col_offsets[i], end = matrix.col_offsets[i + 1];
+        if (end == begin) continue;
+        double sum = 0.0;
+        for (uint32_t k = begin; k < end; k++) sum += matrix.col_values[k];
+        matrix.item_means[i] = static_cast<float>(sum / (end - begin));
+    }
+
+    return matrix;
+}
+
+int RatingsMatrix::userIndex(int user_id) const {
+    auto it = user_index.find(user_id);
+    return it == user_index.end() ? -1 : it->second;
+}
+
+int RatingsMatrix::itemIndex(int movie_id) const {
+    auto it = item_index.find(movie_id);
+    return it == item_index.end() ? -1 : it->second;
+}
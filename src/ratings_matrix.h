@@ -0,0 +1,68 @@
+#ifndef RATINGS_MATRIX_H
+#define RATINGS_MATRIX_H
+
+#include "database.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Resultado comum dos recomendadores (maior score = melhor)
+struct ScoredMovie {
+    int movie_id;
+    double score;
+};
+
+// Matriz esparsa usuário × filme em dois layouts compactos:
+// CSR (linhas = usuários) para percorrer o histórico de um usuário e
+// CSC (colunas = filmes) para percorrer quem avaliou um filme.
+// IDs do banco são mapeados para índices densos 0..n-1.
+class RatingsMatrix {
+public:
+    static RatingsMatrix build(const std::vector<Rating>& ratings);
+
+    size_t userCount() const { return user_ids.size(); }
+    size_t itemCount() const { return item_ids.size(); }
+    size_t nonZeros() const { return row_items.size(); }
+
+    // -1 quando o ID não aparece em nenhuma avaliação
+    int userIndex(int user_id) const;
+    int itemIndex(int movie_id) const;
+    int userId(int user) const { return user_ids[user]; }
+    int itemId(int item) const { return item_ids[item]; }
+
+    float userMean(int user) const { return user_means[user]; }
+    float itemMean(int item) const { return item_means[item]; }
+    float globalMean() const { return global_mean; }
+
+    // CSR: avaliações do usuário em [rowBegin(u), rowEnd(u))
+    uint32_t rowBegin(int user) const { return row_offsets[user]; }
+    uint32_t rowEnd(int user) const { return row_offsets[user + 1]; }
+    const std::vector<int>& rowItems() const { return row_items; }
+    const std::vector<float>& rowValues() const { return row_values; }
+
+    // CSC: avaliações do filme em [colBegin(i), colEnd(i))
+    uint32_t colBegin(int item) const { return col_offsets[item]; }
+    uint32_t colEnd(int item) const { return col_offsets[item + 1]; }
+    const std::vector<int>& colUsers() const { return col_users; }
+    const std::vector<float>& colValues() const { return col_values; }
+
+private:
+    std::vector<int> user_ids;
+    std::vector<int> item_ids;
+    std::unordered_map<int, int> user_index;
+    std::unordered_map<int, int> item_index;
+
+    std::vector<uint32_t> row_offsets;
+    std::vector<int> row_items;
+    std::vector<float> row_values;
+
+    std::vector<uint32_t> col_offsets;
+    std::vector<int> col_users;
+    std::vector<float> col_values;
+
+    std::vector<float> user_means;
+    std::vector<float> item_means;
+    float global_mean = 0.0f;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "reco_store.h"
+#include "logger.h"
+#include "tracing.h"
+#include <ctime>
+
+RecoStore::RecoStore(ComputeFn compute_fn, std::chrono::milliseconds refresh_interval)
+    : compute(std::move(compute_fn)),
+      interval(refresh_interval),
+      generation(0),
+      running(false),
+      runs(0),
+      recomputed(0),
+      last_run_users(0),
+      last_run_at(0) {
+}
+
+RecoStore::~RecoStore() {
+    stop();
+}
+
+void RecoStore::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&RecoStore::workerLoop, this);
+}
+
+void RecoStore::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void RecoStore::markDirty(int user_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty[user_id] = ++generation;
+}
+
+void RecoStore::markDirty(const std::vector<int>& user_ids) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int user_id : user_ids) {
+        dirty[user_id] = ++generation;
+    }
+}
+
+void RecoStore::put(int user_id, std::shared_ptr<const StoredRecommendations> recommendations) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[user_id] = std::move(recommendations);
+}
+
+std::shared_ptr<const StoredRecommendations> RecoStore::lookup(int user_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto entry = entries.find(user_id);
+    return entry == entries.end() ? nullptr : entry->second;
+}
+
+bool RecoStore::isDirty(int user_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dirty.count(user_id) > 0;
+}
+
+void RecoStore::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        // Espera o intervalo inteiro: avaliações em sequência do mesmo
+        // usuário viram um único recálculo
+        wake.wait_for(lock, interval, [this] { return !running; });
+        if (!running || dirty.empty()) continue;
+
+        lock.unlock();
+        refreshDirty();
+        lock.lock();
+    }
+}
+
+size_t RecoStore::refreshDirty() {
+    TRACE_SPAN("reco_store.refresh");
+
+    // O usuário só sai do conjunto sujo se não tiver sido marcado de novo
+    // durante o próprio recálculo
+    std::vector<std::pair<int, uint64_t>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.assign(dirty.begin(), dirty.end());
+    }
+    if (pending.empty()) return 0;
+
+    auto run_start = std::chrono::steady_clock::now();
+    for (const auto& user : pending) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = std::make_shared<StoredRecommendations>();
+        bool computed = compute(user.first, *result);
+        if (computed) {
+            result->computed_at = static_cast<int64_t>(std::time(nullptr));
+        }
+        compute_latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (computed) {
+            entries[user.first] = std::move(result);
+        } else {
+            entries.erase(user.first);
+        }
+        auto marked = dirty.find(user.first);
+        if (marked != dirty.end() && marked->second == user.second) {
+            dirty.erase(marked);
+        }
+    }
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - run_start).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        runs++;
+        recomputed += pending.size();
+        last_run_users = pending.size();
+        last_run_at = static_cast<int64_t>(std::time(nullptr));
+    }
+
+    LOG_INFO("🗂️ Recomendações pré-calculadas atualizadas para %zu usuários em %.1f ms",
+             pending.size(), elapsed_ms);
+    return pending.size();
+}
+
+RecoStoreStats RecoStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    RecoStoreStats result;
+    result.users = entries.size();
+    result.dirty = dirty.size();
+    result.runs = runs;
+    result.recomputed = recomputed;
+    result.last_run_users = last_run_users;
+    result.last_run_at = last_run_at;
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef RECO_STORE_H
+#define RECO_STORE_H
+
+#include "metrics.h"
+#include "ratings_matrix.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Top-N materializado de um usuário
+struct StoredRecommendations {
+    std::vector<ScoredMovie> movies;
+    std::string source;       // modelo que gerou: "als", "cf" ou "content"
+    int64_t computed_at = 0;  // unix epoch, segundos
+};
+
+struct RecoStoreStats {
+    size_t users = 0;           // usuários com recomendações guardadas
+    size_t dirty = 0;           // aguardando recálculo
+    uint64_t runs = 0;
+    uint64_t recomputed = 0;    // total de usuários recalculados
+    uint64_t last_run_users = 0;
+    int64_t last_run_at = 0;    // unix epoch, segundos
+};
+
+// Recomendações pré-calculadas por usuário. Novas avaliações marcam o usuário
+// como sujo (markDirty) e um worker em segundo plano recalcula apenas os
+// usuários sujos, agrupando as marcações feitas dentro do intervalo.
+// A leitura é um lookup no mapa, sem tocar no banco nem nos modelos.
+class RecoStore {
+public:
+    // Calcula o top-N de um usuário; false se nenhum modelo puder atendê-lo
+    using ComputeFn = std::function<bool(int user_id, StoredRecommendations& out)>;
+
+    RecoStore(ComputeFn compute, std::chrono::milliseconds interval);
+    ~RecoStore();
+
+    void start();
+    void stop();
+
+    void markDirty(int user_id);
+    void markDirty(const std::vector<int>& user_ids);
+
+    // Publica um resultado calculado fora do worker (ex.: recálculo em lote)
+    void put(int user_id, std::shared_ptr<const StoredRecommendations> recommendations);
+
+    // Cópia compartilhada do último cálculo; nullptr se o usuário não tiver
+    std::shared_ptr<const StoredRecommendations> lookup(int user_id) const;
+    bool isDirty(int user_id) const;
+
+    // Recalcula agora os usuários sujos (o worker chama isto a cada rodada)
+    size_t refreshDirty();
+
+    RecoStoreStats stats() const;
+    LatencyHistogram& computeLatency() { return compute_latency; }
+
+private:
+    ComputeFn compute;
+    std::chrono::milliseconds interval;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::unordered_map<int, std::shared_ptr<const StoredRecommendations>> entries;
+    std::unordered_map<int, uint64_t> dirty;  // usuário → geração da última marcação
+    uint64_t generation;
+    bool running;
+    std::thread worker;
+
+    uint64_t runs;
+    uint64_t recomputed;
+    uint64_t last_run_users;
+    int64_t last_run_at;
+    LatencyHistogram compute_latency;  // µs por usuário recalculado
+
+    void workerLoop();
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CINEIA_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang geram AVX2/SSE4 por função; o resto do binário continua genérico
+#if defined(CINEIA_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CINEIA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CINEIA_TARGET(isa)
+#endif
+
+namespace {
+
+// ===== ESCALAR =====
+float dotScalar(const float* a, const float* b, size_t dim) {
+    float sum = 0.0f;
+    for (size_t d = 0; d < dim; d++) sum += a[d] * b[d];
+    return sum;
+}
+
+void dotBatchScalar(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = dotScalar(query, rows + i * dim, dim);
+    }
+}
+
+void cosineBatchScalar(const float* query, const float* rows, const float* row_norms,
+                       size_t count, size_t dim, float* out) {
+    float query_norm = std::sqrt(dotScalar(query, query, dim));
+    for (size_t i = 0; i < count; i++) {
+        float denominator = query_norm * row_norms[i];
+        out[i] = denominator > 0.0f ? dotScalar(query, rows + i * dim, dim) / denominator : 0.0f;
+    }
+}
+
+#ifdef CINEIA_X86
+// ===== SSE4.1 =====
+CINEIA_TARGET("sse4.1")
+float dotSSE4(const float* a, const float* b, size_t dim) {
+    __m128 acc = _mm_setzero_ps();
+    size_t d = 0;
+    for (; d + 4 <= dim; d += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + d), _mm_loadu_ps(b + d)));
+    }
+    __m128 shuffled = _mm_movehdup_ps(acc);
+    __m128 sums = _mm_add_ps(acc, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    float sum = _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+    for (; d < dim; d++) sum += a[d] * b[d];
+    return sum;
+}
+
+CINEIA_TARGET("sse4.1")
+void dotBatchSSE4(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = dotSSE4(query, rows + i * dim, dim);
+    }
+}
+
+CINEIA_TARGET("sse4.1")
+void cosineBatchSSE4(const float* query, const float* rows, const float* row_norms,
+                     size_t count, size_t dim, float* out) {
+    float query_norm = std::sqrt(dotSSE4(query, query, dim));
+    for (size_t i = 0; i < count; i++) {
+        float denominator = query_norm * row_norms[i];
+        out[i] = denominator > 0.0f ? dotSSE4(query, rows + i * dim, dim) / denominator : 0.0f;
+    }
+}
+
+// ===== AVX2 + FMA =====
+CINEIA_TARGET("avx2,fma")
+inline float horizontalSum(__m256 v) {
+    __m128 low = _mm256_castps256_ps128(v);
+    __m128 high = _mm256_extractf128_ps(v, 1);
+    low = _mm_add_ps(low, high);
+    __m128 shuffled = _mm_movehdup_ps(low);
+    __m128 sums = _mm_add_ps(low, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+CINEIA_TARGET("avx2,fma")
+float dotAVX2(const float* a, const float* b, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t d = 0;
+    for (; d + 16 <= dim; d += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + d), _mm256_loadu_ps(b + d), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + d + 8), _mm256_loadu_ps(b + d + 8), acc1);
+    }
+    for (; d + 8 <= dim; d += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + d), _mm256_loadu_ps(b + d), acc0);
+    }
+    float sum = horizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; d < dim; d++) sum += a[d] * b[d];
+    return sum;
+}
+
+// Quatro linhas por vez: cada bloco da consulta é carregado uma vez e as
+// quatro cadeias de FMA independentes escondem a latência da instrução.
+CINEIA_TARGET("avx2,fma")
+void dotBatchAVX2(const float* query, const float* rows, size_t count, size_t dim, float* out) {
+    size_t i = 0;
+    const size_t vector_dim = dim & ~static_cast<size_t>(7);
+    for (; i + 4 <= count; i += 4) {
+        const float* r0 = rows + i * dim;
+        const float* r1 = r0 + dim;
+        const float* r2 = r1 + dim;
+        const float* r3 = r2 + dim;
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+        for (size_t d = 0; d < vector_dim; d += 8) {
+            __m256 q = _mm256_loadu_ps(query + d);
+            acc0 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r0 + d), acc0);
+            acc1 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r1 + d), acc1);
+            acc2 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r2 + d), acc2);
+            acc3 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r3 + d), acc3);
+        }
+        float s0 = horizontalSum(acc0), s1 = horizontalSum(acc1);
+        float s2 = horizontalSum(acc2), s3 = horizontalSum(acc3);
+        for (size_t d = vector_dim; d < dim; d++) {
+            s0 += query[d] * r0[d];
+            s1 += query[d] * r1[d];
+            s2 += query[d] * r2[d];
+            s3 += query[d] * r3[d];
+        }
+        out[i] = s0;
+        out[i + 1] = s1;
+        out[i + 2] = s2;
+        out[i + 3] = s3;
+    }
+    for (; i < count; i++) {
+        out[i] = dotAVX2(query, rows + i * dim, dim);
+    }
+}
+
+CINEIA_TARGET("avx2,fma")
+void cosineBatchAVX2(const float* query, const float* rows, const float* row_norms,
+                     size_t count, size_t dim, float* out) {
+    dotBatchAVX2(query, rows, count, dim, out);
+    float query_norm = std::sqrt(dotAVX2(query, query, dim));
+    for (size_t i = 0; i < count; i++) {
+        float denominator = query_norm * row_norms[i];
+        out[i] = denominator > 0.0f ? out[i] / denominator : 0.0f;
+    }
+}
+
+bool cpuHas(const char* feature) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (std::strcmp(feature, "avx2") == 0) return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (std::strcmp(feature, "sse4") == 0) return __builtin_cpu_supports("sse4.1");
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    bool ymm_enabled = osxsave && (_xgetbv(0) & 6) == 6;
+    if (std::strcmp(feature, "avx2") == 0) return avx2 && fma && ymm_enabled;
+    if (std::strcmp(feature, "sse4") == 0) return sse41;
+    return false;
+#else
+    (void)feature;
+    return false;
+#endif
+}
+#endif
+
+const ScoringKernels kScalar = {"scalar", dotScalar, dotBatchScalar, cosineBatchScalar};
+#ifdef CINEIA_X86
+const ScoringKernels kSSE4 = {"sse4", dotSSE4, dotBatchSSE4, cosineBatchSSE4};
+const ScoringKernels kAVX2 = {"avx2", dotAVX2, dotBatchAVX2, cosineBatchAVX2};
+#endif
+
+const ScoringKernels& detectKernels() {
+#ifdef CINEIA_X86
+    if (cpuHas("avx2")) return kAVX2;
+    if (cpuHas("sse4")) return kSSE4;
+#endif
+    return kScalar;
+}
+
+}
+
+// ===== DESPACHO =====
+const ScoringKernels& scoringKernels() {
+    static const ScoringKernels& kernels = detectKernels();
+    return kernels;
+}
+
+const ScoringKernels* scoringKernelsNamed(const char* name) {
+    if (std::strcmp(name, "scalar") == 0) return &kScalar;
+#ifdef CINEIA_X86
+    if (std::strcmp(name, "sse4") == 0 && cpuHas("sse4")) return &kSSE4;
+    if (std::strcmp(name, "avx2") == 0 && cpuHas("avx2")) return &kAVX2;
+#endif
+    return nullptr;
+}
+
+std::vector<float> rowNorms(const float* rows, size_t count, size_t dim) {
+    const ScoringKernels& kernels = scoringKernels();
+    std::vector<float> norms(count);
+    for (size_t i = 0; i < count; i++) {
+        const float* row = rows + i * dim;
+        norms[i] = std::sqrt(kernels.dot(row, row, dim));
+    }
+    return norms;
+}
+
+// ===== TOP-K =====
+std::vector<ScoredIndex> topKScores(const float* scores, size_t count, size_t k, const ExcludeBitset* exclude) {
+    std::vector<ScoredIndex> heap;
+    if (k == 0) return heap;
+    heap.reserve(k);
+
+    // Heap de mínimo: heap.front() é o pior dos K melhores
+    auto worse = [](const ScoredIndex& a, const ScoredIndex& b) { return a.score > b.score; };
+    for (size_t i = 0; i < count; i++) {
+        float score = scores[i];
+        if (heap.size() == k && score <= heap.front().score) continue;
+        if (exclude && exclude->test(i)) continue;
+
+        if (heap.size() < k) {
+            heap.push_back({static_cast<uint32_t>(i), score});
+            std::push_heap(heap.begin(), heap.end(), worse);
+        } else {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            heap.back() = {static_cast<uint32_t>(i), score};
+            std::push_heap(heap.begin(), heap.end(), worse);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), worse);
+    return heap;
+}
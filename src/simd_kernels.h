@@ -0,0 +1,57 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kernels de pontuação densa (float32) com despacho em tempo de execução:
+// AVX2+FMA, SSE4.1 ou escalar, conforme a CPU. Linhas ficam contíguas:
+// a linha i de `rows` começa em rows + i * dim.
+struct ScoringKernels {
+    const char* name;
+
+    float (*dot)(const float* a, const float* b, size_t dim);
+
+    // out[i] = <query, rows[i]>
+    void (*dotBatch)(const float* query, const float* rows, size_t count, size_t dim, float* out);
+
+    // out[i] = <query, rows[i]> / (|query| · row_norms[i]); normas zero dão 0
+    void (*cosineBatch)(const float* query, const float* rows, const float* row_norms,
+                        size_t count, size_t dim, float* out);
+};
+
+// Melhor implementação suportada pela CPU (detectada uma única vez)
+const ScoringKernels& scoringKernels();
+
+// Implementação específica ("avx2", "sse4", "scalar"); nullptr se a CPU não suportar
+const ScoringKernels* scoringKernelsNamed(const char* name);
+
+// Normas L2 de cada linha, para reaproveitar em cosineBatch
+std::vector<float> rowNorms(const float* rows, size_t count, size_t dim);
+
+// Conjunto de índices excluídos (ex.: filmes já avaliados), 1 bit por item
+class ExcludeBitset {
+public:
+    explicit ExcludeBitset(size_t size = 0) : words((size + 63) / 64, 0) {}
+
+    void set(size_t index) { words[index >> 6] |= 1ULL << (index & 63); }
+    void clear(size_t index) { words[index >> 6] &= ~(1ULL << (index & 63)); }
+    void resize(size_t size) { words.assign((size + 63) / 64, 0); }
+    bool test(size_t index) const { return (words[index >> 6] >> (index & 63)) & 1ULL; }
+
+private:
+    std::vector<uint64_t> words;
+};
+
+struct ScoredIndex {
+    uint32_t index;
+    float score;
+};
+
+// Os K maiores scores (ordem decrescente), ignorando índices em `exclude`.
+// Heap de mínimo de tamanho K: O(n + K log K) no caso típico.
+std::vector<ScoredIndex> topKScores(const float* scores, size_t count, size_t k,
+                                    const ExcludeBitset* exclude = nullptr);
+
+#endif
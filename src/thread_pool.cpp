@@ -0,0 +1,114 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : thread_count(threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency())),
+      job(nullptr),
+      job_generation(0),
+      busy_workers(0),
+      stopping(false),
+      steal_count(0) {
+    if (thread_count < 1) thread_count = 1;
+
+    for (int i = 0; i < thread_count; i++) {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (int i = 1; i < thread_count; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(size_t count, size_t grain, const RangeFn& fn) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    std::lock_guard<std::mutex> call_lock(call_mutex);
+
+    // Blocos contíguos por worker: cada thread começa percorrendo uma faixa
+    // própria do intervalo, o que preserva a localidade quando não há roubo
+    size_t chunks = (count + grain - 1) / grain;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        size_t owner = chunk * thread_count / chunks;
+        size_t begin = chunk * grain;
+        queues[owner]->ranges.push_back({begin, std::min(count, begin + grain)});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        job = &fn;
+        job_generation++;
+        busy_workers = thread_count - 1;
+    }
+    job_ready.notify_all();
+
+    runJob(0, fn);
+
+    std::unique_lock<std::mutex> lock(job_mutex);
+    job_done.wait(lock, [this] { return busy_workers == 0; });
+    job = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        const RangeFn* fn;
+        {
+            std::unique_lock<std::mutex> lock(job_mutex);
+            job_ready.wait(lock, [&] { return stopping || job_generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = job_generation;
+            fn = job;
+        }
+
+        runJob(worker, *fn);
+
+        {
+            std::lock_guard<std::mutex> lock(job_mutex);
+            busy_workers--;
+        }
+        job_done.notify_one();
+    }
+}
+
+void WorkStealingPool::runJob(int worker, const RangeFn& fn) {
+    // Todos os blocos são enfileirados antes de o trabalho começar, então
+    // filas vazias em todos os workers significam que não há mais nada a pegar
+    Range range;
+    while (popLocal(worker, range) || steal(worker, range)) {
+        fn(range.begin, range.end, worker);
+    }
+}
+
+bool WorkStealingPool::popLocal(int worker, Range& range) {
+    Queue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) return false;
+    range = queue.ranges.front();
+    queue.ranges.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, Range& range) {
+    for (int offset = 1; offset < thread_count; offset++) {
+        Queue& victim = *queues[(worker + offset) % thread_count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.ranges.empty()) continue;
+        // Rouba do fim: o dono consome do início, então a disputa é rara
+        range = victim.ranges.back();
+        victim.ranges.pop_back();
+        steal_count.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool fixo com roubo de trabalho. parallelFor divide [0, count) em blocos de
+// `grain` índices; cada worker recebe uma faixa contígua de blocos na própria
+// fila e, quando ela esvazia, rouba blocos do fim da fila de outro worker.
+// Assim usuários "pesados" concentrados num trecho não deixam threads ociosas.
+class WorkStealingPool {
+public:
+    // fn(begin, end, worker): worker em [0, size()) identifica a thread,
+    // para que o chamador indexe buffers de rascunho próprios de cada uma
+    using RangeFn = std::function<void(size_t begin, size_t end, int worker)>;
+
+    explicit WorkStealingPool(int threads = 0);  // 0 = std::thread::hardware_concurrency()
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int size() const { return thread_count; }
+
+    // Bloqueia até todos os blocos terminarem; a thread chamadora é o worker 0
+    void parallelFor(size_t count, size_t grain, const RangeFn& fn);
+
+    uint64_t steals() const { return steal_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    int thread_count;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex call_mutex;  // um parallelFor por vez
+    std::mutex job_mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+    const RangeFn* job;
+    uint64_t job_generation;
+    int busy_workers;
+    bool stopping;
+
+    std::atomic<uint64_t> steal_count;
+
+    void workerLoop(int worker);
+    void runJob(int worker, const RangeFn& fn);
+    bool popLocal(int worker, Range& range);
+    bool steal(int worker, Range& range);
+};
+
+#endif
@@ -0,0 +1,275 @@
+#include "tracing.h"
+#include "logger.h"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+namespace {
+    struct ThreadTrace {
+        uint64_t trace_id = 0;
+        uint32_t current_span = 0;
+        uint32_t next_span = 1;
+        std::vector<SpanRecord> spans;
+    };
+
+    thread_local ThreadTrace current_trace;
+
+    uint64_t nextRandom() {
+        thread_local uint64_t state = [] {
+            std::random_device device;
+            uint64_t seed = (static_cast<uint64_t>(device()) << 32) ^ device();
+            return seed == 0 ? 0x9E3779B97F4A7C15ULL : seed;
+        }();
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    void appendJsonEscaped(std::string& out, const std::string& text) {
+        for (char ch : text) {
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += ch;
+            } else if (c < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += ch;
+            }
+        }
+    }
+}
+
+// ===== TRACER =====
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : active(false),
+      sample_threshold(UINT32_MAX),
+      running(true),
+      output(nullptr) {
+    if (const char* path = std::getenv("CINEIA_TRACE_FILE")) {
+        const char* sample = std::getenv("CINEIA_TRACE_SAMPLE");
+        configure(path, sample ? std::atof(sample) : 1.0);
+    }
+    writer = std::thread(&Tracer::writerLoop, this);
+}
+
+Tracer::~Tracer() {
+    stop();
+    if (output) {
+        std::fclose(output);
+    }
+}
+
+bool Tracer::configure(const std::string& path, double sample_rate) {
+    FILE* file = std::fopen(path.c_str(), "a");
+    if (!file) {
+        LOG_ERROR("❌ Não foi possível abrir o arquivo de trace: %s", path.c_str());
+        return false;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    if (std::ftell(file) == 0) {
+        // Array JSON sem fechamento: formato aceito pelo chrome://tracing e pelo Perfetto
+        std::fputs("[\n", file);
+    }
+
+    if (sample_rate < 0) sample_rate = 0;
+    if (sample_rate > 1) sample_rate = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (output) {
+            std::fclose(output);
+        }
+        output = file;
+    }
+    sample_threshold.store(static_cast<uint32_t>(sample_rate * UINT32_MAX), std::memory_order_relaxed);
+    active.store(true, std::memory_order_relaxed);
+
+    LOG_INFO("🔎 Rastreamento ativo em %s (amostragem %.0f%%)", path.c_str(), sample_rate * 100);
+    return true;
+}
+
+bool Tracer::shouldSample() {
+    uint32_t threshold = sample_threshold.load(std::memory_order_relaxed);
+    if (threshold == UINT32_MAX) return true;
+    if (threshold == 0) return false;
+    return static_cast<uint32_t>(nextRandom() >> 32) < threshold;
+}
+
+void Tracer::submit(std::vector<SpanRecord>&& spans) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        pending.push_back(std::move(spans));
+    }
+    queue_cv.notify_one();
+}
+
+void Tracer::writerLoop() {
+    std::vector<std::vector<SpanRecord>> batch;
+    std::unique_lock<std::mutex> lock(queue_mutex);
+
+    while (running) {
+        queue_cv.wait_for(lock, std::chrono::milliseconds(200), [this] {
+            return !pending.empty() || !running;
+        });
+        if (pending.empty()) continue;
+
+        batch.swap(pending);
+        lock.unlock();
+        writeBatch(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void Tracer::writeBatch(std::vector<std::vector<SpanRecord>>& batch) {
+    if (!output) return;
+
+    std::string buffer;
+    char numbers[160];
+    for (const auto& trace : batch) {
+        for (const auto& span : trace) {
+            buffer += "{\"name\":\"";
+            appendJsonEscaped(buffer, span.name);
+            if (!span.detail.empty()) {
+                buffer += ' ';
+                appendJsonEscaped(buffer, span.detail);
+            }
+            std::snprintf(numbers, sizeof(numbers),
+                "\",\"cat\":\"cineia\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld,"
+                "\"args\":{\"trace_id\":\"%016llx\",\"span_id\":%u,\"parent_id\":%u}},\n",
+                span.thread,
+                static_cast<long long>(span.start_us),
+                static_cast<long long>(span.duration_us),
+                static_cast<unsigned long long>(span.trace_id),
+                span.span_id, span.parent_id);
+            buffer += numbers;
+        }
+    }
+
+    std::fwrite(buffer.data(), 1, buffer.size(), output);
+    std::fflush(output);
+}
+
+void Tracer::flush() {
+    std::vector<std::vector<SpanRecord>> batch;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        batch.swap(pending);
+    }
+    writeBatch(batch);
+}
+
+void Tracer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (!running) return;
+        running = false;
+    }
+    queue_cv.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    flush();
+}
+
+int64_t Tracer::nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ===== SPAN RAIZ =====
+TraceRequest::TraceRequest(const std::string& request_name, bool force)
+    : trace_id(0), start_us(0) {
+    Tracer& tracer = Tracer::instance();
+    if (!tracer.enabled() || current_trace.trace_id != 0) return;
+    if (!force && !tracer.shouldSample()) return;
+
+    do {
+        trace_id = nextRandom();
+    } while (trace_id == 0);
+
+    name = request_name;
+    current_trace.trace_id = trace_id;
+    current_trace.current_span = 1;
+    current_trace.next_span = 2;
+    current_trace.spans.clear();
+    start_us = Tracer::nowMicros();
+}
+
+TraceRequest::~TraceRequest() {
+    finish();
+}
+
+void TraceRequest::finish() {
+    if (trace_id == 0) return;
+
+    SpanRecord root;
+    root.name = "http";
+    root.detail = std::move(name);
+    root.trace_id = trace_id;
+    root.span_id = 1;
+    root.parent_id = 0;
+    root.thread = Logger::threadNumber();
+    root.start_us = start_us;
+    root.duration_us = Tracer::nowMicros() - start_us;
+    current_trace.spans.push_back(std::move(root));
+
+    Tracer::instance().submit(std::move(current_trace.spans));
+    current_trace.spans = std::vector<SpanRecord>();
+    current_trace.trace_id = 0;
+    current_trace.current_span = 0;
+    trace_id = 0;
+}
+
+std::string TraceRequest::traceIdHex() const {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(trace_id));
+    return hex;
+}
+
+// ===== SPANS ANINHADOS =====
+TraceSpan::TraceSpan(const char* span_name)
+    : name(span_name), span_id(0), parent_id(0), start_us(0) {
+    if (current_trace.trace_id == 0) return;
+
+    span_id = current_trace.next_span++;
+    parent_id = current_trace.current_span;
+    current_trace.current_span = span_id;
+    start_us = Tracer::nowMicros();
+}
+
+TraceSpan::TraceSpan(const char* span_name, std::string span_detail)
+    : TraceSpan(span_name) {
+    if (span_id != 0) {
+        detail = std::move(span_detail);
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (span_id == 0 || current_trace.trace_id == 0) return;
+
+    current_trace.current_span = parent_id;
+    if (current_trace.spans.size() >= Tracer::kMaxSpansPerTrace) return;
+
+    SpanRecord record;
+    record.name = name;
+    record.detail = std::move(detail);
+    record.trace_id = current_trace.trace_id;
+    record.span_id = span_id;
+    record.parent_id = parent_id;
+    record.thread = Logger::threadNumber();
+    record.start_us = start_us;
+    record.duration_us = Tracer::nowMicros() - start_us;
+    current_trace.spans.push_back(std::move(record));
+}
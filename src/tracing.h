@@ -0,0 +1,103 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rastreamento leve em processo: cada requisição HTTP amostrada recebe um
+// trace id e os spans aninhados (Database, chamadas externas, serialização)
+// são exportados no formato Chrome trace-event (chrome://tracing, Perfetto).
+// Configuração por variáveis de ambiente:
+//   CINEIA_TRACE_FILE   = arquivo de saída (sem ele o rastreamento fica desligado)
+//   CINEIA_TRACE_SAMPLE = fração de requisições rastreadas, de 0 a 1 (padrão: 1)
+
+struct SpanRecord {
+    const char* name;
+    std::string detail;
+    uint64_t trace_id;
+    uint32_t span_id;
+    uint32_t parent_id;
+    uint32_t thread;
+    int64_t start_us;
+    int64_t duration_us;
+};
+
+class Tracer {
+public:
+    static constexpr size_t kMaxSpansPerTrace = 4096;
+
+    static Tracer& instance();
+
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+    bool configure(const std::string& path, double sample_rate);
+    bool shouldSample();
+
+    void submit(std::vector<SpanRecord>&& spans);
+    void flush();
+    void stop();
+
+    static int64_t nowMicros();
+
+private:
+    std::atomic<bool> active;
+    std::atomic<uint32_t> sample_threshold;   // fração * 2^32
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::vector<std::vector<SpanRecord>> pending;
+    bool running;
+    std::thread writer;
+    FILE* output;
+
+    Tracer();
+    ~Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    void writerLoop();
+    void writeBatch(std::vector<std::vector<SpanRecord>>& batch);
+};
+
+// Span raiz de uma requisição; vive do início ao fim do handler
+class TraceRequest {
+public:
+    TraceRequest(const std::string& name, bool force = false);
+    ~TraceRequest();
+
+    void finish();
+    bool sampled() const { return trace_id != 0; }
+    uint64_t traceId() const { return trace_id; }
+    std::string traceIdHex() const;
+
+private:
+    uint64_t trace_id;
+    int64_t start_us;
+    std::string name;
+};
+
+// Span aninhado; sem trace ativo na thread custa apenas uma leitura thread_local
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name);
+    TraceSpan(const char* name, std::string detail);
+    ~TraceSpan();
+
+private:
+    const char* name;
+    std::string detail;
+    uint32_t span_id;
+    uint32_t parent_id;
+    int64_t start_us;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(...) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,103 @@
+#include "trending.h"
+#include "tracing.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Acima deste expoente os valores relativos a t0 são reescalados para
+    // o instante atual, longe do limite do double (~e^709)
+    constexpr double kMaxExponent = 50.0;
+}
+
+TrendingTracker::TrendingTracker()
+    : window_specs({{"1h", 3600.0}, {"24h", 86400.0}, {"7d", 7 * 86400.0}}),
+      counters(window_specs.size()) {
+    for (size_t w = 0; w < window_specs.size(); w++) {
+        auto empty = std::make_shared<TrendingSnapshot>();
+        empty->window = window_specs[w].name;
+        counters[w].published = empty;
+    }
+}
+
+void TrendingTracker::rebase(Counter& counter, double tau, double now) {
+    double factor = std::exp((counter.reference - now) / tau);
+    for (auto& entry : counter.scores) {
+        entry.second *= factor;
+    }
+    counter.reference = now;
+}
+
+void TrendingTracker::record(int movie_id, int64_t timestamp) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t w = 0; w < counters.size(); w++) {
+        Counter& counter = counters[w];
+        double tau = window_specs[w].seconds;
+        if (counter.scores.empty()) {
+            counter.reference = static_cast<double>(timestamp);
+        }
+
+        double exponent = (timestamp - counter.reference) / tau;
+        if (exponent > kMaxExponent) {
+            rebase(counter, tau, static_cast<double>(timestamp));
+            exponent = 0.0;
+        }
+        counter.scores[movie_id] += std::exp(exponent);
+    }
+}
+
+void TrendingTracker::snapshot(int64_t now) {
+    TRACE_SPAN("trending.snapshot");
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t w = 0; w < counters.size(); w++) {
+        Counter& counter = counters[w];
+        double tau = window_specs[w].seconds;
+        if (!counter.scores.empty() && (now - counter.reference) / tau > kMaxExponent) {
+            rebase(counter, tau, static_cast<double>(now));
+        }
+
+        // Converte para "avaliações decaídas até agora" e descarta o que já
+        // esfriou de vez, para o mapa não crescer com o catálogo inteiro
+        double to_now = std::exp((counter.reference - now) / tau);
+        auto result = std::make_shared<TrendingSnapshot>();
+        result->window = window_specs[w].name;
+        result->taken_at = now;
+        for (auto it = counter.scores.begin(); it != counter.scores.end();) {
+            double score = it->second * to_now;
+            if (score < 1e-3) {
+                it = counter.scores.erase(it);
+                continue;
+            }
+            result->movies.push_back({it->first, score});
+            ++it;
+        }
+
+        auto by_score = [](const ScoredMovie& a, const ScoredMovie& b) {
+            return a.score != b.score ? a.score > b.score : a.movie_id < b.movie_id;
+        };
+        if (result->movies.size() > kSnapshotSize) {
+            std::partial_sort(result->movies.begin(), result->movies.begin() + kSnapshotSize,
+                              result->movies.end(), by_score);
+            result->movies.resize(kSnapshotSize);
+        } else {
+            std::sort(result->movies.begin(), result->movies.end(), by_score);
+        }
+        counter.published = result;
+    }
+}
+
+std::shared_ptr<const TrendingSnapshot> TrendingTracker::latest(const std::string& window) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t w = 0; w < window_specs.size(); w++) {
+        if (window_specs[w].name == window) return counters[w].published;
+    }
+    return nullptr;
+}
+
+size_t TrendingTracker::trackedMovies() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t tracked = 0;
+    for (const auto& counter : counters) {
+        tracked = std::max(tracked, counter.scores.size());
+    }
+    return tracked;
+}
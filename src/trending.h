@@ -0,0 +1,61 @@
+#ifndef TRENDING_H
+#define TRENDING_H
+
+#include "ratings_matrix.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Janela de tendência: cada avaliação vale exp(-idade / seconds)
+struct TrendingWindow {
+    std::string name;   // "1h", "24h", "7d"
+    double seconds;
+};
+
+// Top-K de uma janela num instante; imutável depois de publicado
+struct TrendingSnapshot {
+    std::string window;
+    int64_t taken_at = 0;              // unix epoch, segundos
+    std::vector<ScoredMovie> movies;   // score = avaliações decaídas até taken_at
+};
+
+// "Em alta agora": contadores por filme com decaimento exponencial, um por
+// janela. Gravar é O(1): cada evento soma exp((t - t0) / tau) a um valor
+// relativo a um instante de referência t0, então não é preciso decair todos
+// os contadores a cada avaliação. snapshot() ordena e publica o top-K de
+// cada janela, e a leitura (latest) só copia um shared_ptr.
+class TrendingTracker {
+public:
+    static constexpr size_t kSnapshotSize = 100;
+
+    TrendingTracker();
+
+    void record(int movie_id, int64_t timestamp);
+
+    // Recalcula o top-K de todas as janelas no instante `now`
+    void snapshot(int64_t now);
+
+    // Último snapshot da janela; nullptr se a janela não existir
+    std::shared_ptr<const TrendingSnapshot> latest(const std::string& window) const;
+
+    const std::vector<TrendingWindow>& windows() const { return window_specs; }
+    size_t trackedMovies() const;
+
+private:
+    struct Counter {
+        double reference = 0.0;  // t0 da janela (unix epoch, segundos)
+        std::unordered_map<int, double> scores;
+        std::shared_ptr<const TrendingSnapshot> published;
+    };
+
+    std::vector<TrendingWindow> window_specs;
+    mutable std::mutex mutex;
+    std::vector<Counter> counters;   // um por janela, mesma ordem de window_specs
+
+    static void rebase(Counter& counter, double tau, double now);
+};
+
+#endif
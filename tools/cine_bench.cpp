@@ -0,0 +1,840 @@
+// Benchmarks internos do Review Cine IA
+//
+// Uso: cine_bench <suite> [opções]
+//   logger [--threads N] [--seconds S] [--sample N]
+//          Vazão de requisições com log desligado, logger assíncrono e std::cout síncrono
+//   als    [--users N] [--items N] [--per-user N] [--rank N] [--iterations N]
+//          [--lambda X] [--threads N] [--explicit]
+//          Tempo de treino, latência de pontuação e recall@10 em dados sintéticos
+//   simd   [--dim N] [--k N]
+//          Produto escalar/cosseno em lote (escalar, SSE4, AVX2) e top-K com 10k, 100k e 1M itens
+//   hnsw   [--items N] [--dim N] [--queries N] [--M N] [--ef-construction N] [--threads N] [--ip]
+//          Recall@10 e latência do HNSW contra busca exata, build, inserção incremental e persistência
+//   batch  [--users N] [--items N] [--per-user N] [--rank N] [--threads N]
+//          Recálculo em lote (--batch-recompute) com 1, 2, 4... threads: itens/s por etapa e speedup
+//   ratings [--ratings N] [--threads N] [--batch N] [--delay-ms N] [--direct N]
+//          Avaliações/s num banco em disco: INSERT por avaliação contra RatingWriter (fila + group commit)
+//   msgpack [--items N] [--rounds N]
+//          Tamanho e tempo de codificação da lista de filmes: crow::json::wvalue contra MsgpackWriter
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "als.h"
+#include "batch_recompute.h"
+#include "database.h"
+#include "hnsw_index.h"
+#include "item_cf.h"
+#include "lock_profiler.h"
+#include "logger.h"
+#include "msgpack_writer.h"
+#include "rating_writer.h"
+#include "simd_kernels.h"
+#include "crow_all.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+#ifdef _WIN32
+    const char* kNullDevice = "NUL";
+#else
+    const char* kNullDevice = "/dev/null";
+#endif
+
+// ===== OPÇÕES DE LINHA DE COMANDO =====
+struct BenchOptions {
+    std::map<std::string, std::string> values;
+
+    int getInt(const std::string& key, int fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : std::atoi(it->second.c_str());
+    }
+
+    double getDouble(const std::string& key, double fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : std::atof(it->second.c_str());
+    }
+
+    std::string getString(const std::string& key, const std::string& fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : it->second;
+    }
+};
+
+BenchOptions parseOptions(int argc, char** argv, int first) {
+    BenchOptions options;
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            std::string key = arg.substr(2);
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) {
+                options.values[key] = argv[++i];
+            } else {
+                options.values[key] = "1";
+            }
+        }
+    }
+    return options;
+}
+
+int defaultThreads() {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 4 : static_cast<int>(hw);
+}
+
+// ===== BENCH: LOGGER =====
+// Cada "requisição" reproduz o trabalho de /api/rate: monta o corpo de
+// resposta e emite as mesmas linhas de log do handler.
+enum class LogMode { Off, Async, Sync };
+
+std::mutex sync_stream_mutex;
+std::ofstream sync_stream;
+std::atomic<size_t> bench_sink{0};   // impede o compilador de descartar o trabalho
+
+size_t simulateRateRequest(int request_id, LogMode mode) {
+    int user_id = request_id % 1000;
+    int movie_id = request_id % 5000;
+    double rating = (request_id % 100) / 10.0;
+
+    char body[256];
+    int len = std::snprintf(body, sizeof(body),
+        "{\"success\": true, \"message\": \"Avaliação registrada com sucesso\", \"rating_id\": %d}",
+        user_id);
+
+    if (mode == LogMode::Sync) {
+        // Mesmo padrão do código antigo: cada linha serializada no lock do stream
+        std::lock_guard<std::mutex> lock(sync_stream_mutex);
+        sync_stream << "🎯 Dados recebidos - User: " << user_id
+                    << ", Movie: " << movie_id
+                    << ", Rating: " << rating << std::endl;
+        sync_stream << "💾 Tentando salvar avaliação no banco..." << std::endl;
+        sync_stream << "✅ Avaliação salva com sucesso!" << std::endl;
+    } else {
+        LOG_DEBUG("📝 Recebendo avaliação: %s", body);
+        LOG_SAMPLED(LogLevel::Info, "🎯 Dados recebidos - User: %d, Movie: %d, Rating: %g",
+                    user_id, movie_id, rating);
+        LOG_DEBUG("💾 Tentando salvar avaliação no banco...");
+        LOG_SAMPLED(LogLevel::Info, "✅ Avaliação salva com sucesso!");
+    }
+
+    return static_cast<size_t>(len);
+}
+
+double runLoggerMode(LogMode mode, int threads, double seconds) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            uint64_t done = 0;
+            size_t sink = 0;
+            int request_id = t * 1000003;
+            while (!stop.load(std::memory_order_relaxed)) {
+                sink += simulateRateRequest(request_id++, mode);
+                done++;
+            }
+            total.fetch_add(done, std::memory_order_relaxed);
+            bench_sink.fetch_add(sink, std::memory_order_relaxed);
+        });
+    }
+
+    auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (mode == LogMode::Async) {
+        Logger::instance().flush();
+    }
+    return total.load() / elapsed;
+}
+
+int benchLogger(const BenchOptions& options) {
+    int threads = options.getInt("threads", defaultThreads());
+    double seconds = options.getDouble("seconds", 2.0);
+
+    Logger& logger = Logger::instance();
+    logger.setSampleEvery(static_cast<uint32_t>(options.getInt("sample", 1)));
+    if (!logger.setOutputFile(kNullDevice)) {
+        std::cerr << "❌ Não foi possível abrir " << kNullDevice << "\n";
+        return 1;
+    }
+    sync_stream.open(kNullDevice);
+
+    std::cout << "📊 Vazão de /api/rate simulado (" << threads << " threads, "
+              << seconds << "s por modo)\n\n";
+
+    logger.setLevel(LogLevel::Off);
+    double off = runLoggerMode(LogMode::Off, threads, seconds);
+
+    logger.setLevel(LogLevel::Info);
+    uint64_t dropped_before = logger.droppedCount();
+    double async = runLoggerMode(LogMode::Async, threads, seconds);
+    uint64_t dropped = logger.droppedCount() - dropped_before;
+
+    double sync = runLoggerMode(LogMode::Sync, threads, seconds);
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "   log desligado        : " << std::setw(12) << off << " req/s\n";
+    std::cout << "   logger assíncrono    : " << std::setw(12) << async << " req/s"
+              << "  (" << dropped << " mensagens descartadas)\n";
+    std::cout << "   std::cout síncrono   : " << std::setw(12) << sync << " req/s\n";
+    return 0;
+}
+
+// ===== BENCH: ALS =====
+// Dados sintéticos com estrutura latente conhecida: cada usuário escolhe os
+// filmes de maior afinidade (com ruído) entre candidatos sorteados. Um filme
+// por usuário fica de fora do treino e conta como acerto se aparecer no top-10.
+struct SyntheticRatings {
+    std::vector<Rating> train;
+    std::vector<Rating> held_out;   // um por usuário
+};
+
+SyntheticRatings generateLatentRatings(int users, int items, int per_user, unsigned seed) {
+    const int dims = 8;
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_int_distribution<int> pick_item(0, items - 1);
+
+    std::vector<float> item_vectors(static_cast<size_t>(items) * dims);
+    for (auto& value : item_vectors) value = normal(rng);
+
+    SyntheticRatings data;
+    std::vector<float> user_vector(dims);
+    std::vector<std::pair<float, int>> candidates;
+    std::vector<int> last_seen_by(items, -1);
+    for (int u = 0; u < users; u++) {
+        for (auto& value : user_vector) value = normal(rng);
+
+        candidates.clear();
+        for (int c = 0; c < per_user * 25; c++) {
+            int item = pick_item(rng);
+            if (last_seen_by[item] == u) continue;
+            last_seen_by[item] = u;
+            float affinity = 0.0f;
+            for (int d = 0; d < dims; d++) affinity += user_vector[d] * item_vectors[static_cast<size_t>(item) * dims + d];
+            candidates.push_back({affinity / std::sqrt(static_cast<float>(dims)) + 0.3f * normal(rng), item});
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<float, int>>());
+        candidates.resize(std::min<size_t>(candidates.size(), per_user));
+
+        size_t held = rng() % candidates.size();
+        for (size_t k = 0; k < candidates.size(); k++) {
+            Rating rating;
+            rating.id = 0;
+            rating.user_id = u + 1;
+            rating.movie_id = candidates[k].second + 1;
+            rating.rating = std::max(1.0, std::min(10.0, std::round(5.5 + 2.0 * candidates[k].first)));
+            (k == held ? data.held_out : data.train).push_back(rating);
+        }
+    }
+    return data;
+}
+
+int benchALS(const BenchOptions& options) {
+    int users = options.getInt("users", 5000);
+    int items = options.getInt("items", 2000);
+    int per_user = options.getInt("per-user", 40);
+
+    ALSOptions als;
+    als.rank = options.getInt("rank", 32);
+    als.iterations = options.getInt("iterations", 10);
+    als.lambda = static_cast<float>(options.getDouble("lambda", 0.1));
+    als.threads = options.getInt("threads", defaultThreads());
+    als.implicit = options.values.count("explicit") == 0;
+
+    Logger::instance().setLevel(LogLevel::Warn);
+
+    std::cout << "📊 ALS em dados sintéticos: " << users << " usuários, " << items << " filmes, "
+              << per_user << " avaliações/usuário, rank " << als.rank << ", "
+              << als.iterations << " iterações, " << als.threads << " threads, "
+              << (als.implicit ? "implícito" : "explícito") << "\n\n";
+
+    SyntheticRatings data = generateLatentRatings(users, items, per_user, 7);
+    RatingsMatrix matrix = RatingsMatrix::build(data.train);
+
+    auto started = Clock::now();
+    std::shared_ptr<ALSModel> model = ALSModel::train(matrix, als);
+    double train_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    // Baseline: filmes mais populares do treino
+    std::vector<std::pair<size_t, int>> popularity;
+    for (size_t i = 0; i < matrix.itemCount(); i++) {
+        popularity.push_back({matrix.colEnd(static_cast<int>(i)) - matrix.colBegin(static_cast<int>(i)), matrix.itemId(static_cast<int>(i))});
+    }
+    std::sort(popularity.begin(), popularity.end(), std::greater<std::pair<size_t, int>>());
+
+    const size_t k = 10;
+    size_t hits = 0, popular_hits = 0, evaluated = 0;
+    double scoring_seconds = 0.0;
+    for (const auto& held : data.held_out) {
+        int user = model->userIndex(held.user_id);
+        if (user < 0) continue;
+
+        std::vector<int> seen;
+        for (uint32_t p = matrix.rowBegin(user); p < matrix.rowEnd(user); p++) {
+            seen.push_back(matrix.rowItems()[p]);
+        }
+
+        auto scoring_started = Clock::now();
+        std::vector<ScoredMovie> top = model->topK(model->userVector(user), seen, k);
+        scoring_seconds += std::chrono::duration<double>(Clock::now() - scoring_started).count();
+
+        for (const auto& movie : top) {
+            if (movie.movie_id == held.movie_id) hits++;
+        }
+
+        std::vector<int> seen_ids;
+        for (int item : seen) seen_ids.push_back(matrix.itemId(item));
+        std::sort(seen_ids.begin(), seen_ids.end());
+        size_t taken = 0;
+        for (const auto& entry : popularity) {
+            if (taken == k) break;
+            if (std::binary_search(seen_ids.begin(), seen_ids.end(), entry.second)) continue;
+            if (entry.second == held.movie_id) popular_hits++;
+            taken++;
+        }
+        evaluated++;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "   treino               : " << train_seconds << " s ("
+              << matrix.nonZeros() << " avaliações)\n";
+    std::cout << "   pontuação (top-10)   : " << (evaluated ? scoring_seconds * 1e3 / evaluated : 0.0)
+              << " ms/usuário\n";
+    std::cout << "   recall@10 ALS        : " << (evaluated ? static_cast<double>(hits) / evaluated : 0.0) << "\n";
+    std::cout << "   recall@10 populares  : " << (evaluated ? static_cast<double>(popular_hits) / evaluated : 0.0) << "\n";
+    return 0;
+}
+
+// ===== BENCH: SIMD =====
+// Repete a operação até somar ~0.3 s e devolve o tempo médio por execução
+template <typename Fn>
+double timePerRun(Fn fn) {
+    size_t runs = 0;
+    auto started = Clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    } while (elapsed < 0.3);
+    return elapsed / runs;
+}
+
+int benchSimd(const BenchOptions& options) {
+    const size_t dim = static_cast<size_t>(options.getInt("dim", 32));
+    const size_t k = static_cast<size_t>(options.getInt("k", 10));
+    const char* kernel_names[] = {"scalar", "sse4", "avx2"};
+
+    std::cout << "📊 Pontuação densa (dim " << dim << ", top-" << k << "), kernel ativo: "
+              << scoringKernels().name << "\n";
+
+    std::mt19937 rng(11);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    for (size_t items : {static_cast<size_t>(10000), static_cast<size_t>(100000), static_cast<size_t>(1000000)}) {
+        std::vector<float> rows(items * dim);
+        for (auto& value : rows) value = normal(rng);
+        std::vector<float> query(dim);
+        for (auto& value : query) value = normal(rng);
+        std::vector<float> norms = rowNorms(rows.data(), items, dim);
+        std::vector<float> scores(items), reference(items);
+
+        std::cout << "\n   " << items << " itens\n";
+        for (const char* name : kernel_names) {
+            const ScoringKernels* kernels = scoringKernelsNamed(name);
+            if (!kernels) {
+                std::cout << "     " << std::left << std::setw(7) << name << std::right << ": não suportado pela CPU\n";
+                continue;
+            }
+
+            double dot_seconds = timePerRun([&] {
+                kernels->dotBatch(query.data(), rows.data(), items, dim, scores.data());
+            });
+            double cosine_seconds = timePerRun([&] {
+                kernels->cosineBatch(query.data(), rows.data(), norms.data(), items, dim, scores.data());
+            });
+
+            kernels->dotBatch(query.data(), rows.data(), items, dim, scores.data());
+            if (std::strcmp(name, "scalar") == 0) reference = scores;
+            float max_error = 0.0f;
+            for (size_t i = 0; i < items; i++) max_error = std::max(max_error, std::fabs(scores[i] - reference[i]));
+
+            std::cout << std::fixed << std::setprecision(3)
+                      << "     " << std::left << std::setw(7) << name << std::right
+                      << ": dot " << std::setw(8) << dot_seconds * 1e3 << " ms ("
+                      << std::setprecision(1) << std::setw(6) << 2.0 * items * dim / dot_seconds / 1e9 << " GFLOP/s)"
+                      << std::setprecision(3) << ", cosseno " << std::setw(8) << cosine_seconds * 1e3 << " ms"
+                      << ", erro máx. " << std::scientific << std::setprecision(1) << max_error << "\n";
+        }
+
+        // 1% dos itens já avaliados, marcados no bitset
+        ExcludeBitset excluded(items);
+        for (size_t i = 0; i < items / 100; i++) excluded.set(rng() % items);
+
+        scoringKernels().dotBatch(query.data(), rows.data(), items, dim, scores.data());
+        double heap_seconds = timePerRun([&] {
+            bench_sink += topKScores(scores.data(), items, k, &excluded).size();
+        });
+        double sort_seconds = timePerRun([&] {
+            std::vector<ScoredIndex> all;
+            all.reserve(items);
+            for (size_t i = 0; i < items; i++) {
+                if (!excluded.test(i)) all.push_back({static_cast<uint32_t>(i), scores[i]});
+            }
+            size_t keep = std::min(k, all.size());
+            std::partial_sort(all.begin(), all.begin() + keep, all.end(),
+                [](const ScoredIndex& a, const ScoredIndex& b) { return a.score > b.score; });
+            bench_sink += keep;
+        });
+        std::cout << std::fixed << std::setprecision(3)
+                  << "     top-" << k << " heap: " << heap_seconds * 1e3 << " ms, cópia + partial_sort: "
+                  << sort_seconds * 1e3 << " ms\n";
+    }
+    return 0;
+}
+
+// ===== BENCH: HNSW =====
+// Vetores em grupos (mistura de gaussianas), parecidos com embeddings reais
+std::vector<float> clusteredVectors(size_t count, size_t dim, std::mt19937& rng) {
+    const size_t clusters = 64;
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> centers(clusters * dim);
+    for (auto& value : centers) value = normal(rng);
+
+    std::vector<float> vectors(count * dim);
+    for (size_t i = 0; i < count; i++) {
+        const float* center = &centers[(rng() % clusters) * dim];
+        for (size_t d = 0; d < dim; d++) vectors[i * dim + d] = center[d] + 0.6f * normal(rng);
+    }
+    return vectors;
+}
+
+int benchHnsw(const BenchOptions& options) {
+    const size_t items = static_cast<size_t>(options.getInt("items", 50000));
+    const size_t dim = static_cast<size_t>(options.getInt("dim", 32));
+    const size_t queries = static_cast<size_t>(options.getInt("queries", 500));
+    const size_t k = 10;
+
+    HnswOptions hnsw;
+    hnsw.M = options.getInt("M", 16);
+    hnsw.ef_construction = options.getInt("ef-construction", 200);
+    hnsw.threads = options.getInt("threads", defaultThreads());
+    hnsw.metric = options.values.count("ip") ? VectorMetric::InnerProduct : VectorMetric::Cosine;
+    const bool cosine = hnsw.metric == VectorMetric::Cosine;
+
+    Logger::instance().setLevel(LogLevel::Warn);
+    std::cout << "📊 HNSW: " << items << " vetores, dim " << dim << ", M " << hnsw.M
+              << ", ef_construction " << hnsw.ef_construction << ", " << hnsw.threads << " threads, "
+              << (cosine ? "cosseno" : "produto escalar") << "\n\n";
+
+    std::mt19937 rng(5);
+    std::vector<float> vectors = clusteredVectors(items, dim, rng);
+    std::vector<float> query_vectors = clusteredVectors(queries, dim, rng);
+    std::vector<int> labels(items);
+    for (size_t i = 0; i < items; i++) labels[i] = static_cast<int>(i);
+
+    // Incremental: os últimos 1% entram um a um depois do build
+    size_t incremental = std::max<size_t>(1, items / 100);
+    size_t bulk = items - incremental;
+
+    HnswIndex index(dim, hnsw);
+    auto started = Clock::now();
+    index.build(std::vector<int>(labels.begin(), labels.begin() + bulk),
+                std::vector<float>(vectors.begin(), vectors.begin() + bulk * dim));
+    double build_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    started = Clock::now();
+    for (size_t i = bulk; i < items; i++) index.add(labels[i], &vectors[i * dim]);
+    double insert_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    // Verdade exata por varredura completa com os kernels SIMD
+    std::vector<float> norms = rowNorms(vectors.data(), items, dim);
+    std::vector<float> scores(items);
+    std::vector<std::vector<uint32_t>> truth(queries);
+    started = Clock::now();
+    for (size_t q = 0; q < queries; q++) {
+        const float* query = &query_vectors[q * dim];
+        if (cosine) {
+            scoringKernels().cosineBatch(query, vectors.data(), norms.data(), items, dim, scores.data());
+        } else {
+            scoringKernels().dotBatch(query, vectors.data(), items, dim, scores.data());
+        }
+        for (const ScoredIndex& best : topKScores(scores.data(), items, k)) truth[q].push_back(best.index);
+    }
+    double brute_ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count() / queries;
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "   build                : " << build_seconds << " s (" << bulk << " vetores)\n";
+    std::cout << "   inserção incremental : " << insert_seconds * 1e3 / incremental << " ms/vetor ("
+              << incremental << " vetores)\n";
+    std::cout << "   busca exata          : " << brute_ms << " ms/consulta\n\n";
+
+    for (int ef : {16, 32, 64, 128, 256}) {
+        size_t hits = 0;
+        started = Clock::now();
+        std::vector<std::vector<ScoredMovie>> results(queries);
+        for (size_t q = 0; q < queries; q++) {
+            results[q] = index.search(&query_vectors[q * dim], k, ef);
+        }
+        double ann_ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count() / queries;
+        for (size_t q = 0; q < queries; q++) {
+            for (const auto& found : results[q]) {
+                if (std::find(truth[q].begin(), truth[q].end(), static_cast<uint32_t>(found.movie_id)) != truth[q].end()) hits++;
+            }
+        }
+        std::cout << "   ef " << std::setw(3) << ef << "  recall@10 " << static_cast<double>(hits) / (queries * k)
+                  << "  latência " << ann_ms << " ms (" << std::setprecision(1) << brute_ms / ann_ms
+                  << "x mais rápido)" << std::setprecision(3) << "\n";
+    }
+
+    std::string path = "cine_bench_hnsw.bin";
+    started = Clock::now();
+    bool saved = index.save(path);
+    double save_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    started = Clock::now();
+    std::shared_ptr<HnswIndex> loaded = HnswIndex::load(path);
+    double load_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    std::remove(path.c_str());
+    std::cout << "\n   persistência         : gravação " << save_seconds << " s, leitura " << load_seconds << " s"
+              << (saved && loaded && loaded->size() == items ? "" : " (FALHOU)") << "\n";
+    return 0;
+}
+
+// ===== BENCH: RECÁLCULO EM LOTE =====
+// Banco em memória com os mesmos dados sintéticos do bench de ALS; o mesmo
+// lote roda com número crescente de threads para medir a escalabilidade.
+int benchBatch(const BenchOptions& options) {
+    int users = options.getInt("users", 20000);
+    int items = options.getInt("items", 2000);
+    int per_user = options.getInt("per-user", 40);
+    int max_threads = options.getInt("threads", defaultThreads());
+
+    // A leitura de todas as avaliações passaria do limite de consulta lenta
+    Logger::instance().setLevel(LogLevel::Error);
+
+    Database db(":memory:");
+    if (!db.init()) {
+        std::cerr << "❌ Não foi possível criar o banco em memória\n";
+        return 1;
+    }
+
+    SyntheticRatings data = generateLatentRatings(users, items, per_user, 11);
+    db.execute("BEGIN");
+    for (int i = 0; i < items; i++) {
+        Movie movie;
+        movie.title = "Filme " + std::to_string(i + 1);
+        movie.genre = "Drama";
+        movie.imdb_rating = 7.0;
+        movie.rotten_tomatoes_rating = 0.0;
+        movie.year = 2000;
+        db.createMovie(movie);
+    }
+    for (const auto& rating : data.train) {
+        db.addRating(rating.user_id, rating.movie_id, rating.rating);
+    }
+    db.execute("COMMIT");
+
+    RatingsMatrix matrix = RatingsMatrix::build(data.train);
+    ALSOptions als;
+    als.rank = options.getInt("rank", 32);
+    als.iterations = 5;
+    BatchModels models;
+    models.als = ALSModel::train(matrix, als);
+    models.item_cf = ItemCFModel::train(std::move(matrix));
+
+    std::cout << "📦 Recálculo em lote: " << users << " usuários, " << items << " filmes, "
+              << data.train.size() << " avaliações, rank " << als.rank << "\n\n";
+    std::cout << std::fixed;
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(std::max(1, max_threads));
+
+    ProfiledMutex mutex("bench_db");
+    double single_thread_rate = 0.0;
+    for (int threads : thread_counts) {
+        BatchOptions batch;
+        batch.threads = threads;
+        BatchReport report = runBatchRecompute(db, [&mutex]() {
+            return ProfiledLock(mutex, LOCK_SITE("bench.batch"));
+        }, models, batch);
+
+        double users_rate = 0.0;
+        std::cout << "   " << threads << " thread(s): total " << std::setprecision(3)
+                  << report.total_seconds << " s, " << report.rows_written << " linhas\n";
+        for (const auto& stage : report.stages) {
+            if (stage.name == "users") users_rate = stage.itemsPerSecond();
+            std::cout << "      " << std::left << std::setw(14) << stage.name << std::right
+                      << std::setprecision(3) << std::setw(8) << stage.seconds << " s "
+                      << std::setprecision(0) << std::setw(12) << stage.itemsPerSecond() << " itens/s\n";
+        }
+        if (threads == 1) single_thread_rate = users_rate;
+        std::cout << "      speedup (usuários): " << std::setprecision(2)
+                  << (single_thread_rate > 0 ? users_rate / single_thread_rate : 0.0)
+                  << "x, roubos: " << report.steals << "\n";
+    }
+    return 0;
+}
+
+// ===== BENCH: GRAVAÇÃO DE AVALIAÇÕES =====
+// Banco em arquivo (o custo dominante é o fsync de cada COMMIT). Várias
+// threads produtoras gravam avaliações de três formas: INSERT direto com
+// lock por avaliação (o /api/rate antigo), RatingWriter sem espera e
+// RatingWriter durável, em que cada produtor espera o COMMIT do seu lote.
+int benchRatings(const BenchOptions& options) {
+    int total = options.getInt("ratings", 20000);
+    int producers = std::max(1, options.getInt("threads", 8));
+    size_t max_batch = static_cast<size_t>(std::max(1, options.getInt("batch", 1024)));
+    int delay_ms = std::max(0, options.getInt("delay-ms", 2));
+    const int users = 1000;
+    const int movies = 500;
+
+    std::string path = "cine_bench_ratings.db";
+    std::remove(path.c_str());
+    Database db(path);
+    if (!db.init()) {
+        std::cerr << "❌ Não foi possível criar " << path << "\n";
+        return 1;
+    }
+
+    // Usuários e filmes 1..N: a gravação em lote rejeita IDs inexistentes
+    db.execute("BEGIN");
+    for (int u = 0; u < users; u++) {
+        db.createUser("bench_" + std::to_string(u + 1), "x");
+    }
+    for (int m = 0; m < movies; m++) {
+        Movie movie;
+        movie.title = "Filme " + std::to_string(m + 1);
+        movie.genre = "Drama";
+        movie.imdb_rating = 7.0;
+        movie.rotten_tomatoes_rating = 0.0;
+        movie.year = 2000;
+        db.createMovie(movie);
+    }
+    db.execute("COMMIT");
+
+    ProfiledMutex mutex("bench_db");
+    DatabaseLockFn lock_db = [&mutex]() { return ProfiledLock(mutex, LOCK_SITE("bench.ratings")); };
+
+    // Cada produtor grava count / producers avaliações; devolve avaliações/s
+    auto run = [&](int count, const std::function<void(int user_id, int movie_id, double rating)>& write) {
+        int per_producer = std::max(1, count / producers);
+        auto started = Clock::now();
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                std::mt19937 rng(1000 + p);
+                for (int i = 0; i < per_producer; i++) {
+                    write(static_cast<int>(rng() % users) + 1, static_cast<int>(rng() % movies) + 1,
+                          static_cast<double>(rng() % 11));
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        return per_producer * producers / seconds;
+    };
+
+    std::cout << "✍️ Gravação de avaliações: " << producers << " produtores, banco em disco ("
+              << path << ")\n\n" << std::fixed << std::setprecision(0);
+
+    // O caminho direto é ordens de grandeza mais lento; limita para não demorar
+    int direct_total = std::min(total, options.getInt("direct", 2000));
+    double direct_rate = run(direct_total, [&](int user_id, int movie_id, double rating) {
+        auto lock = lock_db();
+        db.addRating(user_id, movie_id, rating);
+    });
+    std::cout << "   INSERT por avaliação     : " << std::setw(10) << direct_rate << " avaliações/s\n";
+
+    double async_rate = 0.0;
+    RatingWriterStats async_stats;
+    {
+        RatingWriter writer(db, lock_db, max_batch, std::chrono::milliseconds(delay_ms));
+        writer.start();
+        async_rate = run(total, [&](int user_id, int movie_id, double rating) {
+            writer.submit(user_id, movie_id, rating);
+        });
+        // Vazão fim a fim: inclui esvaziar a fila
+        auto started = Clock::now();
+        writer.stop();
+        async_stats = writer.stats();
+        double drain_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        async_rate = async_stats.committed / (async_stats.committed / async_rate + drain_seconds);
+    }
+    std::cout << "   RatingWriter             : " << std::setw(10) << async_rate << " avaliações/s ("
+              << async_stats.batches << " lotes, maior " << async_stats.largest_batch << ")\n";
+
+    double durable_rate = 0.0;
+    RatingWriterStats durable_stats;
+    {
+        RatingWriter writer(db, lock_db, max_batch, std::chrono::milliseconds(delay_ms));
+        writer.start();
+        durable_rate = run(total, [&](int user_id, int movie_id, double rating) {
+            writer.submitDurable(user_id, movie_id, rating).get();
+        });
+        durable_stats = writer.stats();
+    }
+    std::cout << "   RatingWriter (durável)   : " << std::setw(10) << durable_rate << " avaliações/s ("
+              << durable_stats.batches << " lotes, maior " << durable_stats.largest_batch << ")\n";
+    std::cout << "\n   ganho sobre INSERT por avaliação: " << std::setprecision(1)
+              << (direct_rate > 0 ? async_rate / direct_rate : 0.0) << "x (sem espera), "
+              << (direct_rate > 0 ? durable_rate / direct_rate : 0.0) << "x (durável)\n";
+
+    std::remove(path.c_str());
+    return 0;
+}
+
+// ===== BENCH: FORMATO DAS RESPOSTAS =====
+// Mesma lista de filmes que /api/movies devolve, codificada como o handler
+// faz: JSON montando um crow::json::wvalue e serializando, ou MessagePack
+// escrito direto das structs.
+int benchMsgpack(const BenchOptions& options) {
+    int items = std::max(1, options.getInt("items", 20000));
+    int rounds = std::max(1, options.getInt("rounds", 5));
+
+    std::mt19937 rng(42);
+    const char* genres[] = {"Drama", "Action, Adventure", "Comedy, Romance", "Animation, Family", "Horror"};
+    std::vector<Movie> movies(items);
+    for (int i = 0; i < items; i++) {
+        Movie& movie = movies[i];
+        movie.id = i + 1;
+        movie.year = 1950 + static_cast<int>(rng() % 75);
+        movie.title = "Filme de Benchmark " + std::to_string(i + 1);
+        movie.imdb_id = "tt" + std::to_string(1000000 + i);
+        movie.genre = genres[rng() % 5];
+        movie.description = std::string(120 + rng() % 200, 'x');
+        movie.actors = "Ator Um, Atriz Dois, Ator Três";
+        movie.poster_url = "https://m.media-amazon.com/images/M/" + std::to_string(rng()) + "._V1_SX300.jpg";
+        movie.imdb_rating = (rng() % 100) / 10.0;
+        movie.rotten_tomatoes_rating = static_cast<double>(rng() % 100);
+    }
+
+    auto encodeJson = [&]() {
+        crow::json::wvalue result;
+        result["success"] = true;
+        result["count"] = static_cast<int>(movies.size());
+        result["change_seq"] = static_cast<int64_t>(movies.size());
+        std::vector<crow::json::wvalue> movie_list;
+        for (const auto& movie : movies) {
+            crow::json::wvalue movie_json;
+            movie_json["id"] = movie.id;
+            movie_json["title"] = movie.title;
+            movie_json["genre"] = movie.genre;
+            movie_json["year"] = movie.year;
+            movie_json["actors"] = movie.actors;
+            movie_json["description"] = movie.description;
+            movie_json["poster_url"] = movie.poster_url;
+            movie_json["imdb_rating"] = movie.imdb_rating;
+            movie_json["rotten_tomatoes_rating"] = movie.rotten_tomatoes_rating;
+            movie_list.push_back(movie_json);
+        }
+        result["movies"] = std::move(movie_list);
+        return result.dump();
+    };
+
+    auto encodeMsgpack = [&]() {
+        MsgpackWriter out;
+        out.reserve(movies.size() * 512);
+        out.mapHeader(4);
+        out.key("success");
+        out.boolean(true);
+        out.key("count");
+        out.integer(static_cast<int64_t>(movies.size()));
+        out.key("change_seq");
+        out.integer(static_cast<int64_t>(movies.size()));
+        out.key("movies");
+        out.arrayHeader(static_cast<uint32_t>(movies.size()));
+        for (const auto& movie : movies) writeMovie(out, movie);
+        return out.release();
+    };
+
+    // Melhor de `rounds` execuções; devolve (ms, bytes)
+    auto measure = [&](const std::function<std::string()>& encode) {
+        double best_ms = 0.0;
+        size_t bytes = 0;
+        for (int r = 0; r < rounds; r++) {
+            auto started = Clock::now();
+            std::string body = encode();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+            if (r == 0 || ms < best_ms) best_ms = ms;
+            bytes = body.size();
+            bench_sink += body.size();
+        }
+        return std::make_pair(best_ms, bytes);
+    };
+
+    std::cout << "📦 Resposta de /api/movies com " << items << " filmes (melhor de " << rounds << ")\n\n"
+              << std::fixed;
+    auto json = measure(encodeJson);
+    auto msgpack = measure(encodeMsgpack);
+    auto report = [](const char* name, const std::pair<double, size_t>& result) {
+        std::cout << "   " << std::left << std::setw(22) << name << std::right << std::setprecision(2)
+                  << std::setw(10) << result.first << " ms " << std::setw(12) << result.second << " bytes "
+                  << std::setprecision(0) << std::setw(8)
+                  << (result.first > 0 ? result.second / 1048576.0 / (result.first / 1000.0) : 0.0) << " MB/s\n";
+    };
+    report("JSON (wvalue + dump)", json);
+    report("MessagePack", msgpack);
+    std::cout << "\n   MessagePack: " << std::setprecision(1)
+              << (msgpack.first > 0 ? json.first / msgpack.first : 0.0) << "x mais rápido, "
+              << (json.second > 0 ? 100.0 * msgpack.second / json.second : 0.0) << "% do tamanho\n";
+    return 0;
+}
+
+void printUsage() {
+    std::cout << "Uso: cine_bench <suite> [opções]\n\n";
+    std::cout << "Suites:\n";
+    std::cout << "  logger [--threads N] [--seconds S] [--sample N]\n";
+    std::cout << "  als    [--users N] [--items N] [--per-user N] [--rank N] [--iterations N]\n";
+    std::cout << "         [--lambda X] [--threads N] [--explicit]\n";
+    std::cout << "  simd   [--dim N] [--k N]\n";
+    std::cout << "  hnsw   [--items N] [--dim N] [--queries N] [--M N] [--ef-construction N]\n";
+    std::cout << "         [--threads N] [--ip]\n";
+    std::cout << "  batch  [--users N] [--items N] [--per-user N] [--rank N] [--threads N]\n";
+    std::cout << "  ratings [--ratings N] [--threads N] [--batch N] [--delay-ms N] [--direct N]\n";
+    std::cout << "  msgpack [--items N] [--rounds N]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string suite = argv[1];
+    BenchOptions options = parseOptions(argc, argv, 2);
+
+    if (suite == "logger") return benchLogger(options);
+    if (suite == "als") return benchALS(options);
+    if (suite == "simd") return benchSimd(options);
+    if (suite == "hnsw") return benchHnsw(options);
+    if (suite == "batch") return benchBatch(options);
+    if (suite == "ratings") return benchRatings(options);
+    if (suite == "msgpack") return benchMsgpack(options);
+
+    printUsage();
+    return 1;
+}
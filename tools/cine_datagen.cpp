@@ -0,0 +1,492 @@
+// Gerador de dados sintéticos e importador MovieLens do Review Cine IA
+//
+// Uso: cine_datagen generate [--db arquivo.db] [--users N] [--movies N] [--per-user N]
+//                            [--zipf S] [--days N] [--seed N] [--batch N]
+//          Usuários, filmes com gêneros múltiplos e avaliações com popularidade Zipf
+//      cine_datagen movielens --dir pasta_ml [--db arquivo.db] [--batch N]
+//          Importa movies.csv e ratings.csv (MovieLens) lendo linha a linha
+//
+// Tudo é gravado em transações de --batch linhas (padrão 50000): o custo do
+// COMMIT é dividido pelo lote inteiro em vez de um fsync por linha.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "auth.h"
+#include "database.h"
+#include "logger.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// ===== OPÇÕES DE LINHA DE COMANDO =====
+struct GenOptions {
+    std::map<std::string, std::string> values;
+
+    int getInt(const std::string& key, int fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : std::atoi(it->second.c_str());
+    }
+
+    double getDouble(const std::string& key, double fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : std::atof(it->second.c_str());
+    }
+
+    std::string getString(const std::string& key, const std::string& fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : it->second;
+    }
+};
+
+GenOptions parseOptions(int argc, char** argv, int first) {
+    GenOptions options;
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            std::string key = arg.substr(2);
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) {
+                options.values[key] = argv[++i];
+            } else {
+                options.values[key] = "1";
+            }
+        }
+    }
+    return options;
+}
+
+// ===== ESCRITA EM LOTES =====
+// Abre uma transação a cada `batch_size` linhas e mede a vazão da fase.
+// Avaliações ficam num buffer gravado com Database::addRatingsBatch (um
+// único prepared statement) antes de cada COMMIT.
+class BatchWriter {
+public:
+    BatchWriter(Database& database, const char* phase_name, size_t batch)
+        : db(database), phase(phase_name), batch_size(std::max<size_t>(1, batch)),
+          pending(0), rows(0), failures(0), next_report(kReportEvery), started(Clock::now()) {
+        db.execute("BEGIN");
+    }
+
+    void row(bool ok) {
+        ok ? rows++ : failures++;
+        advance();
+    }
+
+    void rating(const RatingInput& input) {
+        ratings.push_back(input);
+        advance();
+    }
+
+    void finish() {
+        flushRatings();
+        db.execute("COMMIT");
+        report(true);
+    }
+
+private:
+    static constexpr size_t kReportEvery = 1000000;
+
+    Database& db;
+    const char* phase;
+    size_t batch_size;
+    size_t pending;
+    size_t rows;
+    size_t failures;
+    size_t next_report;
+    std::vector<RatingInput> ratings;
+    Clock::time_point started;
+
+    void advance() {
+        if (++pending < batch_size) return;
+        flushRatings();
+        db.execute("COMMIT");
+        db.execute("BEGIN");
+        pending = 0;
+        if (rows + failures >= next_report) {
+            report(false);
+            next_report += kReportEvery;
+        }
+    }
+
+    void flushRatings() {
+        if (ratings.empty()) return;
+        size_t saved = db.addRatingsBatch(ratings.data(), ratings.size());
+        rows += saved;
+        failures += ratings.size() - saved;
+        ratings.clear();
+    }
+
+    void report(bool done) {
+        double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+        double per_second = seconds > 0 ? rows / seconds : 0.0;
+        std::cout << (done ? "   ✅ " : "   … ") << std::left << std::setw(10) << phase << std::right
+                  << std::setw(11) << rows << " linhas em " << std::fixed << std::setprecision(2)
+                  << seconds << " s (" << std::setprecision(0) << per_second << " linhas/s, "
+                  << std::setprecision(2) << per_second * 60.0 / 1e6 << " mi/min)";
+        if (failures) std::cout << ", " << failures << " falhas";
+        std::cout << "\n" << std::flush;
+    }
+};
+
+// ===== GERADOR SINTÉTICO =====
+const char* kGenres[] = {
+    "Action", "Adventure", "Animation", "Biography", "Comedy", "Crime", "Documentary", "Drama",
+    "Family", "Fantasy", "History", "Horror", "Music", "Mystery", "Romance", "Sci-Fi",
+    "Thriller", "War", "Western"
+};
+// Frequência relativa de cada gênero (drama e comédia dominam como no IMDb)
+const double kGenreWeights[] = {
+    9, 6, 3, 2, 12, 6, 2, 18, 3, 3, 1.5, 4, 1.5, 3, 7, 3, 7, 1, 0.5
+};
+const char* kTitleFirst[] = {
+    "The Last", "A Silent", "The Hidden", "Broken", "Midnight", "The Lost", "Crimson", "The Final",
+    "Endless", "The Forgotten", "Wild", "The Secret", "Golden", "Dark", "The Great", "Electric"
+};
+const char* kTitleSecond[] = {
+    "Frontier", "Promise", "Kingdom", "River", "Empire", "Horizon", "Garden", "Station",
+    "Symphony", "Shadow", "Harbor", "Legacy", "Storm", "Summer", "Machine", "Road"
+};
+const char* kGenreWords[][4] = {
+    {"explosive", "chase", "mission", "revenge"}, {"journey", "quest", "island", "treasure"},
+    {"colorful", "talking", "magical", "friendship"}, {"true", "life", "legendary", "biography"},
+    {"hilarious", "awkward", "wedding", "roommates"}, {"heist", "detective", "gang", "murder"},
+    {"real", "interviews", "archive", "investigation"}, {"family", "grief", "struggle", "redemption"},
+    {"kids", "holiday", "dog", "adventure"}, {"dragon", "wizard", "enchanted", "prophecy"},
+    {"war", "empire", "revolution", "century"}, {"haunted", "demon", "curse", "nightmare"},
+    {"band", "concert", "singer", "rhythm"}, {"clue", "disappearance", "secret", "puzzle"},
+    {"love", "romance", "heart", "affair"}, {"space", "robot", "future", "alien"},
+    {"conspiracy", "hostage", "spy", "danger"}, {"soldier", "battle", "front", "platoon"},
+    {"cowboy", "outlaw", "sheriff", "frontier"}
+};
+
+// Amostragem Zipf por busca binária na CDF: a posição 1 é a mais popular
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double exponent) : cdf(n) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+            cdf[i] = sum;
+        }
+        for (auto& value : cdf) value /= sum;
+    }
+
+    size_t sample(std::mt19937_64& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    }
+
+private:
+    std::vector<double> cdf;
+};
+
+int generate(const GenOptions& options) {
+    std::string db_path = options.getString("db", "netflix.db");
+    const int users = options.getInt("users", 10000);
+    const int movies = options.getInt("movies", 5000);
+    const int per_user = options.getInt("per-user", 50);
+    const double zipf = options.getDouble("zipf", 1.0);
+    const int days = std::max(1, options.getInt("days", 365));
+    const size_t batch = static_cast<size_t>(options.getInt("batch", 50000));
+
+    Database db(db_path);
+    if (!db.init()) {
+        std::cerr << "❌ Não foi possível abrir " << db_path << "\n";
+        return 1;
+    }
+
+    std::mt19937_64 rng(static_cast<uint64_t>(options.getInt("seed", 42)));
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::discrete_distribution<int> pick_genre(std::begin(kGenreWeights), std::end(kGenreWeights));
+
+    std::cout << "🎲 Gerando " << users << " usuários, " << movies << " filmes e ~"
+              << static_cast<long long>(users) * per_user << " avaliações (Zipf s=" << zipf << ") em "
+              << db_path << "\n";
+
+    // Filmes: 1 a 3 gêneros em ordem alfabética, como no OMDB
+    std::vector<int> movie_ids;
+    std::vector<double> quality;
+    movie_ids.reserve(movies);
+    quality.reserve(movies);
+    {
+        BatchWriter writer(db, "filmes", batch);
+        for (int m = 0; m < movies; m++) {
+            std::vector<int> genres;
+            int count = 1 + static_cast<int>(rng() % 3);
+            while (static_cast<int>(genres.size()) < count) {
+                int genre = pick_genre(rng);
+                if (std::find(genres.begin(), genres.end(), genre) == genres.end()) genres.push_back(genre);
+            }
+            std::sort(genres.begin(), genres.end());
+
+            Movie movie;
+            movie.title = std::string(kTitleFirst[rng() % 16]) + " " + kTitleSecond[rng() % 16] +
+                          (m >= 256 ? " " + std::to_string(m / 256 + 1) : "");
+            char imdb_id[16];
+            std::snprintf(imdb_id, sizeof(imdb_id), "tt9%07d", m + 1);
+            movie.imdb_id = imdb_id;
+            for (size_t g = 0; g < genres.size(); g++) {
+                movie.genre += (g ? ", " : "") + std::string(kGenres[genres[g]]);
+                const char* const* words = kGenreWords[genres[g]];
+                movie.description += (g ? " " : "") + std::string("A ") + words[rng() % 4] + " story about " +
+                                     words[rng() % 4] + " and " + words[rng() % 4] + ".";
+            }
+            movie.actors = "Actor " + std::to_string(rng() % 2000) + ", Actor " + std::to_string(rng() % 2000);
+            movie.poster_url = "";
+            movie.year = 2024 - static_cast<int>(std::min(70.0, std::abs(normal(rng)) * 20.0));
+            double q = std::max(1.0, std::min(9.5, 6.4 + 1.1 * normal(rng)));
+            movie.imdb_rating = std::round(q * 10.0) / 10.0;
+            movie.rotten_tomatoes_rating = std::round(std::max(0.0, std::min(100.0, q * 11.0 - 5.0 + 8.0 * normal(rng))));
+
+            int id = db.createMovie(movie);
+            writer.row(id > 0);
+            if (id > 0) {
+                movie_ids.push_back(id);
+                quality.push_back(q);
+            }
+        }
+        writer.finish();
+    }
+    if (movie_ids.empty()) return 1;
+
+    // Usuários com a mesma senha (hash calculado uma vez só)
+    std::vector<int> user_ids;
+    user_ids.reserve(users);
+    {
+        std::string password_hash = Auth::hashPassword("senha123");
+        std::string prefix = "synthetic_" + std::to_string(static_cast<long long>(std::time(nullptr))) + "_";
+        BatchWriter writer(db, "usuários", batch);
+        for (int u = 0; u < users; u++) {
+            int id = db.createUser(prefix + std::to_string(u + 1), password_hash);
+            writer.row(id > 0);
+            if (id > 0) user_ids.push_back(id);
+        }
+        writer.finish();
+    }
+
+    // Avaliações: popularidade Zipf sobre uma permutação dos filmes (o mais
+    // popular não é sempre o primeiro inserido); nota = qualidade do filme +
+    // viés do usuário + ruído, na escala 0-10 do sistema
+    std::vector<size_t> popularity_order(movie_ids.size());
+    for (size_t i = 0; i < popularity_order.size(); i++) popularity_order[i] = i;
+    std::shuffle(popularity_order.begin(), popularity_order.end(), rng);
+    ZipfSampler sampler(movie_ids.size(), zipf);
+
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    std::exponential_distribution<double> age_days(3.0 / days);
+    std::geometric_distribution<int> extra_ratings(1.0 / std::max(1, per_user));
+    {
+        BatchWriter writer(db, "avaliações", batch);
+        std::unordered_set<size_t> rated;
+        for (int user_id : user_ids) {
+            double bias = 0.8 * normal(rng);
+            int count = std::min<int>(static_cast<int>(movie_ids.size()), 1 + extra_ratings(rng));
+            rated.clear();
+            for (int attempts = 0; static_cast<int>(rated.size()) < count && attempts < count * 20; attempts++) {
+                size_t movie = popularity_order[sampler.sample(rng)];
+                if (!rated.insert(movie).second) continue;
+
+                double rating = std::round(std::max(0.0, std::min(10.0, quality[movie] + bias + 1.5 * normal(rng))));
+                int64_t timestamp = now - static_cast<int64_t>(std::min<double>(days, age_days(rng)) * 86400.0);
+                writer.rating({user_id, movie_ids[movie], rating, timestamp});
+            }
+        }
+        writer.finish();
+    }
+    return 0;
+}
+
+// ===== IMPORTADOR MOVIELENS =====
+// Divide uma linha CSV respeitando campos entre aspas ("" = aspas literais)
+void splitCsv(const std::string& line, std::vector<std::string>& fields) {
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char ch = line[i];
+        if (quoted) {
+            if (ch == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (ch == '"') {
+                quoted = false;
+            } else {
+                field += ch;
+            }
+        } else if (ch == '"') {
+            quoted = true;
+        } else if (ch == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (ch != '\r') {
+            field += ch;
+        }
+    }
+    fields.push_back(field);
+}
+
+// "Toy Story (1995)" → título "Toy Story" e ano 1995
+void splitTitleYear(const std::string& text, std::string& title, int& year) {
+    title = text;
+    year = 0;
+    while (!title.empty() && title.back() == ' ') title.pop_back();
+    size_t open = title.rfind('(');
+    if (open != std::string::npos && title.size() - open == 6 && title.back() == ')') {
+        year = std::atoi(title.c_str() + open + 1);
+        title.erase(open);
+        while (!title.empty() && title.back() == ' ') title.pop_back();
+    }
+}
+
+// "Adventure|Children|Sci-Fi" → "Adventure, Family, Sci-Fi" (nomes do OMDB)
+std::string convertGenres(const std::string& genres) {
+    std::string result;
+    size_t begin = 0;
+    while (begin <= genres.size()) {
+        size_t end = genres.find('|', begin);
+        if (end == std::string::npos) end = genres.size();
+        std::string genre = genres.substr(begin, end - begin);
+        if (genre == "Children") genre = "Family";
+        if (!genre.empty() && genre != "IMAX" && genre != "(no genres listed)") {
+            result += (result.empty() ? "" : ", ") + genre;
+        }
+        begin = end + 1;
+    }
+    return result.empty() ? "N/A" : result;
+}
+
+int importMovieLens(const GenOptions& options) {
+    std::string dir = options.getString("dir", "");
+    std::string db_path = options.getString("db", "netflix.db");
+    const size_t batch = static_cast<size_t>(options.getInt("batch", 50000));
+    if (dir.empty()) {
+        std::cerr << "❌ Informe a pasta do MovieLens com --dir\n";
+        return 1;
+    }
+
+    std::ifstream movies_file(dir + "/movies.csv");
+    std::ifstream ratings_file(dir + "/ratings.csv");
+    if (!movies_file || !ratings_file) {
+        std::cerr << "❌ movies.csv ou ratings.csv não encontrados em " << dir << "\n";
+        return 1;
+    }
+
+    Database db(db_path);
+    if (!db.init()) {
+        std::cerr << "❌ Não foi possível abrir " << db_path << "\n";
+        return 1;
+    }
+    std::cout << "📥 Importando MovieLens de " << dir << " para " << db_path << "\n";
+
+    std::string line;
+    std::vector<std::string> fields;
+
+    // movieId do MovieLens → id no banco
+    std::unordered_map<int, int> movie_map;
+    {
+        BatchWriter writer(db, "filmes", batch);
+        std::getline(movies_file, line);  // cabeçalho
+        while (std::getline(movies_file, line)) {
+            splitCsv(line, fields);
+            if (fields.size() < 3) {
+                writer.row(false);
+                continue;
+            }
+
+            Movie movie;
+            splitTitleYear(fields[1], movie.title, movie.year);
+            movie.genre = convertGenres(fields[2]);
+            movie.imdb_rating = 0.0;
+            movie.rotten_tomatoes_rating = 0.0;
+            int id = db.createMovie(movie);
+            writer.row(id > 0);
+            if (id > 0) movie_map[std::atoi(fields[0].c_str())] = id;
+        }
+        writer.finish();
+    }
+
+    // userId do MovieLens → usuário criado sob demanda; notas 0.5-5 viram 1-10
+    std::unordered_map<int, int> user_map;
+    std::string password_hash = Auth::hashPassword("senha123");
+    {
+        BatchWriter writer(db, "avaliações", batch);
+        std::getline(ratings_file, line);  // cabeçalho
+        while (std::getline(ratings_file, line)) {
+            splitCsv(line, fields);
+            if (fields.size() < 4) {
+                writer.row(false);
+                continue;
+            }
+
+            auto movie = movie_map.find(std::atoi(fields[1].c_str()));
+            if (movie == movie_map.end()) {
+                writer.row(false);
+                continue;
+            }
+
+            int ml_user = std::atoi(fields[0].c_str());
+            auto user = user_map.find(ml_user);
+            if (user == user_map.end()) {
+                int id = db.createUser("ml_" + std::to_string(ml_user), password_hash);
+                if (id <= 0) {
+                    User* existing = db.getUserByUsername("ml_" + std::to_string(ml_user));
+                    id = existing ? existing->id : -1;
+                    delete existing;
+                }
+                user = user_map.emplace(ml_user, id).first;
+            }
+            if (user->second <= 0) {
+                writer.row(false);
+                continue;
+            }
+
+            double rating = std::atof(fields[2].c_str()) * 2.0;
+            writer.rating({user->second, movie->second, rating, std::atoll(fields[3].c_str())});
+        }
+        writer.finish();
+    }
+    std::cout << "   " << user_map.size() << " usuários, " << movie_map.size() << " filmes\n";
+    return 0;
+}
+
+void printUsage() {
+    std::cout << "Uso: cine_datagen <comando> [opções]\n\n";
+    std::cout << "Comandos:\n";
+    std::cout << "  generate  [--db arquivo.db] [--users N] [--movies N] [--per-user N]\n";
+    std::cout << "            [--zipf S] [--days N] [--seed N] [--batch N]\n";
+    std::cout << "  movielens --dir pasta_ml [--db arquivo.db] [--batch N]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    // Avisos de consulta lenta não fazem sentido durante a carga
+    Logger::instance().setLevel(LogLevel::Error);
+
+    std::string command = argv[1];
+    GenOptions options = parseOptions(argc, argv, 2);
+
+    if (command == "generate") return generate(options);
+    if (command == "movielens") return importMovieLens(options);
+
+    printUsage();
+    return 1;
+}
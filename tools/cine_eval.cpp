@@ -0,0 +1,427 @@
+// Avaliação offline dos recomendadores do Review Cine IA
+//
+// Uso: cine_eval [--db netflix.db] [--split loo|time] [--test-fraction X] [--k N]
+//                [--relevant X] [--min-ratings N] [--rank N] [--iterations N]
+//                [--only nome1,nome2]
+//
+// Separa as avaliações em treino/teste (leave-one-out: a avaliação mais recente
+// de cada usuário; time: as avaliações depois do corte temporal), treina os
+// modelos só com o treino e compara todos os recomendadores com as mesmas
+// métricas: precision/recall/NDCG@K, cobertura do catálogo e latência por usuário.
+// O banco original não é alterado: o treino é copiado para um banco em memória.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "als.h"
+#include "content_index.h"
+#include "database.h"
+#include "item_cf.h"
+#include "logger.h"
+#include "trending.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// ===== OPÇÕES DE LINHA DE COMANDO =====
+struct EvalOptions {
+    std::map<std::string, std::string> values;
+
+    int getInt(const std::string& key, int fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : std::atoi(it->second.c_str());
+    }
+
+    double getDouble(const std::string& key, double fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : std::atof(it->second.c_str());
+    }
+
+    std::string getString(const std::string& key, const std::string& fallback) const {
+        auto it = values.find(key);
+        return it == values.end() ? fallback : it->second;
+    }
+};
+
+EvalOptions parseOptions(int argc, char** argv) {
+    EvalOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            std::string key = arg.substr(2);
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0) {
+                options.values[key] = argv[++i];
+            } else {
+                options.values[key] = "1";
+            }
+        }
+    }
+    return options;
+}
+
+// "YYYY-MM-DD HH:MM:SS" (UTC, CURRENT_TIMESTAMP do SQLite) → unix epoch
+int64_t parseTimestamp(const std::string& text) {
+    std::tm tm = {};
+    if (std::sscanf(text.c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec) < 3) {
+        return 0;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+#ifdef _WIN32
+    return static_cast<int64_t>(_mkgmtime(&tm));
+#else
+    return static_cast<int64_t>(timegm(&tm));
+#endif
+}
+
+bool earlier(const Rating& a, const Rating& b) {
+    return a.timestamp != b.timestamp ? a.timestamp < b.timestamp : a.id < b.id;
+}
+
+// ===== DIVISÃO TREINO/TESTE =====
+struct Split {
+    std::vector<Rating> train;
+    std::vector<Rating> test;
+};
+
+// A avaliação mais recente de cada usuário com pelo menos `min_ratings`
+Split leaveOneOut(std::vector<Rating> ratings, int min_ratings) {
+    std::sort(ratings.begin(), ratings.end(), [](const Rating& a, const Rating& b) {
+        return a.user_id != b.user_id ? a.user_id < b.user_id : earlier(a, b);
+    });
+
+    Split split;
+    for (size_t begin = 0; begin < ratings.size();) {
+        size_t end = begin;
+        while (end < ratings.size() && ratings[end].user_id == ratings[begin].user_id) end++;
+
+        bool hold_out = static_cast<int>(end - begin) >= min_ratings;
+        for (size_t i = begin; i < end; i++) {
+            (hold_out && i + 1 == end ? split.test : split.train).push_back(ratings[i]);
+        }
+        begin = end;
+    }
+    return split;
+}
+
+// Corte global no tempo: a fração mais recente das avaliações vira teste
+Split temporalSplit(std::vector<Rating> ratings, double test_fraction) {
+    std::sort(ratings.begin(), ratings.end(), earlier);
+    size_t cutoff = static_cast<size_t>(ratings.size() * (1.0 - test_fraction));
+
+    Split split;
+    split.train.assign(ratings.begin(), ratings.begin() + cutoff);
+    split.test.assign(ratings.begin() + cutoff, ratings.end());
+    return split;
+}
+
+// Copia catálogo e avaliações para o banco em memória, preservando os IDs.
+// O original é anexado somente leitura (URI mode=ro): nada de init() nem
+// migrações nele, e os modelos e getRecommendations só enxergam a cópia.
+bool copySourceDatabase(Database& memory, const std::string& source_path) {
+    if (!memory.init()) return false;
+
+    std::string uri = "file:";
+    for (char ch : source_path) {
+        if (ch == '%' || ch == '?' || ch == '#') {
+            char encoded[4];
+            std::snprintf(encoded, sizeof(encoded), "%%%02X", static_cast<unsigned char>(ch));
+            uri += encoded;
+        } else {
+            uri += ch;
+            if (ch == '\'') uri += '\'';
+        }
+    }
+    uri += "?mode=ro";
+
+    return memory.execute("ATTACH DATABASE '" + uri + "' AS source") &&
+           memory.execute("BEGIN") &&
+           memory.execute("INSERT INTO movies (id, title, imdb_id, genre, description, actors, poster_url, "
+                          "imdb_rating, rotten_tomatoes_rating, year) SELECT id, title, imdb_id, genre, "
+                          "description, actors, poster_url, imdb_rating, rotten_tomatoes_rating, year FROM source.movies") &&
+           memory.execute("INSERT INTO ratings (id, user_id, movie_id, rating, timestamp) "
+                          "SELECT id, user_id, movie_id, rating, timestamp FROM source.ratings") &&
+           memory.execute("COMMIT") &&
+           memory.execute("DETACH DATABASE source");
+}
+
+// Deixa no banco em memória só as avaliações de treino, para que
+// getRecommendations não "veja" o teste
+bool removeTestRatings(Database& memory, const std::vector<Rating>& test) {
+    bool ok = memory.execute("BEGIN");
+    for (size_t begin = 0; ok && begin < test.size(); begin += 500) {
+        std::ostringstream sql;
+        sql << "DELETE FROM ratings WHERE id IN (";
+        for (size_t i = begin; i < std::min(test.size(), begin + 500); i++) {
+            sql << (i == begin ? "" : ",") << test[i].id;
+        }
+        sql << ")";
+        ok = memory.execute(sql.str());
+    }
+    return ok && memory.execute("COMMIT");
+}
+
+// ===== MÉTRICAS =====
+struct Recommender {
+    std::string name;
+    // (usuário, avaliações de treino do usuário, quantidade pedida) → IDs ordenados
+    std::function<std::vector<int>(int, const std::vector<Rating>&, size_t)> recommend;
+};
+
+struct EvalResult {
+    std::string name;
+    size_t users = 0;
+    double precision = 0.0;
+    double recall = 0.0;
+    double ndcg = 0.0;
+    double coverage = 0.0;
+    double p50_ms = 0.0;
+    double p99_ms = 0.0;
+};
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::min(values.size() - 1, index == 0 ? 0 : index - 1)];
+}
+
+EvalResult evaluate(const Recommender& recommender, const std::map<int, std::vector<Rating>>& train_by_user,
+                    const std::map<int, std::set<int>>& relevant_by_user, size_t k, size_t catalog_size) {
+    static const std::vector<Rating> kNoHistory;
+
+    EvalResult result;
+    result.name = recommender.name;
+    std::unordered_set<int> recommended_items;
+    std::vector<double> latencies_ms;
+
+    for (const auto& entry : relevant_by_user) {
+        int user_id = entry.first;
+        const std::set<int>& relevant = entry.second;
+        auto history_it = train_by_user.find(user_id);
+        const std::vector<Rating>& history = history_it == train_by_user.end() ? kNoHistory : history_it->second;
+
+        // Pede K + vistos e filtra aqui: recomendadores que não excluem os
+        // filmes já avaliados concorrem nas mesmas condições dos que excluem
+        auto started = Clock::now();
+        std::vector<int> items = recommender.recommend(user_id, history, k + history.size());
+        latencies_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - started).count());
+
+        std::unordered_set<int> seen;
+        for (const auto& rating : history) seen.insert(rating.movie_id);
+
+        size_t hits = 0;
+        double dcg = 0.0;
+        size_t rank = 0;
+        for (int item : items) {
+            if (rank == k) break;
+            if (seen.count(item)) continue;
+            recommended_items.insert(item);
+            if (relevant.count(item)) {
+                hits++;
+                dcg += 1.0 / std::log2(rank + 2.0);
+            }
+            rank++;
+        }
+
+        double ideal = 0.0;
+        for (size_t i = 0; i < std::min(k, relevant.size()); i++) ideal += 1.0 / std::log2(i + 2.0);
+
+        result.precision += static_cast<double>(hits) / k;
+        result.recall += static_cast<double>(hits) / relevant.size();
+        result.ndcg += ideal > 0 ? dcg / ideal : 0.0;
+        result.users++;
+    }
+
+    if (result.users > 0) {
+        result.precision /= result.users;
+        result.recall /= result.users;
+        result.ndcg /= result.users;
+    }
+    result.coverage = catalog_size ? static_cast<double>(recommended_items.size()) / catalog_size : 0.0;
+    result.p50_ms = percentile(latencies_ms, 0.50);
+    result.p99_ms = percentile(latencies_ms, 0.99);
+    return result;
+}
+
+std::vector<int> movieIds(const std::vector<ScoredMovie>& scored) {
+    std::vector<int> ids;
+    ids.reserve(scored.size());
+    for (const auto& item : scored) ids.push_back(item.movie_id);
+    return ids;
+}
+
+std::vector<int> movieIds(const std::vector<Movie>& movies) {
+    std::vector<int> ids;
+    ids.reserve(movies.size());
+    for (const auto& movie : movies) ids.push_back(movie.id);
+    return ids;
+}
+
+void printUsage() {
+    std::cout << "Uso: cine_eval [--db netflix.db] [--split loo|time] [--test-fraction X] [--k N]\n";
+    std::cout << "               [--relevant X] [--min-ratings N] [--rank N] [--iterations N]\n";
+    std::cout << "               [--only nome1,nome2]\n\n";
+    std::cout << "Recomendadores: genre_sql, imdb_top, popular, trending, item_cf, als, content\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    EvalOptions options = parseOptions(argc, argv);
+    if (options.values.count("help")) {
+        printUsage();
+        return 0;
+    }
+
+    std::string db_path = options.getString("db", "netflix.db");
+    std::string split_mode = options.getString("split", "loo");
+    const size_t k = static_cast<size_t>(std::max(1, options.getInt("k", 10)));
+    const double relevant_threshold = options.getDouble("relevant", 7.0);
+
+    std::set<std::string> only;
+    std::stringstream only_list(options.getString("only", ""));
+    for (std::string name; std::getline(only_list, name, ',');) {
+        if (!name.empty()) only.insert(name);
+    }
+
+    Logger::instance().setLevel(LogLevel::Error);
+
+    // Habilita URIs no ATTACH (mode=ro); sem isso o nome viraria um arquivo novo
+    if (sqlite3_config(SQLITE_CONFIG_URI, 1) != SQLITE_OK) {
+        std::cerr << "❌ SQLite sem suporte a URIs\n";
+        return 1;
+    }
+
+    Database training(":memory:");
+    if (!copySourceDatabase(training, db_path)) {
+        std::cerr << "❌ Não foi possível abrir " << db_path << "\n";
+        return 1;
+    }
+    std::vector<Rating> ratings = training.getAllRatings();
+    std::vector<Movie> movies = training.getAllMovies();
+
+    Split split;
+    if (split_mode == "time") {
+        split = temporalSplit(ratings, options.getDouble("test-fraction", 0.2));
+    } else if (split_mode == "loo") {
+        split = leaveOneOut(ratings, std::max(2, options.getInt("min-ratings", 2)));
+    } else {
+        printUsage();
+        return 1;
+    }
+
+    std::map<int, std::vector<Rating>> train_by_user;
+    for (const auto& rating : split.train) train_by_user[rating.user_id].push_back(rating);
+    std::map<int, std::set<int>> relevant_by_user;
+    for (const auto& rating : split.test) {
+        if (rating.rating >= relevant_threshold) relevant_by_user[rating.user_id].insert(rating.movie_id);
+    }
+
+    if (!removeTestRatings(training, split.test)) {
+        std::cerr << "❌ Não foi possível montar o banco de treino em memória\n";
+        return 1;
+    }
+
+    // ===== MODELOS (treinados só com o treino) =====
+    auto started = Clock::now();
+    RatingsMatrix matrix = RatingsMatrix::build(split.train);
+    ALSOptions als_options;
+    als_options.rank = options.getInt("rank", als_options.rank);
+    als_options.iterations = options.getInt("iterations", als_options.iterations);
+    std::shared_ptr<const ALSModel> als = ALSModel::train(matrix, als_options);
+    std::shared_ptr<const ItemCFModel> item_cf = ItemCFModel::train(matrix);
+    std::shared_ptr<const ContentIndex> content = ContentIndex::build(movies);
+    double training_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    // Popularidade e "em alta" no instante do fim do treino
+    std::vector<std::pair<size_t, int>> popularity;
+    for (size_t i = 0; i < matrix.itemCount(); i++) {
+        popularity.push_back({matrix.colEnd(static_cast<int>(i)) - matrix.colBegin(static_cast<int>(i)),
+                              matrix.itemId(static_cast<int>(i))});
+    }
+    std::sort(popularity.begin(), popularity.end(), std::greater<std::pair<size_t, int>>());
+
+    TrendingTracker trending;
+    int64_t train_end = 0;
+    for (const auto& rating : split.train) {
+        int64_t timestamp = parseTimestamp(rating.timestamp);
+        trending.record(rating.movie_id, timestamp);
+        train_end = std::max(train_end, timestamp);
+    }
+    trending.snapshot(train_end);
+    std::shared_ptr<const TrendingSnapshot> trending_24h = trending.latest("24h");
+
+    std::vector<Recommender> recommenders = {
+        {"genre_sql", [&](int user_id, const std::vector<Rating>&, size_t limit) {
+            return movieIds(training.getRecommendations(user_id, static_cast<int>(limit)));
+        }},
+        {"imdb_top", [&](int, const std::vector<Rating>&, size_t limit) {
+            // Caminho sem histórico de getRecommendations: maiores notas IMDb
+            return movieIds(training.getRecommendations(0, static_cast<int>(limit)));
+        }},
+        {"popular", [&](int, const std::vector<Rating>&, size_t limit) {
+            std::vector<int> ids;
+            for (size_t i = 0; i < popularity.size() && ids.size() < limit; i++) ids.push_back(popularity[i].second);
+            return ids;
+        }},
+        {"trending", [&](int, const std::vector<Rating>&, size_t limit) {
+            std::vector<int> ids = movieIds(trending_24h->movies);
+            if (ids.size() > limit) ids.resize(limit);
+            return ids;
+        }},
+        {"item_cf", [&](int, const std::vector<Rating>& history, size_t limit) {
+            return movieIds(item_cf->recommend(history, limit));
+        }},
+        {"als", [&](int, const std::vector<Rating>& history, size_t limit) {
+            return movieIds(als->recommend(history, limit));
+        }},
+        {"content", [&](int, const std::vector<Rating>& history, size_t limit) {
+            return movieIds(content->recommend(history, limit));
+        }},
+    };
+
+    std::cout << "📏 Avaliação offline (" << (split_mode == "time" ? "corte temporal" : "leave-one-out")
+              << ", K=" << k << ", relevante >= " << relevant_threshold << ")\n";
+    std::cout << "   " << split.train.size() << " avaliações de treino, " << split.test.size() << " de teste, "
+              << relevant_by_user.size() << " usuários avaliados, " << movies.size() << " filmes\n";
+    std::cout << "   modelos treinados em " << std::fixed << std::setprecision(2) << training_seconds << " s\n\n";
+
+    if (relevant_by_user.empty()) {
+        std::cout << "⚠️  Nenhum usuário com item relevante no teste; ajuste --relevant ou --split\n";
+        return 0;
+    }
+
+    std::cout << std::left << std::setw(11) << "modelo" << std::right
+              << std::setw(9) << "usuários" << std::setw(10) << "P@K" << std::setw(10) << "R@K"
+              << std::setw(10) << "NDCG@K" << std::setw(11) << "cobertura"
+              << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms" << "\n";
+    for (const auto& recommender : recommenders) {
+        if (!only.empty() && !only.count(recommender.name)) continue;
+
+        EvalResult result = evaluate(recommender, train_by_user, relevant_by_user, k, movies.size());
+        std::cout << std::left << std::setw(11) << result.name << std::right
+                  << std::setw(8) << result.users << std::setprecision(4)
+                  << std::setw(10) << result.precision << std::setw(10) << result.recall
+                  << std::setw(10) << result.ndcg << std::setw(11) << result.coverage
+                  << std::setprecision(3) << std::setw(11) << result.p50_ms
+                  << std::setw(11) << result.p99_ms << "\n";
+    }
+    return 0;
+}
@@ -52,9 +52,8 @@ async function initializeProfile() {
     setupEventListeners();
     checkAdminStatus(currentUser);
 
-    // 4. Carregar avaliações e contador
+    // 4. Resumo do perfil: usuário atualizado, avaliações e contador numa única chamada
     await loadRatedMovies();
-    await updateMoviesCount(); // ✅ CHAMADA DIRETA
 
     loadSavedProfile();
     console.log('✅ Profile inicializado');
@@ -64,77 +63,6 @@ async function initializeProfile() {
 // =======FUNÇÕES INTERNAS DO SISTEMA====
 // ======================================
 
-// 🎯 VERSÃO ULTRA SIMPLIFICADA
-// 🔥 OBTER QUANTIDADE DE FILMES AVALIADOS (CORRIGIDA)
-async function getRatedMoviesCount() {
-    try {
-        const userId = getCurrentUserId();
-        console.log('🔢 Buscando TOTAL de avaliações para usuário ID:', userId);
-
-        // ✅ USAR O ENDPOINT QUE RETORNA O TOTAL, NÃO APENAS OS RECENTES
-        const response = await fetch(`/api/user/${userId}/ratings/count`);
-
-        if (!response.ok) {
-            throw new Error(`Erro HTTP: ${response.status}`);
-        }
-
-        const data = await response.json();
-        console.log('📊 Resposta da API de contagem TOTAL:', data);
-
-        if (data.success) {
-            console.log('✅ Total de avaliações:', data.count);
-            return data.count;
-        } else {
-            throw new Error(data.error || 'Erro ao obter contagem total');
-        }
-    } catch (error) {
-        console.error('❌ Erro ao obter quantidade total de filmes:', error);
-
-        // ✅ FALLBACK: Se o endpoint de count não existir, usar o total de recent-ratings
-        try {
-            const fallbackResponse = await fetch(`/api/user/${getCurrentUserId()}/recent-ratings`);
-            const fallbackData = await fallbackResponse.json();
-            return fallbackData.count || 0;
-        } catch (fallbackError) {
-            return 0;
-        }
-    }
-}
-
-// 🔥 ATUALIZAR CONTADOR NA INTERFACE (CORRIGIDA)
-async function updateMoviesCount() {
-    try {
-        const count = await getRatedMoviesCount();
-
-        // ✅ AGUARDAR UM POUCO PARA GARANTIR QUE O DOM ESTÁ PRONTO
-        setTimeout(() => {
-            const moviesCountElement = document.getElementById('moviesCount');
-
-            console.log('🔍 Procurando elemento moviesCount:', moviesCountElement);
-            console.log('🎯 Quantidade obtida:', count);
-
-            if (moviesCountElement) {
-                moviesCountElement.textContent = `${count} FILMES AVALIADOS`;
-                console.log('✅ Contador atualizado com sucesso');
-            } else {
-                console.error('❌ Elemento moviesCount não encontrado no DOM');
-
-                // ✅ TENTAR NOVAMENTE APÓS MAIS TEMPO
-                setTimeout(() => {
-                    const retryElement = document.getElementById('moviesCount');
-                    if (retryElement) {
-                        retryElement.textContent = `${count} FILMES AVALIADOS`;
-                        console.log('✅ Contador atualizado na segunda tentativa');
-                    }
-                }, 500);
-            }
-        }, 200);
-
-    } catch (error) {
-        console.error('❌ Erro ao atualizar contador:', error);
-    }
-}
-
 // 🔥 FUNÇÃO PARA ATUALIZAR O NOME NA INTERFACE (CORRIGIDA)
 function updateUsernameDisplay(username) {
     console.log('👤 Atualizando display do usuário:', username);
@@ -198,27 +126,10 @@ async function checkUserLogin() {
                 const userData = JSON.parse(savedUser);
                 console.log('✅ Usuário encontrado no storage:', userData);
 
-                // BUSCAR DADOS ATUALIZADOS DO BANCO
-                const userInfo = await fetchUserFromDatabase(userData.id);
-
-                if (userInfo) {
-                    currentUser = userInfo;
-                    currentUserId = userInfo.id;
-                    console.log('✅ Usuário carregado do banco:', currentUser.username, 'ID:', currentUserId);
-
-                    // Atualizar storage
-                    if (localStorage.getItem('user')) {
-                        localStorage.setItem('user', JSON.stringify(currentUser));
-                    } else {
-                        sessionStorage.setItem('user', JSON.stringify(currentUser));
-                    }
-
-                    resolve(true);
-                } else {
-                    console.error('❌ Usuário não encontrado no banco');
-                    logoutUser();
-                    resolve(false);
-                }
+                // ✅ DADOS ATUALIZADOS DO BANCO CHEGAM COM O RESUMO (loadRatedMovies)
+                currentUser = userData;
+                currentUserId = userData.id;
+                resolve(true);
             } else {
                 console.log('⚠️ Usuário não logado, usando modo demo');
                 currentUser = {
@@ -238,26 +149,29 @@ async function checkUserLogin() {
     });
 }
 
-// 🔥 FUNÇÃO PARA BUSCAR USUÁRIO DO BANCO DE DADOS
-async function fetchUserFromDatabase(userId) {
-    try {
-        const response = await fetch(`/api/user/${userId}`);
-        const data = await response.json();
+// 🔥 APLICAR USUÁRIO DO BANCO (vem no resumo do perfil)
+function applyUserFromDatabase(user) {
+    // 🔥 GARANTIR QUE is_admin SEJA BOOLEAN
+    if (user.is_admin !== undefined) {
+        user.is_admin = Boolean(user.is_admin);
+    }
 
-        if (data.success) {
-            // 🔥 GARANTIR QUE is_admin SEJA BOOLEAN
-            const user = data.user;
-            if (user.is_admin !== undefined) {
-                user.is_admin = Boolean(user.is_admin);
-            }
-            return user;
-        } else {
-            console.error('Usuário não encontrado no banco:', data.error);
-            return null;
-        }
-    } catch (error) {
-        console.error('Erro ao buscar usuário do banco:', error);
-        return null;
+    const changed = !currentUser || currentUser.username !== user.username ||
+                    Boolean(currentUser.is_admin) !== user.is_admin;
+    currentUser = user;
+    currentUserId = user.id;
+    console.log('✅ Usuário carregado do banco:', currentUser.username, 'ID:', currentUserId);
+
+    // Atualizar storage
+    if (localStorage.getItem('user')) {
+        localStorage.setItem('user', JSON.stringify(currentUser));
+    } else if (sessionStorage.getItem('user')) {
+        sessionStorage.setItem('user', JSON.stringify(currentUser));
+    }
+
+    if (changed) {
+        updateUsernameDisplay(currentUser.username);
+        checkAdminStatus(currentUser);
     }
 }
 
@@ -367,24 +281,32 @@ async function loadRatedMovies() {
             return;
         }
 
-        const response = await fetch(`/api/user/${userId}/recent-ratings`);
+        // ✅ RESUMO DO PERFIL: RECENTES + TOTAL NUMA ÚNICA CHAMADA
+        const response = await fetch(`/api/user/${userId}/summary?recent=6&top=0`);
 
         if (!response.ok) {
             throw new Error(`Erro HTTP: ${response.status}`);
         }
 
         const data = await response.json();
-        console.log('📊 Dados das avaliações:', data);
+        console.log('📊 Resumo do perfil:', data);
+
+        if (data.user) {
+            applyUserFromDatabase(data.user);
+        } else if (!data.success && (localStorage.getItem('user') || sessionStorage.getItem('user'))) {
+            console.error('❌ Usuário não encontrado no banco');
+            logoutUser();
+            return;
+        }
 
         if (data.success && data.recent_ratings && data.recent_ratings.length > 0) {
-            // ✅ MOSTRAR APENAS OS 6 PRIMEIROS (MAIS RECENTES)
-            const recentMovies = data.recent_ratings.slice(0, 6);
-            console.log(`✅ ${recentMovies.length} filmes recentes de ${data.recent_ratings.length} totais`);
+            const recentMovies = data.recent_ratings;
+            console.log(`✅ ${recentMovies.length} filmes recentes de ${data.rating_count} totais`);
 
             displayRatedMovies(recentMovies);
 
-            // ✅ ATUALIZAR CONTADOR COM O TOTAL (não apenas os 6)
-            await updateMoviesCount();
+            // ✅ CONTADOR COM O TOTAL (não apenas os 6)
+            updateMoviesCountDisplay(data.rating_count);
         } else {
             console.log('📭 Nenhuma avaliação encontrada');
             showNoRatingsMessage();
@@ -487,27 +409,6 @@ function showErrorLoadingRatings() {
     }
 }
 
-// 🔥 ATUALIZAR CONTADOR NA INTERFACE
-async function updateMoviesCount() {
-    try {
-        // ✅ BUSCAR O TOTAL REAL DE AVALIAÇÕES
-        const totalCount = await getRatedMoviesCount();
-        const moviesCountElement = document.getElementById('moviesCount');
-
-        console.log('🔍 Procurando elemento moviesCount:', moviesCountElement);
-        console.log('🎯 Total de avaliações:', totalCount);
-
-        if (moviesCountElement) {
-            moviesCountElement.textContent = `${totalCount} FILMES AVALIADOS`;
-            console.log('✅ Contador atualizado com TOTAL:', totalCount);
-        } else {
-            console.error('❌ Elemento moviesCount não encontrado no DOM');
-        }
-    } catch (error) {
-        console.error('❌ Erro ao atualizar contador:', error);
-    }
-}
-
 // 🔥 FORMATAR DATA (MELHORADA)
 function formatDate(dateString) {
     try {
@@ -1056,8 +957,7 @@ function loadSavedProfile() {
 // Inicializar modal
 setupModal();
 
-// Carregar dados iniciais
-loadRatedMovies();
+// Carregar dados iniciais (avaliações vêm do initializeProfile)
 loadSavedProfile();
 
 // Elementos do DOM para funcionalidade admin